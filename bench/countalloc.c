@@ -0,0 +1,79 @@
+/*
+ * FILE: countalloc.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Counting allocator for the benchmarks (see countalloc.h). The wrappers
+ * forward to glibc's __libc_* entry points, so memory from either side can
+ * be freed by the other. free() is forwarded without counting.
+*/
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "countalloc.h"
+
+// glibc's own allocator, exported for malloc wrappers like these
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void  __libc_free(void *pointer);
+
+static atomic_ulong allocations;
+
+void *malloc(size_t size);
+void *calloc(size_t count, size_t size);
+void *realloc(void *pointer, size_t size);
+void *aligned_alloc(size_t alignment, size_t size);
+int   posix_memalign(void **pointer, size_t alignment, size_t size);
+void  free(void *pointer);
+
+/*
+ * FUNCTION: allocationCount
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Returns how many allocations every thread has made since the program started.
+ * PARAMETERS: n/a
+ * RETURNS : unsigned long - malloc, calloc, realloc and aligned allocation calls so far.
+ */
+unsigned long allocationCount(void) {
+    return atomic_load_explicit(&allocations, memory_order_relaxed);
+}
+
+void *malloc(size_t size) {
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) {
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **pointer, size_t alignment, size_t size) {
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    void *memory = __libc_memalign(alignment, size);
+    if (!memory) {
+        return ENOMEM;
+    }
+    *pointer = memory;
+    return 0;
+}
+
+void free(void *pointer) {
+    __libc_free(pointer);
+}
@@ -0,0 +1,276 @@
+/*
+ * FILE: fifo_bench.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * fifo_bench measures how many client records per second can be pushed
+ * through a named FIFO using the old open/write/close-per-message pattern
+ * and the persistent session pattern used by the client and server, and
+ * through the shared memory ring transport (client --shm, see shmring.h)
+ * with the same FIFO as its doorbell.
+ *
+ * USAGE: fifo_bench [record count]
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "shared.h"
+#include "shmring.h"
+
+#define BENCH_FIFO_PATH     "./bench_fifo"
+#define BENCH_DEFAULT_COUNT 100000
+#define BENCH_READ_SIZE     (64 * 1024)
+#define BENCH_RECORD        "Jane,Doe,42,123 Main Street, Springfield\n"
+
+double elapsedSeconds(const struct timespec *start, const struct timespec *end);
+pid_t  startReader(const char *fifoname, long expected);
+pid_t  startRingReader(const char *fifoname, long expected);
+double runBenchmark(const char *fifoname, long count, bool persistent);
+double runRingBenchmark(const char *fifoname, long count);
+
+int main(int argc, char *argv[]) {
+    long count = BENCH_DEFAULT_COUNT;
+    if (argc > 1 && (count = strtol(argv[1], NULL, 10)) <= 0) {
+        fprintf(stderr, "Usage: %s [record count]\n", argv[0]);
+        return ERROR;
+    }
+
+    if (mkfifo(BENCH_FIFO_PATH, PERM_OWNER_RW) == ERROR && errno != EEXIST) {
+        perror("Error creating benchmark FIFO");
+        return ERROR;
+    }
+
+    double perMessage = runBenchmark(BENCH_FIFO_PATH, count, false);
+    double session    = runBenchmark(BENCH_FIFO_PATH, count, true);
+    double ring       = runRingBenchmark(BENCH_FIFO_PATH, count);
+    unlink(BENCH_FIFO_PATH);
+
+    if (perMessage <= 0 || session <= 0 || ring <= 0) {
+        fprintf(stderr, "Benchmark failed\n");
+        return ERROR;
+    }
+
+    printf("FIFO benchmark (%ld records of %zu bytes)\n", count, strlen(BENCH_RECORD));
+    printf("  open/write/close per record : %12.0f records/s\n", count / perMessage);
+    printf("  persistent session          : %12.0f records/s\n", count / session);
+    printf("  shared memory ring          : %12.0f records/s\n", count / ring);
+    printf("  speedup (session)           : %12.1fx\n", perMessage / session);
+    printf("  speedup (ring vs session)   : %12.1fx\n", session / ring);
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: elapsedSeconds
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Returns the time between two CLOCK_MONOTONIC samples.
+ * PARAMETERS:
+    *  const struct timespec *start : Earlier sample.
+    *  const struct timespec *end : Later sample.
+ * RETURNS : double - elapsed time in seconds.
+ */
+double elapsedSeconds(const struct timespec *start, const struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec)
+         + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/*
+ * FUNCTION: startReader
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Forks a reader that behaves like the server: it keeps the FIFO open with
+    *  a dummy writer, reads it as a stream and exits once it has counted the
+    *  expected number of newline-terminated records.
+ * PARAMETERS:
+    *  const char *fifoname : FIFO to read from.
+    *  long expected : Number of records to wait for.
+ * RETURNS : pid_t - pid of the reader, or -1 on failure.
+ */
+pid_t startReader(const char *fifoname, long expected) {
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+
+    int fd      = open(fifoname, O_RDONLY | O_NONBLOCK);
+    int dummyFd = open(fifoname, O_WRONLY);
+    if (fd == -1 || dummyFd == -1) {
+        _exit(EXIT_FAILURE);
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+
+    char buffer[BENCH_READ_SIZE];
+    long received = 0;
+    while (received < expected) {
+        ssize_t bytesRead = read(fd, buffer, sizeof(buffer));
+        if (bytesRead <= 0) {
+            _exit(EXIT_FAILURE);
+        }
+        for (const char *p = buffer; (p = memchr(p, '\n', buffer + bytesRead - p)) != NULL; p++) {
+            received++;
+        }
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+/*
+ * FUNCTION: runBenchmark
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Sends count records to a fresh reader and times the run until the
+    *  reader has received all of them.
+ * PARAMETERS:
+    *  const char *fifoname : FIFO to write to.
+    *  long count : Number of records to send.
+    *  bool persistent : true to hold one descriptor for the whole run,
+    *                    false to open and close the FIFO per record.
+ * RETURNS : double - elapsed seconds, or -1 on failure.
+ */
+double runBenchmark(const char *fifoname, long count, bool persistent) {
+    pid_t reader = startReader(fifoname, count);
+    if (reader == -1) {
+        perror("Error starting reader");
+        return ERROR;
+    }
+
+    const size_t    recordLen = strlen(BENCH_RECORD);
+    struct timespec start, end;
+    int             fd = -1;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (long i = 0; i < count; i++) {
+        if (fd == -1 && (fd = open(fifoname, O_WRONLY)) == -1) {
+            perror("Error opening benchmark FIFO");
+            break;
+        }
+        if (write(fd, BENCH_RECORD, recordLen) != (ssize_t)recordLen) {
+            perror("Error writing benchmark FIFO");
+            break;
+        }
+        if (!persistent) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (fd != -1) {
+        close(fd);
+    }
+
+    int status = 0;
+    waitpid(reader, &status, 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        return ERROR;
+    }
+    return elapsedSeconds(&start, &end);
+}
+
+/*
+ * FUNCTION: startRingReader
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Forks a reader that behaves like the server with a --shm client: it
+    *  maps the ring of the parent, drains it, asks for a doorbell when it is
+    *  empty and then sleeps in read() on the FIFO until the doorbell comes.
+ * PARAMETERS:
+    *  const char *fifoname : FIFO carrying the doorbells.
+    *  long expected : Number of records to wait for.
+ * RETURNS : pid_t - pid of the reader, or -1 on failure.
+ */
+pid_t startRingReader(const char *fifoname, long expected) {
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+
+    ShmRing ring;
+    int     fd      = open(fifoname, O_RDONLY | O_NONBLOCK);
+    int     dummyFd = open(fifoname, O_WRONLY);
+    if (fd == -1 || dummyFd == -1 || shmRingAttach(&ring, (long)getppid()) == ERROR) {
+        _exit(EXIT_FAILURE);
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+
+    char        doorbells[BENCH_READ_SIZE];
+    long        received = 0;
+    size_t      length;
+    const char *record;
+    while (received < expected) {
+        while ((record = shmRingPeek(&ring, &length)) != NULL) {
+            received += memchr(record, '\n', length) != NULL;
+            shmRingRelease(&ring);
+        }
+        if (received < expected && shmRingSleep(&ring) && read(fd, doorbells, sizeof(doorbells)) <= 0) {
+            _exit(EXIT_FAILURE);
+        }
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+/*
+ * FUNCTION: runRingBenchmark
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Sends count records through a shared memory ring to a fresh reader,
+    *  writing a doorbell to the FIFO only when the reader asked for one, and
+    *  times the run until the reader has received all of them.
+ * PARAMETERS:
+    *  const char *fifoname : FIFO carrying the doorbells.
+    *  long count : Number of records to send.
+ * RETURNS : double - elapsed seconds, or -1 on failure.
+ */
+double runRingBenchmark(const char *fifoname, long count) {
+    ShmRing ring;
+    if (shmRingCreate(&ring, (long)getpid()) == ERROR) {
+        perror("Error creating benchmark ring");
+        return ERROR;
+    }
+    pid_t reader = startRingReader(fifoname, count);
+    if (reader == -1) {
+        perror("Error starting reader");
+        shmRingClose(&ring);
+        return ERROR;
+    }
+
+    const size_t    recordLen = strlen(BENCH_RECORD);
+    const char      doorbell  = SHM_RING_DOORBELL;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int fd = open(fifoname, O_WRONLY);
+    if (fd == -1) {
+        perror("Error opening benchmark FIFO");
+    }
+    for (long i = 0; fd != -1 && i < count; i++) {
+        ShmRingStatus status = shmRingPush(&ring, BENCH_RECORD, recordLen, SHM_RING_WAIT_MS);
+        if (status == SHM_RING_FULL) {
+            i--;   // Reader is still busy, try again
+        } else if (status == SHM_RING_WAKE && write(fd, &doorbell, sizeof(doorbell)) != 1) {
+            perror("Error writing benchmark FIFO");
+            break;
+        }
+    }
+    if (fd != -1) {
+        close(fd);
+    }
+
+    int status = 0;
+    waitpid(reader, &status, 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    shmRingClose(&ring);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        return ERROR;
+    }
+    return elapsedSeconds(&start, &end);
+}
@@ -0,0 +1,616 @@
+/*
+ * FILE: load_bench.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * load_bench measures a running server end to end. It forks N synthetic
+ * clients that register a session like bin/client does and send parties
+ * ("party", destination, client records, "END_PARTY") at a set rate and
+ * record size, in the text or the binary wire format. Every client record
+ * carries its client and sequence number in its address, and the parent
+ * tails the server's log until each record has been logged. It prints the
+ * throughput and the p50/p99/p999 latency from send to log entry as JSON,
+ * so runs can be compared across changes.
+ *
+ * With --rate the clients send on a fixed schedule and latency counts from
+ * the time a record was due, so a stalled server is not hidden by clients
+ * that stall with it. Without --rate they send as fast as the server takes
+ * records. Sessions are not acknowledged (no reply FIFO); run the server
+ * with its default append log (not --mmap-log) in the current directory.
+ *
+ * USAGE: load_bench [--clients N] [--records N] [--rate N] [--size BYTES]
+ *                   [--party N] [--wire] [--socket PATH | --tcp PORT]
+ *                   [--log PATH] [--timeout MS]
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "protocol.h"
+#include "shared.h"
+#include "transport.h"
+
+#define BENCH_DEFAULT_CLIENTS 4
+#define BENCH_DEFAULT_RECORDS 10000    // Client records per synthetic client
+#define BENCH_DEFAULT_SIZE    64       // Bytes of a client record as the server logs it
+#define BENCH_DEFAULT_PARTY   4        // Client records per party
+#define BENCH_DEFAULT_TIMEOUT 10000    // ms without a new log entry once every client is done
+#define BENCH_MAX_CLIENTS     1024
+#define BENCH_POLL_NS         200000   // Wait between reads of a log that has not grown
+#define BENCH_READ_SIZE       (64 * 1024)
+#define BENCH_FIRST_NAME      "Load"
+#define BENCH_LAST_NAME       "Bench"
+#define BENCH_AGE             30
+#define BENCH_DESTINATION     "Loadtown"
+#define BENCH_TAG             BENCH_FIRST_NAME "," BENCH_LAST_NAME ","
+#define NANOS_PER_SECOND      1000000000L
+
+typedef struct LoadOptions {
+    int              clients;
+    long             records;      // Per client
+    double           rate;         // Client records per second per client, 0 = unpaced
+    size_t           recordSize;
+    int              partySize;
+    bool             wire;         // Binary frames instead of text lines
+    TransportAddress transport;
+    const char      *logPath;
+    int              timeoutMs;
+} LoadOptions;
+
+// What the log has shown so far
+typedef struct LogTail {
+    int       fd;
+    char      buffer[BENCH_READ_SIZE];
+    size_t    length;      // Bytes of an unfinished line kept from the last read
+    uint64_t *loggedAt;    // Per record, 0 until logged
+    long      logged;
+    uint64_t  lastLogged;
+} LogTail;
+
+int      parseOptions(int argc, char *argv[], LoadOptions *options);
+uint64_t nowNanos(void);
+pid_t    startClient(const LoadOptions *options, int index, uint64_t *sentAt);
+int      connectSession(const LoadOptions *options, char *sessionPath);
+int      sendRecord(int fd, const char *record, size_t length, bool socket);
+size_t   encodeControl(const LoadOptions *options, char *out, size_t outSize, const char *text,
+                       WireMessageType type);
+size_t   encodeClient(const LoadOptions *options, char *out, size_t outSize, int index, long sequence);
+bool     readLog(LogTail *tail, const LoadOptions *options);
+void     markLogged(LogTail *tail, const LoadOptions *options, const char *line, uint64_t now);
+int      compareDoubles(const void *a, const void *b);
+double   percentile(const double *sorted, size_t count, double fraction);
+void     printResults(const LoadOptions *options, const uint64_t *sentAt, const LogTail *tail);
+
+int main(int argc, char *argv[]) {
+    LoadOptions options = {
+        .clients    = BENCH_DEFAULT_CLIENTS,
+        .records    = BENCH_DEFAULT_RECORDS,
+        .recordSize = BENCH_DEFAULT_SIZE,
+        .partySize  = BENCH_DEFAULT_PARTY,
+        .transport  = { .kind = TRANSPORT_FIFO },
+        .logPath    = LOG_FILE_PATH,
+        .timeoutMs  = BENCH_DEFAULT_TIMEOUT,
+    };
+    if (parseOptions(argc, argv, &options) == ERROR) {
+        fprintf(stderr, "Usage: %s [--clients N] [--records N] [--rate N] [--size BYTES] [--party N] [--wire]\n"
+                        "       [--socket PATH | --tcp PORT] [--log PATH] [--timeout MS]\n", argv[0]);
+        return ERROR;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    // Only entries written after this point count
+    LogTail tail = { .fd = open(options.logPath, O_RDONLY | O_CLOEXEC) };
+    if (tail.fd == -1 || lseek(tail.fd, 0, SEEK_END) == -1) {
+        perror("Error opening the server log (is the server running here?)");
+        return ERROR;
+    }
+
+    // Send times are written by the clients, so they live in shared memory
+    size_t    total  = (size_t)options.clients * (size_t)options.records;
+    uint64_t *sentAt = mmap(NULL, total * sizeof(uint64_t), PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    tail.loggedAt    = calloc(total, sizeof(uint64_t));
+    if (sentAt == MAP_FAILED || !tail.loggedAt) {
+        perror("Error allocating the latency tables");
+        return ERROR;
+    }
+
+    fprintf(stderr, "Starting %d clients of %ld records each\n", options.clients, options.records);
+    int running = 0;
+    for (int i = 0; i < options.clients; i++) {
+        if (startClient(&options, i, sentAt) == -1) {
+            perror("Error starting a client");
+            break;
+        }
+        running++;
+    }
+
+    // Follow the log until every record is in it, or it stops growing
+    // after the clients are done
+    int      failed    = 0;
+    uint64_t idleSince = nowNanos();
+    while (tail.logged < (long)total) {
+        if (readLog(&tail, &options)) {
+            idleSince = nowNanos();
+            continue;
+        }
+        int status;
+        while (running > 0 && waitpid(-1, &status, WNOHANG) > 0) {
+            running--;
+            failed += !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS;
+        }
+        if (running > 0) {
+            idleSince = nowNanos();
+        } else if (nowNanos() - idleSince > (uint64_t)options.timeoutMs * 1000000u) {
+            fprintf(stderr, "Gave up waiting for %ld records to be logged\n", (long)total - tail.logged);
+            break;
+        }
+        struct timespec pause = { .tv_nsec = BENCH_POLL_NS };
+        nanosleep(&pause, NULL);
+    }
+    while (running > 0 && wait(NULL) > 0) {
+        running--;
+    }
+    if (failed > 0) {
+        fprintf(stderr, "%d clients failed\n", failed);
+    }
+
+    printResults(&options, sentAt, &tail);
+    close(tail.fd);
+    return failed == 0 && tail.logged == (long)total ? SUCCESS : ERROR;
+}
+
+/*
+ * FUNCTION: parseOptions
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Reads the command line into options.
+ * PARAMETERS:
+    *  int argc : Argument count.
+    *  char *argv[] : Arguments.
+    *  LoadOptions *options : Defaults on entry, receives the options.
+ * RETURNS : int - SUCCESS, or ERROR on an unknown or invalid option.
+ */
+int parseOptions(int argc, char *argv[], LoadOptions *options) {
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        char       *end   = NULL;
+        if (strcmp(argv[i], "--wire") == SUCCESS) {
+            options->wire = true;
+            continue;
+        }
+        if (!value) {
+            return ERROR;
+        }
+        i++;
+        if (strcmp(argv[i - 1], "--clients") == SUCCESS) {
+            options->clients = (int)strtol(value, &end, 10);
+            if (options->clients <= 0 || options->clients > BENCH_MAX_CLIENTS) {
+                return ERROR;
+            }
+        } else if (strcmp(argv[i - 1], "--records") == SUCCESS) {
+            options->records = strtol(value, &end, 10);
+            if (options->records <= 0) {
+                return ERROR;
+            }
+        } else if (strcmp(argv[i - 1], "--rate") == SUCCESS) {
+            options->rate = strtod(value, &end);
+            if (options->rate < 0) {
+                return ERROR;
+            }
+        } else if (strcmp(argv[i - 1], "--size") == SUCCESS) {
+            options->recordSize = (size_t)strtoul(value, &end, 10);
+        } else if (strcmp(argv[i - 1], "--party") == SUCCESS) {
+            options->partySize = (int)strtol(value, &end, 10);
+            if (options->partySize <= 0) {
+                return ERROR;
+            }
+        } else if (strcmp(argv[i - 1], "--socket") == SUCCESS) {
+            options->transport.kind = TRANSPORT_UNIX;
+            options->transport.path = value;
+        } else if (strcmp(argv[i - 1], "--tcp") == SUCCESS) {
+            options->transport.kind = TRANSPORT_TCP;
+            if (transportParsePort(value, &options->transport.port) == ERROR) {
+                return ERROR;
+            }
+        } else if (strcmp(argv[i - 1], "--log") == SUCCESS) {
+            options->logPath = value;
+        } else if (strcmp(argv[i - 1], "--timeout") == SUCCESS) {
+            options->timeoutMs = (int)strtol(value, &end, 10);
+            if (options->timeoutMs <= 0) {
+                return ERROR;
+            }
+        } else {
+            return ERROR;
+        }
+        if (end && *end != '\0') {
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: nowNanos
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Reads CLOCK_MONOTONIC, which every process on the host shares.
+ * PARAMETERS: n/a
+ * RETURNS : uint64_t - nanoseconds since an arbitrary start.
+ */
+uint64_t nowNanos(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * NANOS_PER_SECOND + (uint64_t)now.tv_nsec;
+}
+
+/*
+ * FUNCTION: startClient
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Forks one synthetic client. It opens its own session, sends its
+    *  records in parties of options->partySize, storing the send time of
+    *  each client record in sentAt, and exits.
+ * PARAMETERS:
+    *  const LoadOptions *options : Load to generate.
+    *  int index : Client number, tags its records.
+    *  uint64_t *sentAt : Shared send times, options->records per client.
+ * RETURNS : pid_t - pid of the client, or -1 on failure.
+ */
+pid_t startClient(const LoadOptions *options, int index, uint64_t *sentAt) {
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+
+    char sessionPath[MAX_FIFO_PATH_LEN] = "";
+    int  fd = connectSession(options, sessionPath);
+    if (fd == -1) {
+        _exit(EXIT_FAILURE);
+    }
+    bool      socket = transportIsSocket(&options->transport);
+    uint64_t *sent   = sentAt + (size_t)index * (size_t)options->records;
+    uint64_t  start  = nowNanos();
+    char      record[WIRE_MAX_FRAME_SIZE];
+    size_t    length;
+    int       status = SUCCESS;
+
+    for (long sequence = 0; sequence < options->records && status == SUCCESS; sequence++) {
+        if (sequence % options->partySize == 0) {
+            length = encodeControl(options, record, sizeof(record), "party", WIRE_PARTY);
+            status = sendRecord(fd, record, length, socket);
+            length = encodeControl(options, record, sizeof(record), BENCH_DESTINATION, WIRE_DEST);
+            status = status == SUCCESS ? sendRecord(fd, record, length, socket) : status;
+        }
+
+        // A paced client sends on schedule and counts from when the record was due
+        length = encodeClient(options, record, sizeof(record), index, sequence);
+        if (options->rate > 0) {
+            uint64_t        due  = start + (uint64_t)((double)sequence * NANOS_PER_SECOND / options->rate);
+            struct timespec wake = { .tv_sec = (time_t)(due / NANOS_PER_SECOND),
+                                     .tv_nsec = (long)(due % NANOS_PER_SECOND) };
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) == EINTR) {
+            }
+            sent[sequence] = due;
+        } else {
+            sent[sequence] = nowNanos();
+        }
+        status = status == SUCCESS ? sendRecord(fd, record, length, socket) : status;
+
+        if (status == SUCCESS && ((sequence + 1) % options->partySize == 0 || sequence + 1 == options->records)) {
+            length = encodeControl(options, record, sizeof(record), "END_PARTY", WIRE_END);
+            status = sendRecord(fd, record, length, socket);
+        }
+    }
+
+    close(fd);
+    if (sessionPath[0] != '\0') {
+        unlink(sessionPath);   // The client owns its session FIFO
+    }
+    _exit(status == SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/*
+ * FUNCTION: connectSession
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Opens a session the way bin/client does, without a reply FIFO: over
+    *  the FIFOs it creates its session FIFO, sends the HELLO on the shared
+    *  FIFO and opens the session FIFO once the server has; over a socket it
+    *  connects and sends the HELLO first.
+ * PARAMETERS:
+    *  const LoadOptions *options : Transport and format to use.
+    *  char *sessionPath : Receives the session FIFO to remove, MAX_FIFO_PATH_LEN bytes.
+ * RETURNS : int - descriptor to send records on, or -1 on failure.
+ */
+int connectSession(const LoadOptions *options, char *sessionPath) {
+    char   hello[MAX_BUFFER_SIZE];
+    long   pid    = (long)getpid();
+    size_t length = options->wire ? wireEncodeHello(hello, sizeof(hello), pid, WIRE_NEW_SESSION, 0)
+                                  : (size_t)snprintf(hello, sizeof(hello), "session %ld\n", pid);
+
+    if (transportIsSocket(&options->transport)) {
+        int fd = transportConnect(&options->transport, options->timeoutMs);
+        if (fd == -1 || sendRecord(fd, hello, length, true) == ERROR) {
+            perror("Error connecting to the server");
+            return -1;
+        }
+        return fd;
+    }
+
+    if (sessionFifoPath(sessionPath, MAX_FIFO_PATH_LEN, pid) == ERROR
+        || (mkfifo(sessionPath, PERM_OWNER_RW) == ERROR && errno != EEXIST)) {
+        perror("Error creating session FIFO");
+        return -1;
+    }
+    int sharedFd = open(FIFO_PATH, O_WRONLY);
+    if (sharedFd == -1 || write(sharedFd, hello, length) != (ssize_t)length) {
+        perror("Error registering the session");
+        return -1;
+    }
+    close(sharedFd);
+    int fd = open(sessionPath, O_WRONLY);   // Blocks until the server opens it
+    if (fd == -1) {
+        perror("Error opening session FIFO");
+    }
+    return fd;
+}
+
+/*
+ * FUNCTION: sendRecord
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Writes one record. On a socket the server's acknowledgements are
+    *  read and dropped first so they never fill the connection.
+ * PARAMETERS:
+    *  int fd : Session descriptor.
+    *  const char *record : Record to write.
+    *  size_t length : Bytes in record.
+    *  bool socket : fd is a connection.
+ * RETURNS : int - SUCCESS, or ERROR if the session failed.
+ */
+int sendRecord(int fd, const char *record, size_t length, bool socket) {
+    char acks[BENCH_READ_SIZE];
+    while (socket && recv(fd, acks, sizeof(acks), MSG_DONTWAIT) > 0) {
+    }
+    while (length > 0) {
+        ssize_t written = write(fd, record, length);
+        if (written == -1 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            perror("Error writing to the session");
+            return ERROR;
+        }
+        record += written;
+        length -= (size_t)written;
+    }
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: encodeControl
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Encodes a party start, destination or party end in the chosen format.
+ * PARAMETERS:
+    *  const LoadOptions *options : Format to use.
+    *  char *out : Receives the record.
+    *  size_t outSize : Size of out.
+    *  const char *text : Text line, or the destination for WIRE_DEST.
+    *  WireMessageType type : Frame type in the wire format.
+ * RETURNS : size_t - length of the record.
+ */
+size_t encodeControl(const LoadOptions *options, char *out, size_t outSize, const char *text,
+                     WireMessageType type) {
+    if (!options->wire) {
+        return (size_t)snprintf(out, outSize, "%s\n", text);
+    }
+    if (type != WIRE_DEST) {
+        return wireEncodeControl(out, outSize, type);
+    }
+    Trip trip = { 0 };
+    snprintf(trip.destination, sizeof(trip.destination), "%s", text);
+    return wireEncodeDestination(out, outSize, &trip);
+}
+
+/*
+ * FUNCTION: encodeClient
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Encodes one client record whose address starts with
+    *  "<client>-<sequence>" and is padded so the logged record is about
+    *  options->recordSize bytes.
+ * PARAMETERS:
+    *  const LoadOptions *options : Format and record size.
+    *  char *out : Receives the record.
+    *  size_t outSize : Size of out.
+    *  int index : Client number.
+    *  long sequence : Record number of the client.
+ * RETURNS : size_t - length of the record.
+ */
+size_t encodeClient(const LoadOptions *options, char *out, size_t outSize, int index, long sequence) {
+    Client client = { .firstName = BENCH_FIRST_NAME, .lastName = BENCH_LAST_NAME, .age = BENCH_AGE };
+    int    length = snprintf(client.address, sizeof(client.address), "%d-%ld Bench Road", index, sequence);
+    size_t fixed  = strlen(BENCH_TAG) + strlen("30,");
+    while ((size_t)length + fixed < options->recordSize && length < MAX_ADDRESS_LEN - 1) {
+        client.address[length++] = 'x';
+    }
+    client.address[length] = '\0';
+
+    if (options->wire) {
+        return wireEncodeClient(out, outSize, &client);
+    }
+    return (size_t)snprintf(out, outSize, "%s,%s,%d,%s\n", client.firstName, client.lastName, client.age,
+                            client.address);
+}
+
+/*
+ * FUNCTION: readLog
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Reads what the server has added to its log and marks the records in it as logged.
+ * PARAMETERS:
+    *  LogTail *tail : Log being followed.
+    *  const LoadOptions *options : Load being measured.
+ * RETURNS : bool - true if the log had grown.
+ */
+bool readLog(LogTail *tail, const LoadOptions *options) {
+    ssize_t bytesRead = read(tail->fd, tail->buffer + tail->length, sizeof(tail->buffer) - tail->length);
+    if (bytesRead <= 0) {
+        return false;
+    }
+    uint64_t now   = nowNanos();
+    char    *line  = tail->buffer;
+    char    *end   = tail->buffer + tail->length + bytesRead;
+    char    *found;
+    while ((found = memchr(line, '\n', (size_t)(end - line))) != NULL) {
+        *found = '\0';
+        markLogged(tail, options, line, now);
+        line = found + 1;
+    }
+
+    // Keep an unfinished line for the next read; one that fills the buffer is not ours
+    tail->length = (size_t)(end - line);
+    if (tail->length == sizeof(tail->buffer)) {
+        tail->length = 0;
+    }
+    memmove(tail->buffer, line, tail->length);
+    return true;
+}
+
+/*
+ * FUNCTION: markLogged
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Records when a log line was seen if it is one of the generated client records.
+ * PARAMETERS:
+    *  LogTail *tail : Log being followed.
+    *  const LoadOptions *options : Load being measured.
+    *  const char *line : Log line without its newline.
+    *  uint64_t now : Time the line was read.
+ * RETURNS : n/a
+ */
+void markLogged(LogTail *tail, const LoadOptions *options, const char *line, uint64_t now) {
+    const char *record = strstr(line, "] " BENCH_TAG);
+    const char *address;
+    int         index;
+    long        sequence;
+    if (!record || !(address = strchr(record + strlen("] " BENCH_TAG), ','))
+        || sscanf(address + 1, "%d-%ld", &index, &sequence) != 2
+        || index < 0 || index >= options->clients || sequence < 0 || sequence >= options->records) {
+        return;
+    }
+    uint64_t *loggedAt = &tail->loggedAt[(size_t)index * (size_t)options->records + (size_t)sequence];
+    if (*loggedAt == 0) {
+        *loggedAt        = now;
+        tail->lastLogged = now;
+        tail->logged++;
+    }
+}
+
+/*
+ * FUNCTION: compareDoubles
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: qsort() comparator for ascending doubles.
+ * PARAMETERS:
+    *  const void *a : First value.
+    *  const void *b : Second value.
+ * RETURNS : int - negative, zero or positive as a is less than, equal to or greater than b.
+ */
+int compareDoubles(const void *a, const void *b) {
+    double left  = *(const double *)a;
+    double right = *(const double *)b;
+    return (left > right) - (left < right);
+}
+
+/*
+ * FUNCTION: percentile
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Nearest-rank percentile of sorted samples.
+ * PARAMETERS:
+    *  const double *sorted : Samples in ascending order.
+    *  size_t count : Number of samples.
+    *  double fraction : Percentile as a fraction, 0.99 for p99.
+ * RETURNS : double - the sample at that rank, 0 without samples.
+ */
+double percentile(const double *sorted, size_t count, double fraction) {
+    if (count == 0) {
+        return 0;
+    }
+    double exact = fraction * (double)count;
+    size_t rank  = (size_t)exact;
+    if ((double)rank < exact) {
+        rank++;
+    }
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+/*
+ * FUNCTION: printResults
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Prints the run as one JSON object: the load, the records logged, the
+    *  throughput from the first send to the last log entry and the latency
+    *  percentiles in microseconds.
+ * PARAMETERS:
+    *  const LoadOptions *options : Load that was generated.
+    *  const uint64_t *sentAt : Send time of every record, 0 if never sent.
+    *  const LogTail *tail : Log times of every record.
+ * RETURNS : n/a
+ */
+void printResults(const LoadOptions *options, const uint64_t *sentAt, const LogTail *tail) {
+    size_t   total     = (size_t)options->clients * (size_t)options->records;
+    double  *latencies = malloc((total > 0 ? total : 1) * sizeof(double));
+    size_t   count     = 0;
+    size_t   sent      = 0;
+    uint64_t firstSent = UINT64_MAX;
+    double   sum       = 0;
+    for (size_t i = 0; i < total; i++) {
+        if (sentAt[i] == 0) {
+            continue;
+        }
+        sent++;
+        firstSent = sentAt[i] < firstSent ? sentAt[i] : firstSent;
+        if (latencies && tail->loggedAt[i] != 0) {
+            double latency = tail->loggedAt[i] > sentAt[i] ? (double)(tail->loggedAt[i] - sentAt[i]) / 1e3 : 0;
+            latencies[count++] = latency;
+            sum += latency;
+        }
+    }
+    if (latencies) {
+        qsort(latencies, count, sizeof(double), compareDoubles);
+    }
+    double seconds = count > 0 && tail->lastLogged > firstSent ? (double)(tail->lastLogged - firstSent) / 1e9 : 0;
+
+    const char *transports[] = { [TRANSPORT_FIFO] = "fifo", [TRANSPORT_SHM] = "shm",
+                                 [TRANSPORT_UNIX] = "unix", [TRANSPORT_TCP] = "tcp" };
+    printf("{\n");
+    printf("  \"benchmark\": \"load\",\n");
+    printf("  \"transport\": \"%s\",\n", transports[options->transport.kind]);
+    printf("  \"format\": \"%s\",\n", options->wire ? "wire" : "text");
+    printf("  \"clients\": %d,\n", options->clients);
+    printf("  \"recordsPerClient\": %ld,\n", options->records);
+    printf("  \"recordSize\": %zu,\n", options->recordSize);
+    printf("  \"partySize\": %d,\n", options->partySize);
+    printf("  \"ratePerClient\": %.1f,\n", options->rate);
+    printf("  \"sent\": %zu,\n", sent);
+    printf("  \"logged\": %zu,\n", count);
+    printf("  \"seconds\": %.6f,\n", seconds);
+    printf("  \"throughput\": %.1f,\n", seconds > 0 ? (double)count / seconds : 0.0);
+    printf("  \"latencyUs\": {\"mean\": %.1f, \"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f}\n",
+           count > 0 ? sum / (double)count : 0.0, percentile(latencies, count, 0.50),
+           percentile(latencies, count, 0.99), percentile(latencies, count, 0.999),
+           count > 0 ? latencies[count - 1] : 0.0);
+    printf("}\n");
+    free(latencies);
+}
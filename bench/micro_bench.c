@@ -0,0 +1,532 @@
+/*
+ * FILE: micro_bench.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * micro_bench times the per-record helpers of the client and server one
+ * at a time, in a tight loop over a small corpus of valid inputs:
+ *   - client: isNullTerminated(), stringMatchesRegex() on a literal and a
+ *     regex pattern, convertToInt(), splitClientName(), clientToString()
+ *     (clientinput.c; its result is freed in the loop, as the client did),
+ *     formatClientRecord()
+ *   - server: textDecodeClient(), the text client record parser
+ *     (protocol.c), and loggerLog(), which the server's writeToLog()
+ *     forwards each log line to, timed until the writer thread has
+ *     written the lines out
+ * For every helper it prints ns/op and allocations/op (countalloc.c), and
+ * cycles/op and cache misses/op of the calling thread from perf_event_open()
+ * when the kernel allows it. The writer thread's cycles are not counted.
+ * micro_bench fails if a helper marked allocation-free makes any
+ * allocation. The send path as a whole is checked by
+ * test/send_alloc_test.c.
+ *
+ * USAGE: micro_bench [iterations]
+*/
+
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "clientinput.h"
+#include "countalloc.h"
+#include "logger.h"
+#include "pattern.h"
+#include "protocol.h"
+#include "shared.h"
+#include "validate.h"
+
+#define BENCH_DEFAULT_COUNT 1000000
+#define BENCH_LOG_DIVISOR   10   // The logger writes every line to disk, so it gets fewer iterations
+#define BENCH_CORPUS_SIZE   8    // Inputs cycled through, a power of two
+#define BENCH_LOG_TEMPLATE  "/tmp/micro_bench_XXXXXX"
+
+// Hardware counters of the calling thread, -1 where perf_event_open() failed
+typedef struct PerfCounters {
+    int cyclesFd;
+    int missesFd;
+} PerfCounters;
+
+// What one helper cost
+typedef struct BenchResult {
+    double   seconds;
+    uint64_t allocations;
+    uint64_t cycles;
+    uint64_t misses;
+} BenchResult;
+
+// Runs a helper count times
+typedef void (*BenchBody)(long count);
+
+typedef struct MicroBench {
+    const char *name;
+    BenchBody   body;
+    long        divisor;          // Iterations are count / divisor
+    bool        allocationFree;   // Any allocation fails the benchmark
+} MicroBench;
+
+double   elapsedSeconds(const struct timespec *start, const struct timespec *end);
+int      openCounter(uint64_t config);
+void     perfOpen(PerfCounters *counters);
+void     perfClose(PerfCounters *counters);
+void     perfStart(const PerfCounters *counters);
+uint64_t perfRead(int fd);
+bool     buildCorpus(void);
+BenchResult runBench(const MicroBench *bench, long count, const PerfCounters *counters);
+void     printResult(const char *name, long count, const BenchResult *result, const PerfCounters *counters);
+
+void benchIsNullTerminated(long count);
+void benchMatchLiteral(long count);
+void benchMatchRegex(long count);
+void benchConvertToInt(long count);
+void benchSplitClientName(long count);
+void benchClientToString(long count);
+void benchFormatClientRecord(long count);
+void benchTextDecodeClient(long count);
+void benchWriteToLog(long count);
+
+// Inputs, built once by buildCorpus()
+static char           names[BENCH_CORPUS_SIZE][MAX_NAME_LEN];
+static NameSplit      splits[BENCH_CORPUS_SIZE];
+static char           ages[BENCH_CORPUS_SIZE][BUFFER_SIZE_OF_FOUR];
+static Client         clients[BENCH_CORPUS_SIZE];
+static char           records[BENCH_CORPUS_SIZE][MAX_BUFFER_SIZE];
+static const Pattern *literalPattern;
+static const Pattern *namePattern;
+static Logger         logger;
+
+// Results are folded in here so the loops cannot be optimised away
+static volatile unsigned long benchSink;
+
+int main(int argc, char *argv[]) {
+    long count = BENCH_DEFAULT_COUNT;
+    if (argc > 1 && (count = strtol(argv[1], NULL, 10)) < BENCH_LOG_DIVISOR) {
+        fprintf(stderr, "Usage: %s [iterations, at least %d]\n", argv[0], BENCH_LOG_DIVISOR);
+        return ERROR;
+    }
+
+    char logPath[] = BENCH_LOG_TEMPLATE;
+    int  logFd     = mkstemp(logPath);
+    if (logFd < 0) {
+        perror("Error creating the benchmark log");
+        return ERROR;
+    }
+    close(logFd);
+    if (!buildCorpus() || loggerStart(&logger, logPath, LOG_BACKEND_APPEND, 0) != SUCCESS) {
+        fprintf(stderr, "Benchmark setup failed\n");
+        unlink(logPath);
+        return ERROR;
+    }
+
+    const MicroBench benches[] = {
+        {"isNullTerminated",           benchIsNullTerminated,   1,                 false},
+        {"stringMatchesRegex literal", benchMatchLiteral,       1,                 false},
+        {"stringMatchesRegex regex",   benchMatchRegex,         1,                 false},
+        {"convertToInt",               benchConvertToInt,       1,                 false},
+        {"splitClientName",            benchSplitClientName,    1,                 false},
+        {"clientToString",             benchClientToString,     1,                 false},
+        {"formatClientRecord",         benchFormatClientRecord, 1,                 true},
+        {"textDecodeClient",           benchTextDecodeClient,   1,                 false},
+        {"writeToLog",                 benchWriteToLog,         BENCH_LOG_DIVISOR, false},
+    };
+    PerfCounters counters;
+    int          status = SUCCESS;
+    perfOpen(&counters);
+
+    printf("Micro benchmark (%ld iterations, writeToLog %ld)\n", count, count / BENCH_LOG_DIVISOR);
+    printf("  %-28s %9s %10s %10s %10s\n", "function", "ns/op", "allocs/op", "cycles/op", "misses/op");
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        long        iterations = count / benches[i].divisor;
+        BenchResult result     = runBench(&benches[i], iterations, &counters);
+        printResult(benches[i].name, iterations, &result, &counters);
+        if (benches[i].allocationFree && result.allocations > 0) {
+            printf("  FAIL: %s made %lu allocations and must make none\n", benches[i].name,
+                   (unsigned long)result.allocations);
+            status = ERROR;
+        }
+    }
+
+    loggerStop(&logger);
+    LoggerStats stats = loggerGetStats(&logger);
+    printf("  writeToLog: %lu lines written, %lu dropped on a full queue\n", stats.logged, stats.dropped);
+    if (counters.cyclesFd < 0) {
+        printf("  cycles and cache misses: perf_event_open() is not available\n");
+    }
+
+    perfClose(&counters);
+    unlink(logPath);
+    patternRegistryFree();
+    return status;
+}
+
+/*
+ * FUNCTION: elapsedSeconds
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Returns the time between two CLOCK_MONOTONIC samples.
+ * PARAMETERS:
+    *  const struct timespec *start : Earlier sample.
+    *  const struct timespec *end : Later sample.
+ * RETURNS : double - elapsed time in seconds.
+ */
+double elapsedSeconds(const struct timespec *start, const struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec)
+         + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/*
+ * FUNCTION: openCounter
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Opens a disabled hardware counter for the calling thread. Only user
+    *  space is counted, which an unprivileged process may do while
+    *  perf_event_paranoid is 2 or less.
+ * PARAMETERS:
+    *  uint64_t config : PERF_COUNT_HW_* event.
+ * RETURNS : int - counter descriptor, or -1 if the event is not available.
+ */
+int openCounter(uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.size           = sizeof(attr);
+    attr.config         = config;
+    attr.disabled       = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/*
+ * FUNCTION: perfOpen
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Opens the cycle and cache miss counters; both are -1 unless both opened.
+ * PARAMETERS:
+    *  PerfCounters *counters : Counters to open.
+ * RETURNS : n/a
+ */
+void perfOpen(PerfCounters *counters) {
+    counters->cyclesFd = openCounter(PERF_COUNT_HW_CPU_CYCLES);
+    counters->missesFd = openCounter(PERF_COUNT_HW_CACHE_MISSES);
+    if (counters->cyclesFd < 0 || counters->missesFd < 0) {
+        perfClose(counters);
+    }
+}
+
+/*
+ * FUNCTION: perfClose
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Closes the counters that are open.
+ * PARAMETERS:
+    *  PerfCounters *counters : Counters to close.
+ * RETURNS : n/a
+ */
+void perfClose(PerfCounters *counters) {
+    if (counters->cyclesFd >= 0) {
+        close(counters->cyclesFd);
+    }
+    if (counters->missesFd >= 0) {
+        close(counters->missesFd);
+    }
+    counters->cyclesFd = -1;
+    counters->missesFd = -1;
+}
+
+/*
+ * FUNCTION: perfStart
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Zeroes and enables the counters, if they are open.
+ * PARAMETERS:
+    *  const PerfCounters *counters : Counters to start.
+ * RETURNS : n/a
+ */
+void perfStart(const PerfCounters *counters) {
+    if (counters->cyclesFd < 0) {
+        return;
+    }
+    ioctl(counters->cyclesFd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(counters->missesFd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(counters->cyclesFd, PERF_EVENT_IOC_ENABLE, 0);
+    ioctl(counters->missesFd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+/*
+ * FUNCTION: perfRead
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Disables a counter and reads it.
+ * PARAMETERS:
+    *  int fd : Counter descriptor, or -1.
+ * RETURNS : uint64_t - events counted since perfStart(), 0 if the counter is not open.
+ */
+uint64_t perfRead(int fd) {
+    uint64_t value = 0;
+    if (fd < 0) {
+        return 0;
+    }
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &value, sizeof(value)) != (ssize_t)sizeof(value)) {
+        return 0;
+    }
+    return value;
+}
+
+/*
+ * FUNCTION: buildCorpus
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Fills the corpus with valid names, ages, clients and text records, and
+    *  compiles the patterns. Names are split in advance so splitClientName()
+    *  is timed on its own.
+ * PARAMETERS: n/a
+ * RETURNS : bool - true if every name scanned and both patterns compiled.
+ */
+bool buildCorpus(void) {
+    static const char *const firstNames[] = {"Jane", "John", "Ann", "Bartholomew", "Li", "Maximilian", "Eve", "Tom"};
+    static const char *const lastNames[]  = {"Doe", "Smith", "Lee", "Featherstonehaugh", "O", "Nguyen", "Park", "Ray"};
+    static const char *const addresses[]  = {"12 Main St", "4 King Street West, Apt 9", "1 Elm Road",
+                                             "299 Doon Valley Drive, Kitchener", "7 Bay St", "88 Queen Street",
+                                             "5 Lakeshore Boulevard, Unit 1204", "31 Pine Crescent"};
+
+    for (int i = 0; i < BENCH_CORPUS_SIZE; i++) {
+        Client *client = &clients[i];
+        snprintf(names[i], MAX_NAME_LEN, "%s %s", firstNames[i], lastNames[i]);
+        if (!scanClientName(names[i], strlen(names[i]), &splits[i])) {
+            return false;
+        }
+        snprintf(ages[i], sizeof(ages[i]), "%d", MIN_CLIENT_AGE + i * 13);
+        snprintf(client->firstName, sizeof(client->firstName), "%s", firstNames[i]);
+        snprintf(client->lastName, sizeof(client->lastName), "%s", lastNames[i]);
+        snprintf(client->address, sizeof(client->address), "%s", addresses[i]);
+        client->age = MIN_CLIENT_AGE + i * 13;
+        snprintf(records[i], MAX_BUFFER_SIZE, "%s,%s,%d,%s", firstNames[i], lastNames[i], client->age,
+                 addresses[i]);
+    }
+
+    literalPattern = patternCompile("^party$");
+    namePattern    = patternCompile(REGEX_NAME);
+    return literalPattern && namePattern;
+}
+
+/*
+ * FUNCTION: runBench
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Runs one helper with the clock, the allocation count and the counters around it.
+ * PARAMETERS:
+    *  const MicroBench *bench : Helper to run.
+    *  long count : Iterations.
+    *  const PerfCounters *counters : Counters, possibly not open.
+ * RETURNS : BenchResult - what the iterations cost in total.
+ */
+BenchResult runBench(const MicroBench *bench, long count, const PerfCounters *counters) {
+    BenchResult     result = {0};
+    struct timespec start;
+    struct timespec end;
+
+    bench->body(count / BENCH_LOG_DIVISOR);   // Warm the caches and the allocator
+
+    unsigned long allocations = allocationCount();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    perfStart(counters);
+    bench->body(count);
+    result.cycles = perfRead(counters->cyclesFd);
+    result.misses = perfRead(counters->missesFd);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    result.allocations = allocationCount() - allocations;
+    result.seconds     = elapsedSeconds(&start, &end);
+    return result;
+}
+
+/*
+ * FUNCTION: printResult
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Prints one row of the results table, per iteration.
+ * PARAMETERS:
+    *  const char *name : Helper name.
+    *  long count : Iterations.
+    *  const BenchResult *result : Totals from runBench().
+    *  const PerfCounters *counters : Decides whether the counter columns are printed.
+ * RETURNS : n/a
+ */
+void printResult(const char *name, long count, const BenchResult *result, const PerfCounters *counters) {
+    printf("  %-28s %9.1f %10.2f", name, result->seconds * 1e9 / count, (double)result->allocations / count);
+    if (counters->cyclesFd < 0) {
+        printf(" %10s %10s\n", "n/a", "n/a");
+    } else {
+        printf(" %10.1f %10.3f\n", (double)result->cycles / count, (double)result->misses / count);
+    }
+}
+
+/*
+ * FUNCTION: benchIsNullTerminated
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Checks a name buffer for its terminator.
+ * PARAMETERS:
+    *  long count : Iterations.
+ * RETURNS : n/a
+ */
+void benchIsNullTerminated(long count) {
+    unsigned long found = 0;
+    for (long i = 0; i < count; i++) {
+        found += isNullTerminated(names[i & (BENCH_CORPUS_SIZE - 1)], MAX_NAME_LEN);
+    }
+    benchSink += found;
+}
+
+/*
+ * FUNCTION: benchMatchLiteral
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Matches "party" the way the client's input loop does.
+ * PARAMETERS:
+    *  long count : Iterations.
+ * RETURNS : n/a
+ */
+void benchMatchLiteral(long count) {
+    unsigned long matched = 0;
+    for (long i = 0; i < count; i++) {
+        matched += stringMatchesRegex("party", MAX_BUFFER_SIZE, literalPattern);
+    }
+    benchSink += matched;
+}
+
+/*
+ * FUNCTION: benchMatchRegex
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Matches names against REGEX_NAME through the regex engine.
+ * PARAMETERS:
+    *  long count : Iterations.
+ * RETURNS : n/a
+ */
+void benchMatchRegex(long count) {
+    unsigned long matched = 0;
+    for (long i = 0; i < count; i++) {
+        matched += stringMatchesRegex(names[i & (BENCH_CORPUS_SIZE - 1)], MAX_NAME_LEN, namePattern);
+    }
+    benchSink += matched;
+}
+
+/*
+ * FUNCTION: benchConvertToInt
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Converts ages.
+ * PARAMETERS:
+    *  long count : Iterations.
+ * RETURNS : n/a
+ */
+void benchConvertToInt(long count) {
+    unsigned long total = 0;
+    int           age   = 0;
+    for (long i = 0; i < count; i++) {
+        if (convertToInt(ages[i & (BENCH_CORPUS_SIZE - 1)], &age)) {
+            total += (unsigned long)age;
+        }
+    }
+    benchSink += total;
+}
+
+/*
+ * FUNCTION: benchSplitClientName
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Splits scanned names into first and last names.
+ * PARAMETERS:
+    *  long count : Iterations.
+ * RETURNS : n/a
+ */
+void benchSplitClientName(long count) {
+    char          firstName[MAX_NAME_LEN];
+    char          lastName[MAX_NAME_LEN];
+    unsigned long total = 0;
+    for (long i = 0; i < count; i++) {
+        long slot = i & (BENCH_CORPUS_SIZE - 1);
+        splitClientName(names[slot], &splits[slot], firstName, lastName);
+        total += (unsigned char)firstName[0] + (unsigned char)lastName[0];
+    }
+    benchSink += total;
+}
+
+/*
+ * FUNCTION: benchClientToString
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Formats clients into records and frees them.
+ * PARAMETERS:
+    *  long count : Iterations.
+ * RETURNS : n/a
+ */
+void benchClientToString(long count) {
+    unsigned long total = 0;
+    for (long i = 0; i < count; i++) {
+        char *record = clientToString(&clients[i & (BENCH_CORPUS_SIZE - 1)]);
+        if (record) {
+            total += (unsigned char)record[0];
+            free(record);
+        }
+    }
+    benchSink += total;
+}
+
+/*
+ * FUNCTION: benchFormatClientRecord
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Formats clients into records in a reused buffer, as the client sends them.
+ * PARAMETERS:
+    *  long count : Iterations.
+ * RETURNS : n/a
+ */
+void benchFormatClientRecord(long count) {
+    char          record[WIRE_MAX_FRAME_SIZE];
+    unsigned long total = 0;
+    for (long i = 0; i < count; i++) {
+        total += formatClientRecord(record, sizeof(record), &clients[i & (BENCH_CORPUS_SIZE - 1)]);
+    }
+    benchSink += total;
+}
+
+/*
+ * FUNCTION: benchTextDecodeClient
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Parses text records into clients.
+ * PARAMETERS:
+    *  long count : Iterations.
+ * RETURNS : n/a
+ */
+void benchTextDecodeClient(long count) {
+    Client        client;
+    unsigned long total = 0;
+    for (long i = 0; i < count; i++) {
+        const char *record = records[i & (BENCH_CORPUS_SIZE - 1)];
+        if (textDecodeClient(record, strlen(record), &client)) {
+            total += (unsigned long)client.age;
+        }
+    }
+    benchSink += total;
+}
+
+/*
+ * FUNCTION: benchWriteToLog
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Queues text records on the logger, as the server logs every client.
+    *  Records go in bursts of half the queue and each burst waits for the
+    *  writer thread to drain it, so no line is dropped and the time includes
+    *  writing the lines out.
+ * PARAMETERS:
+    *  long count : Iterations.
+ * RETURNS : n/a
+ */
+void benchWriteToLog(long count) {
+    const long burst = LOG_QUEUE_CAPACITY / 2;
+    for (long i = 0; i < count; i++) {
+        loggerLog(&logger, records[i & (BENCH_CORPUS_SIZE - 1)]);
+        if ((i + 1) % burst == 0 || i + 1 == count) {
+            while (loggerGetStats(&logger).queueDepth > 0) {
+                sched_yield();
+            }
+        }
+    }
+}
@@ -0,0 +1,205 @@
+/*
+ * FILE: protocol_bench.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * protocol_bench compares the throughput of the text protocol
+ * ("FirstName,LastName,Age,Address\n") and the binary wire protocol. A
+ * writer process encodes client records the way the client does and streams
+ * them through a pipe; the reader frames them with the server's LineFramer
+ * and decodes every record back into a Client struct.
+ *
+ * USAGE: protocol_bench [record count]
+*/
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "framer.h"
+#include "protocol.h"
+#include "shared.h"
+
+#define BENCH_DEFAULT_COUNT 1000000
+#define BENCH_STAGING_SIZE  (64 * 1024)
+
+double elapsedSeconds(const struct timespec *start, const struct timespec *end);
+size_t encodeTextClient(char *out, size_t outSize, const Client *client);
+void   runWriter(int fd, long count, bool binary);
+double runBenchmark(long count, bool binary, size_t *bytesPerRecord);
+
+int main(int argc, char *argv[]) {
+    long count = BENCH_DEFAULT_COUNT;
+    if (argc > 1 && (count = strtol(argv[1], NULL, 10)) <= 0) {
+        fprintf(stderr, "Usage: %s [record count]\n", argv[0]);
+        return ERROR;
+    }
+
+    size_t textBytes   = 0;
+    size_t binaryBytes = 0;
+    double text        = runBenchmark(count, false, &textBytes);
+    double binary      = runBenchmark(count, true, &binaryBytes);
+    if (text <= 0 || binary <= 0) {
+        fprintf(stderr, "Benchmark failed\n");
+        return ERROR;
+    }
+
+    printf("Protocol benchmark (%ld client records, encode -> pipe -> frame -> decode)\n", count);
+    printf("  text   : %12.0f records/s  %3zu bytes/record\n", count / text, textBytes);
+    printf("  binary : %12.0f records/s  %3zu bytes/record\n", count / binary, binaryBytes);
+    printf("  speedup: %12.1fx\n", text / binary);
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: elapsedSeconds
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Returns the time between two CLOCK_MONOTONIC samples.
+ * PARAMETERS:
+    *  const struct timespec *start : Earlier sample.
+    *  const struct timespec *end : Later sample.
+ * RETURNS : double - elapsed time in seconds.
+ */
+double elapsedSeconds(const struct timespec *start, const struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec)
+         + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/*
+ * FUNCTION: encodeTextClient
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Encodes a client as a text line the same way the client does:
+    *  clientToString() sizes and allocates the string, then
+    *  writestringToFIFOSession() copies it again to append the newline.
+ * PARAMETERS:
+    *  char *out : Buffer to write the line into.
+    *  size_t outSize : Size of out in bytes.
+    *  const Client *client : Client to encode.
+ * RETURNS : size_t - line length including the newline, or 0 on failure.
+ */
+size_t encodeTextClient(char *out, size_t outSize, const Client *client) {
+    const int totalLength = snprintf(
+        NULL, 0, "%s,%s,%d,%s", client->firstName, client->lastName, client->age,
+        client->address
+    );
+    char *clientString = calloc(totalLength + 1, sizeof(char));
+    if (!clientString) {
+        return 0;
+    }
+    snprintf(clientString, totalLength + 1, "%s,%s,%d,%s", client->firstName,
+             client->lastName, client->age, client->address);
+
+    char *line = malloc(totalLength + 2);
+    if (!line || (size_t)totalLength + 1 > outSize) {
+        free(clientString);
+        free(line);
+        return 0;
+    }
+    snprintf(line, totalLength + 2, "%s\n", clientString);
+    memcpy(out, line, totalLength + 1);
+    free(line);
+    free(clientString);
+    return (size_t)totalLength + 1;
+}
+
+/*
+ * FUNCTION: runWriter
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Encodes count client records and writes them to fd in large batches.
+ * PARAMETERS:
+    *  int fd : Write end of the pipe.
+    *  long count : Number of records to send.
+    *  bool binary : true for binary frames, false for text lines.
+ * RETURNS : n/a (exits the process)
+ */
+void runWriter(int fd, long count, bool binary) {
+    Client client = {
+        .firstName = "Jane", .lastName = "Doe", .age = 42,
+        .address = "123 Main Street, Springfield",
+    };
+    char   staging[BENCH_STAGING_SIZE];
+    size_t used = 0;
+
+    for (long i = 0; i < count; i++) {
+        if (sizeof(staging) - used < WIRE_MAX_FRAME_SIZE) {
+            if (write(fd, staging, used) != (ssize_t)used) {
+                _exit(EXIT_FAILURE);
+            }
+            used = 0;
+        }
+        client.age = MIN_CLIENT_AGE + (int)(i % (MAX_CLIENT_AGE - MIN_CLIENT_AGE));
+        used += binary ? wireEncodeClient(staging + used, sizeof(staging) - used, &client)
+                       : encodeTextClient(staging + used, sizeof(staging) - used, &client);
+    }
+    if (used > 0 && write(fd, staging, used) != (ssize_t)used) {
+        _exit(EXIT_FAILURE);
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+/*
+ * FUNCTION: runBenchmark
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Times count records from the writer process until the reader has
+    *  framed and decoded all of them.
+ * PARAMETERS:
+    *  long count : Number of records to send.
+    *  bool binary : true for binary frames, false for text lines.
+    *  size_t *bytesPerRecord : Set to the encoded size of one record.
+ * RETURNS : double - elapsed seconds, or -1 on failure.
+ */
+double runBenchmark(long count, bool binary, size_t *bytesPerRecord) {
+    int pipeFds[2];
+    if (pipe(pipeFds) == ERROR) {
+        perror("Error creating pipe");
+        return ERROR;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pid_t writer = fork();
+    if (writer == 0) {
+        close(pipeFds[0]);
+        runWriter(pipeFds[1], count, binary);
+    }
+    close(pipeFds[1]);
+
+    LineFramer framer;
+    if (writer == -1 || framerInit(&framer, FRAMER_DEFAULT_CAPACITY) == ERROR) {
+        close(pipeFds[0]);
+        return ERROR;
+    }
+
+    long       decoded = 0;
+    size_t     bytes   = 0;
+    Client     client;
+    RecordView record;
+    while (decoded < count && framerFill(&framer, pipeFds[0]) > 0) {
+        while (framerNext(&framer, &record)) {
+            bool ok = record.type == WIRE_CLIENT
+                    ? wireDecodeClient(record.data, record.length, &client)
+                    : textDecodeClient(record.data, record.length, &client);
+            if (ok) {
+                decoded++;
+            }
+            bytes = record.length + (record.type == WIRE_TEXT ? 1 : WIRE_HEADER_SIZE);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    framerFree(&framer);
+    close(pipeFds[0]);
+    waitpid(writer, NULL, 0);
+
+    *bytesPerRecord = bytes;
+    return decoded == count ? elapsedSeconds(&start, &end) : ERROR;
+}
@@ -0,0 +1,236 @@
+/*
+ * FILE: validator_bench.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * validator_bench compares two ways of validating a corpus of name and
+ * age inputs, splitting the names and converting the ages:
+ *   - regex: REGEX_NAME and REGEX_NUMBER precompiled by patternCompile(),
+ *     then strchr + snprintf to split and a snprintf copy + strtol to
+ *     convert (the client's validators before validate.c)
+ *   - scanner: scanClientName() and scanDigits() from validate.c
+ * Both must accept exactly the same records with the same output.
+ *
+ * USAGE: validator_bench [record count]
+*/
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pattern.h"
+#include "shared.h"
+#include "validate.h"
+
+#define BENCH_DEFAULT_COUNT 1000000
+#define BENCH_AGE_LEN       BUFFER_SIZE_OF_FOUR
+
+// One corpus entry as typed by a user
+typedef struct BenchRecord {
+    char name[MAX_NAME_LEN];
+    char age[BENCH_AGE_LEN];
+} BenchRecord;
+
+// How a run turned out
+typedef struct BenchResult {
+    double        seconds;
+    long          accepted;
+    unsigned long checksum;   // Over the split names and ages, to compare runs
+} BenchResult;
+
+typedef enum BenchMode { BENCH_REGEX, BENCH_SCANNER } BenchMode;
+
+double      elapsedSeconds(const struct timespec *start, const struct timespec *end);
+void        buildCorpus(BenchRecord *records, long count);
+bool        convertWithStrtol(const char *buffer, int *result);
+void        splitWithStrchr(const char *buffer, char *firstName, char *lastName);
+BenchResult runBenchmark(const BenchRecord *records, long count, BenchMode mode);
+
+int main(int argc, char *argv[]) {
+    long count = BENCH_DEFAULT_COUNT;
+    if (argc > 1 && (count = strtol(argv[1], NULL, 10)) <= 0) {
+        fprintf(stderr, "Usage: %s [record count]\n", argv[0]);
+        return ERROR;
+    }
+
+    BenchRecord *records = malloc(sizeof(BenchRecord) * (size_t)count);
+    if (!records) {
+        perror("Memory allocation failed");
+        return ERROR;
+    }
+    buildCorpus(records, count);
+
+    BenchResult regex   = runBenchmark(records, count, BENCH_REGEX);
+    BenchResult scanner = runBenchmark(records, count, BENCH_SCANNER);
+    free(records);
+    patternRegistryFree();
+
+    if (regex.accepted != scanner.accepted || regex.checksum != scanner.checksum) {
+        fprintf(stderr, "Validators disagree: %ld regex vs %ld scanner accepted\n", regex.accepted,
+                scanner.accepted);
+        return ERROR;
+    }
+
+    printf("Validator benchmark (%ld name + age records, %ld valid)\n", count, scanner.accepted);
+    printf("  regex  : %12.0f records/s  %6.1f ns/record\n", count / regex.seconds,
+           regex.seconds * 1e9 / count);
+    printf("  scanner: %12.0f records/s  %6.1f ns/record\n", count / scanner.seconds,
+           scanner.seconds * 1e9 / count);
+    printf("  speedup: %12.1fx\n", regex.seconds / scanner.seconds);
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: elapsedSeconds
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Returns the time between two CLOCK_MONOTONIC samples.
+ * PARAMETERS:
+    *  const struct timespec *start : Earlier sample.
+    *  const struct timespec *end : Later sample.
+ * RETURNS : double - elapsed time in seconds.
+ */
+double elapsedSeconds(const struct timespec *start, const struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec)
+         + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/*
+ * FUNCTION: buildCorpus
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Fills the corpus with a repeatable mix of inputs: mostly valid names
+    *  and ages, plus lower case names, extra words, digits, empty input and
+    *  ages that are out of range or not numbers.
+ * PARAMETERS:
+    *  BenchRecord *records : Corpus to fill.
+    *  long count : Number of records.
+ * RETURNS : n/a
+ */
+void buildCorpus(BenchRecord *records, long count) {
+    static const char *const firstNames[] = {"Jane", "John", "Ann", "Bartholomew", "Li", "Maximilian"};
+    static const char *const lastNames[]  = {"Doe", "Smith", "Lee", "Featherstonehaugh", "O", "Nguyen"};
+    static const char *const badNames[]   = {"jane doe", "Jane  Doe", "Jane Doe Jr", "J4ne Doe",
+                                             "Jane", " Jane Doe", "Jane doe", "JANE DOE"};
+    static const char *const badAges[]    = {"17", "126", "abc", "4x", "-5", "999", "", " 42"};
+    const size_t firstCount = sizeof(firstNames) / sizeof(firstNames[0]);
+    const size_t lastCount  = sizeof(lastNames) / sizeof(lastNames[0]);
+    const size_t badCount   = sizeof(badNames) / sizeof(badNames[0]);
+    const size_t ageCount   = sizeof(badAges) / sizeof(badAges[0]);
+
+    srand(2031);
+    for (long i = 0; i < count; i++) {
+        int roll = rand() % 10;
+        if (roll < 8) {
+            snprintf(records[i].name, MAX_NAME_LEN, "%s %s", firstNames[(size_t)rand() % firstCount],
+                     lastNames[(size_t)rand() % lastCount]);
+        } else {
+            snprintf(records[i].name, MAX_NAME_LEN, "%s", badNames[(size_t)rand() % badCount]);
+        }
+
+        if (rand() % 10 < 8) {
+            snprintf(records[i].age, BENCH_AGE_LEN, "%d",
+                     MIN_CLIENT_AGE + rand() % (MAX_CLIENT_AGE - MIN_CLIENT_AGE + 1));
+        } else {
+            snprintf(records[i].age, BENCH_AGE_LEN, "%s", badAges[(size_t)rand() % ageCount]);
+        }
+    }
+}
+
+/*
+ * FUNCTION: convertWithStrtol
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: The previous convertToInt(): snprintf copy, then strtol.
+ * PARAMETERS:
+    *  const char *buffer : Digits.
+    *  int *result : Receives the value.
+ * RETURNS : bool - true if the conversion succeeded.
+ */
+bool convertWithStrtol(const char *buffer, int *result) {
+    const int MAX_INT_DIGITS = 11;
+    char      bufCopy[MAX_INT_DIGITS + 1];
+    snprintf(bufCopy, sizeof(bufCopy), "%s", buffer);
+
+    errno                = 0;
+    char *numEndPtr      = NULL;
+    long  convertedValue = strtol(bufCopy, &numEndPtr, 10);
+    if (errno != 0 || *numEndPtr != '\0') {
+        return false;
+    }
+    *result = (int)convertedValue;
+    return true;
+}
+
+/*
+ * FUNCTION: splitWithStrchr
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: The previous splitClientName(): rescan for the space, then two snprintf copies.
+ * PARAMETERS:
+    *  const char *buffer : Validated "First Last" name.
+    *  char *firstName : Receives the first name.
+    *  char *lastName : Receives the last name.
+ * RETURNS : n/a
+ */
+void splitWithStrchr(const char *buffer, char *firstName, char *lastName) {
+    const char *spacePosition   = strchr(buffer, ' ');
+    int         firstNameLength = (int)(spacePosition - buffer);
+    snprintf(firstName, (size_t)firstNameLength + 1, "%.*s", firstNameLength, buffer);
+    snprintf(lastName, MAX_NAME_LEN - (size_t)firstNameLength - 1, "%s", spacePosition + 1);
+}
+
+/*
+ * FUNCTION: runBenchmark
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Validates, splits and converts every record with one of the two methods.
+ * PARAMETERS:
+    *  const BenchRecord *records : Corpus.
+    *  long count : Number of records.
+    *  BenchMode mode : Method to time.
+ * RETURNS : BenchResult - time taken, accepted records and a checksum of the output.
+ */
+BenchResult runBenchmark(const BenchRecord *records, long count, BenchMode mode) {
+    BenchResult    result        = {0};
+    const Pattern *namePattern   = patternCompile(REGEX_NAME);
+    const Pattern *numberPattern = patternCompile(REGEX_NUMBER);
+    Client         client        = {0};
+    struct timespec start;
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < count; i++) {
+        const char *name    = records[i].name;
+        const char *age     = records[i].age;
+        bool        isValid = false;
+
+        if (mode == BENCH_SCANNER) {
+            NameSplit split;
+            isValid = scanClientName(name, strnlen(name, MAX_NAME_LEN), &split)
+                      && scanDigits(age, &client.age);
+            if (isValid) {
+                memcpy(client.firstName, name, split.firstLength);
+                client.firstName[split.firstLength] = '\0';
+                memcpy(client.lastName, name + split.lastOffset, split.lastLength);
+                client.lastName[split.lastLength] = '\0';
+            }
+        } else {
+            isValid = patternMatches(namePattern, name, strlen(name))
+                      && patternMatches(numberPattern, age, strlen(age))
+                      && convertWithStrtol(age, &client.age);
+            if (isValid) {
+                splitWithStrchr(name, client.firstName, client.lastName);
+            }
+        }
+
+        if (isValid && client.age >= MIN_CLIENT_AGE && client.age <= MAX_CLIENT_AGE) {
+            result.accepted++;
+            result.checksum = result.checksum * 31 + (unsigned long)client.age
+                            + (unsigned char)client.firstName[0] + strlen(client.lastName);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    result.seconds = elapsedSeconds(&start, &end);
+    return result;
+}
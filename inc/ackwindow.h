@@ -0,0 +1,52 @@
+/*
+ * FILE: ackwindow.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * ackwindow.h declares the client side of session acknowledgements. Every
+ * record written to a session FIFO is kept in a fixed window until the
+ * server acknowledges it on the client's reply FIFO (WIRE_ACK, see
+ * protocol.h). The client keeps writing while fewer than ACK_WINDOW_SIZE
+ * records are unacknowledged and waits once the window is full, so a
+ * server that falls behind slows its clients down instead of letting them
+ * run ahead. Records still in the window are written again when a session
+ * is reopened after a server restart.
+*/
+#ifndef ACKWINDOW_H
+#define ACKWINDOW_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "protocol.h"
+
+#define ACK_FRAME_SIZE (WIRE_HEADER_SIZE + sizeof(WireAck))
+#define ACK_READ_SIZE  (ACK_WINDOW_SIZE * ACK_FRAME_SIZE)   // Reply bytes read per read()
+
+// Outcome of waiting on the reply FIFO
+typedef enum AckStatus {
+    ACK_WAITING,    // Nothing new before the timeout
+    ACK_RECEIVED,   // At least one acknowledgement was read
+    ACK_HANGUP      // The server closed its end: it stopped or restarted
+} AckStatus;
+
+// Records of one session the server has not acknowledged yet. Record n is
+// kept in slot n % ACK_WINDOW_SIZE until an ACK covers it.
+typedef struct AckWindow {
+    int      replyFd;    // Non-blocking read end of the reply FIFO, -1 when closed
+    uint64_t sent;       // Records written on the session
+    uint64_t acked;      // Records the server has acknowledged
+    uint64_t rejected;   // Records (or batched frames) the server discarded
+    size_t   partial;    // Bytes of an ACK frame split across reads
+    char     input[ACK_READ_SIZE];
+    size_t   lengths[ACK_WINDOW_SIZE];
+    char     records[ACK_WINDOW_SIZE][WIRE_MAX_FRAME_SIZE];
+} AckWindow;
+
+void        ackWindowReset(AckWindow *window, int replyFd);
+size_t      ackWindowInFlight(const AckWindow *window);
+int         ackWindowPush(AckWindow *window, const char *record, size_t length);
+const char *ackWindowRecord(const AckWindow *window, uint64_t number, size_t *length);
+AckStatus   ackWindowPoll(AckWindow *window, int timeoutMs);
+
+#endif   // ACKWINDOW_H
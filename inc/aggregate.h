@@ -0,0 +1,48 @@
+/*
+ * FILE: aggregate.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * aggregate.h declares the server's per-destination statistics. Entries
+ * are indexed by the destination ids of a DestinationTable and updated as
+ * each client and party arrives, so a snapshot is a scan of one array
+ * rather than a pass over travel_agency.log.
+*/
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "partybatch.h"
+#include "shared.h"
+
+// Age histogram: AGE_BUCKET_WIDTH years per bucket from MIN_CLIENT_AGE up
+#define AGE_BUCKET_WIDTH 10
+#define AGE_BUCKET_COUNT ((MAX_CLIENT_AGE - MIN_CLIENT_AGE) / AGE_BUCKET_WIDTH + 1)
+
+// Running totals for one destination
+typedef struct DestinationStats {
+    unsigned long parties;   // Completed parties
+    unsigned long clients;   // Clients received, counted as they arrive
+    unsigned long ageBuckets[AGE_BUCKET_COUNT];
+    time_t        lastSeen;  // Last party or client for this destination
+} DestinationStats;
+
+// DestinationStats by destination id
+typedef struct AggregateIndex {
+    DestinationStats *entries;
+    uint32_t          capacity;
+} AggregateIndex;
+
+DestinationStats *aggregateEntry(AggregateIndex *index, uint32_t destinationId);
+int               aggregateAddClient(AggregateIndex *index, uint32_t destinationId, int age, time_t now);
+int               aggregateAddParty(AggregateIndex *index, uint32_t destinationId, time_t now);
+char             *aggregateSnapshot(const AggregateIndex *index, const DestinationTable *destinations,
+                                    size_t *length);
+void              aggregateFree(AggregateIndex *index);
+
+#endif   // AGGREGATE_H
@@ -0,0 +1,38 @@
+/*
+ * FILE: arena.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * arena.h declares a bump allocator for per-party data. Allocations are
+ * carved from large blocks and never freed one by one; arenaReset() makes
+ * the whole arena reusable in O(1) and keeps its blocks for the next party.
+*/
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_DEFAULT_BLOCK_SIZE (16 * 1024)
+
+// One block of arena memory; data[used, capacity) is free
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t             capacity;
+    size_t             used;
+    max_align_t        data[];
+} ArenaBlock;
+
+// A zero-initialised Arena is empty and ready to use
+typedef struct Arena {
+    ArenaBlock *first;
+    ArenaBlock *current;     // Block allocations are bumped from
+    void       *last;        // Most recent allocation, may grow in place
+    size_t      blockSize;   // 0 means ARENA_DEFAULT_BLOCK_SIZE
+} Arena;
+
+void *arenaAlloc(Arena *arena, size_t size);
+void *arenaGrow(Arena *arena, void *old, size_t oldSize, size_t newSize);
+void  arenaReset(Arena *arena);
+void  arenaFree(Arena *arena);
+
+#endif   // ARENA_H
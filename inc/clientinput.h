@@ -0,0 +1,27 @@
+/*
+ * FILE: clientinput.h
+ * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * clientinput.h declares the client's input validation, conversion and
+ * formatting helpers (see clientinput.c). isNullTerminated() is declared
+ * in shared.h.
+*/
+#ifndef CLIENTINPUT_H
+#define CLIENTINPUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "pattern.h"
+#include "shared.h"
+#include "validate.h"
+
+bool   stringMatchesRegex(const char *string, size_t bufSize, const Pattern *pattern);
+bool   convertToInt(const char *buffer, int *result);
+void   splitClientName(const char *buffer, const NameSplit *split, char *firstName, char *lastName);
+char  *clientToString(const Client *client);
+size_t formatClientRecord(char *out, size_t size, const Client *client);
+size_t formatTextRecord(char *out, size_t size, const char *string);
+
+#endif   // CLIENTINPUT_H
@@ -0,0 +1,39 @@
+/*
+ * FILE: clientsession.h
+ * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * clientsession.h declares the client's send path (see clientsession.c):
+ * opening a session with the server over the chosen transport, sending
+ * records through the acknowledgement window, resuming a session after a
+ * server restart and closing it again. One session is open at a time.
+*/
+#ifndef CLIENTSESSION_H
+#define CLIENTSESSION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "protocol.h"
+#include "shared.h"
+#include "transport.h"
+
+void   clientSessionConfigure(bool textProtocol, const TransportAddress *address);
+int    openFIFOSession(const char *fifoname, bool showConnectionMsg);
+int    connectFIFOSession(const char *fifoname, uint64_t resume, bool showConnectionMsg);
+int    connectSocketSession(uint64_t resume, bool showConnectionMsg);
+size_t encodeSessionHello(char *hello, size_t size, uint64_t resume);
+int    resumeFIFOSession(int fd);
+int    writeSessionRecord(int fd, const char *record, size_t length);
+int    writeRecordToTransport(int fd, const char *record, size_t length);
+int    writeRecordToSocket(int fd, const char *record, size_t length);
+int    waitForAcknowledgements(int fd, size_t maxInFlight);
+int    writestringToFIFOSession(int fd, const char *string);
+int    writeTextRecord(int fd, const char *record, size_t length);
+int    writeFrameToFIFOSession(int fd, const char *frame, size_t length);
+int    sendMessage(int fd, WireMessageType type, const Trip *trip, const Client *client);
+int    sendTripBatch(int fd, const Trip *trip, bool showSentMsg);
+void   closeFIFOSession(int *fd);
+
+#endif   // CLIENTSESSION_H
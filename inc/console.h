@@ -0,0 +1,40 @@
+/*
+ * FILE: console.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * console.h declares the server's console output. How much the server
+ * prints per record is chosen with --output (see ConsoleMode), and what it
+ * prints goes through a Console: a buffer the aggregator thread formats
+ * into and hands to stdout once per pass, instead of one stdio call per
+ * printed line.
+*/
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define CONSOLE_BUFFER_SIZE (64 * 1024)   // Bytes held before a pass is over
+
+// What the server prints for each record and party
+typedef enum ConsoleMode {
+    CONSOLE_QUIET,     // Nothing; start, stop and errors only
+    CONSOLE_COMPACT,   // One key=value line per record, session and completed party
+    CONSOLE_PRETTY     // "Received:" echoes, client boxes and party summaries
+} ConsoleMode;
+
+typedef struct Console {
+    FILE  *stream;
+    size_t used;
+    char   buffer[CONSOLE_BUFFER_SIZE];
+} Console;
+
+void consoleInit(Console *console, FILE *stream);
+void consoleFormat(Console *console, const char *format, ...) __attribute__((format(printf, 2, 3)));
+void consoleQuote(Console *console, const char *value);
+void consoleFlush(Console *console);
+bool consoleParseMode(const char *name, ConsoleMode *mode);
+
+#endif   // CONSOLE_H
@@ -0,0 +1,16 @@
+/*
+ * FILE: countalloc.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * countalloc.h declares the allocation counter of the benchmarks. Linking
+ * bench/countalloc.c into an executable replaces malloc(), calloc(),
+ * realloc() and the aligned allocators with wrappers that count each call
+ * before handing it to glibc, including calls made inside libc itself.
+*/
+#ifndef COUNTALLOC_H
+#define COUNTALLOC_H
+
+unsigned long allocationCount(void);
+
+#endif   // COUNTALLOC_H
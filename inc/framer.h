@@ -0,0 +1,50 @@
+/*
+ * FILE: framer.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * framer.h declares the streaming record framer used by the server to split
+ * the bytes read from a FIFO into records. A record is either a
+ * newline-terminated text line or a binary wire frame (see protocol.h).
+*/
+#ifndef FRAMER_H
+#define FRAMER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+// Framer sizing (bytes)
+#define FRAMER_READ_SIZE        (64 * 1024)              // Bytes requested per read()
+#define FRAMER_DEFAULT_CAPACITY (2 * FRAMER_READ_SIZE)   // Room for a full read plus carry over
+
+// A record inside the framer buffer, valid until the next framerFill().
+// Text records (type WIRE_TEXT) have their newline overwritten so
+// data[length] is '\0'. Binary records point at the frame payload and
+// carry the frame's WireMessageType; they are not null-terminated.
+typedef struct RecordView {
+    const char *data;
+    size_t      length;
+    int         type;
+} RecordView;
+
+// Streaming line framer. Unconsumed bytes live in buffer[start, end); the
+// partial record at the tail is slid back to the front before the next read.
+typedef struct LineFramer {
+    char         *buffer;
+    size_t        capacity;
+    size_t        start;        // First byte not yet handed out as a record
+    size_t        end;          // One past the last byte read
+    size_t        scanned;      // Bytes after start already searched for '\n'
+    bool          discarding;   // Dropping an oversized record until its newline
+    unsigned long discarded;    // Number of oversized or corrupt records dropped
+} LineFramer;
+
+int     framerInit(LineFramer *framer, size_t capacity);
+void    framerFree(LineFramer *framer);
+ssize_t framerFill(LineFramer *framer, int fd);
+int     framerPush(LineFramer *framer, const char *data, size_t length);
+bool    framerNext(LineFramer *framer, RecordView *record);
+bool    recordEquals(const RecordView *record, const char *literal);
+
+#endif   // FRAMER_H
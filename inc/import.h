@@ -0,0 +1,51 @@
+/*
+ * FILE: import.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * import.h declares the row parser for the client's bulk import mode
+ * (client --import manifest.csv). A manifest row is
+ *     destination,Firstname Lastname,age,address
+ * in CSV: fields containing commas or quotes are double quoted, with ""
+ * for a literal quote. Each row is validated with the same rules as the
+ * interactive prompts.
+*/
+#ifndef IMPORT_H
+#define IMPORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "protocol.h"
+#include "shared.h"
+
+#define IMPORT_HEADER_ROW    "destination,name,age,address"   // Optional first row
+#define IMPORT_MAX_REPORTED  20   // Rejected rows printed individually
+
+// Largest party sent as one batch; always fits in WIRE_MAX_BATCH_SIZE
+#define IMPORT_MAX_PARTY_CLIENTS ((int)((WIRE_MAX_BATCH_SIZE - WIRE_MAX_FRAME_SIZE) / WIRE_MAX_CLIENT_FRAME))
+
+// Why a row was rejected
+typedef enum ImportRowStatus {
+    IMPORT_ROW_OK,
+    IMPORT_ROW_BAD_COLUMNS,       // Not exactly four fields, or a broken quote
+    IMPORT_ROW_BAD_DESTINATION,   // Empty or longer than MAX_DESTINATION_LEN - 1
+    IMPORT_ROW_BAD_NAME,          // Not "Firstname Lastname"
+    IMPORT_ROW_BAD_AGE,           // Not MIN_CLIENT_AGE..MAX_CLIENT_AGE
+    IMPORT_ROW_BAD_ADDRESS        // Empty or longer than MAX_ADDRESS_LEN - 1
+} ImportRowStatus;
+
+// Running totals for an import
+typedef struct ImportStats {
+    unsigned long rows;       // Data rows read (header and blank lines excluded)
+    unsigned long clients;    // Rows accepted and sent
+    unsigned long parties;    // Batches sent
+    unsigned long rejected;   // Rows that failed validation
+} ImportStats;
+
+ImportRowStatus importParseRow(const char *line, size_t length, char *destination, Client *client);
+bool            importIsHeaderRow(const char *line, size_t length);
+const char     *importRowStatusName(ImportRowStatus status);
+
+#endif   // IMPORT_H
@@ -0,0 +1,78 @@
+/*
+ * FILE: journal.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * journal.h declares the server's binary write-ahead journal. Every change
+ * to session state (party started, destination, client, party ended,
+ * records acknowledged, session closed) is appended as a checksummed record
+ * tagged with the session pid. Records are buffered and made durable
+ * together by journalCommit() (group commit: one write and one fdatasync
+ * for every record received in an event loop pass), which ends the group
+ * with a JOURNAL_COMMIT marker. On restart the records after the latest
+ * snapshot (snapshot.h) are replayed one whole group at a time; a group
+ * torn by a crash is dropped.
+*/
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define JOURNAL_PATH             "travel_agency.journal"
+#define JOURNAL_BUFFER_SIZE      (64 * 1024)   // Records held before a write()
+#define JOURNAL_SNAPSHOT_RECORDS 100000        // Records between snapshots
+#define JOURNAL_MAX_RECORD_SIZE  4096          // Largest payload, a wire client frame fits
+
+// What a record changed
+typedef enum JournalRecordType {
+    JOURNAL_PARTY    = 1,   // Empty payload
+    JOURNAL_DEST     = 2,   // Destination bytes
+    JOURNAL_CLIENT   = 3,   // WIRE_CLIENT frame (protocol.h)
+    JOURNAL_END      = 4,   // Empty payload
+    JOURNAL_CLOSE    = 5,   // Empty payload, session closed (abandoning any party)
+    JOURNAL_PROGRESS = 6,   // u64 session records covered by this commit
+    JOURNAL_COMMIT   = 7    // Empty payload, ends a commit group (never replayed)
+} JournalRecordType;
+
+// Fixed header in front of every record payload
+typedef struct JournalRecordHeader {
+    uint32_t length;     // Payload bytes
+    uint32_t checksum;   // journalChecksum() of the header (checksum 0) and payload
+    uint64_t sequence;   // Increases by one per record, never reused
+    int64_t  time;       // time() when the record was received
+    uint32_t pid;        // Session the record belongs to (0 for the shared FIFO)
+    uint8_t  type;       // JournalRecordType
+    uint8_t  reserved[3];
+} JournalRecordHeader;
+
+_Static_assert(sizeof(JournalRecordHeader) == 32, "journal record header must be 32 bytes");
+
+// Append side of the journal
+typedef struct Journal {
+    int           fd;                    // -1 when journaling is off
+    char         *buffer;
+    size_t        used;                  // Buffered bytes not yet written
+    bool          uncommitted;           // Records appended since the last commit
+    uint64_t      nextSequence;
+    unsigned long sinceSnapshot;         // Records appended since the last snapshot
+    unsigned long records;               // Appended in total
+    unsigned long commits;               // fdatasync calls
+} Journal;
+
+// Called by journalReplay() for each committed record after the snapshot
+typedef void (*JournalApply)(void *context, const JournalRecordHeader *header, const char *payload);
+
+int      journalOpen(Journal *journal, const char *path, uint64_t nextSequence);
+int      journalAppend(Journal *journal, JournalRecordType type, long pid, const void *payload,
+                       size_t length);
+int      journalCommit(Journal *journal);
+int      journalTruncate(Journal *journal);
+void     journalClose(Journal *journal);
+long     journalReplay(const char *path, uint64_t afterSequence, JournalApply apply, void *context,
+                       uint64_t *lastSequence);
+uint32_t journalChecksum(const void *data, size_t length, uint32_t checksum);
+
+#endif   // JOURNAL_H
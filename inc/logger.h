@@ -0,0 +1,81 @@
+/*
+ * FILE: logger.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * logger.h declares the asynchronous server logger. Producers copy each
+ * message into a lock-free queue; a background writer thread timestamps
+ * the messages and appends them to the log file in large batches, either
+ * with write() on an O_APPEND file or by memcpy into mapped log segments.
+*/
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "logsegment.h"
+
+#define LOG_FILE_PATH          "travel_agency.log"
+#define LOG_QUEUE_CAPACITY     4096          // Slots, must be a power of two
+#define LOG_MAX_MESSAGE_LEN    1000          // Longer messages are truncated
+#define LOG_BATCH_SIZE         (64 * 1024)   // Bytes written per write() at most
+#define LOG_FLUSH_INTERVAL_MS  50            // Max delay before a partial batch is written
+#define LOG_TIMESTAMP_SIZE     32
+
+// Where the writer thread puts the formatted lines
+typedef enum LogBackend {
+    LOG_BACKEND_APPEND,   // write() batches to a single O_APPEND file
+    LOG_BACKEND_MMAP      // memcpy into fallocated, mmapped, rotating segments
+} LogBackend;
+
+// One queued message
+typedef struct LogSlot {
+    atomic_size_t sequence;   // Slot state for the queue (see logger.c)
+    time_t        timestamp;
+    uint32_t      length;
+    char          text[LOG_MAX_MESSAGE_LEN];
+} LogSlot;
+
+// Counters reported by loggerGetStats()
+typedef struct LoggerStats {
+    size_t        queueDepth;      // Messages waiting right now
+    size_t        maxQueueDepth;   // Highest depth seen by the writer
+    unsigned long logged;          // Messages written to the file
+    unsigned long dropped;         // Messages dropped because the queue was full
+    unsigned long batches;         // Batches appended to the file
+    unsigned long rotations;       // Segments rotated (mmap backend)
+} LoggerStats;
+
+typedef struct Logger {
+    LogBackend      backend;
+    int             fd;              // LOG_BACKEND_APPEND
+    LogSegment      segment;         // LOG_BACKEND_MMAP, writer thread only
+    LogSlot        *slots;
+    atomic_size_t   tail;            // Next slot producers claim
+    size_t          head;            // Next slot the writer reads (writer only)
+    atomic_size_t   headSnapshot;    // head published for queue depth
+    atomic_bool     writerSleeping;
+    atomic_bool     stopping;
+    atomic_ulong    logged;
+    atomic_ulong    dropped;
+    atomic_ulong    batches;
+    atomic_ulong    rotations;
+    atomic_size_t   maxQueueDepth;
+    pthread_t       writer;
+    pthread_mutex_t wakeLock;
+    pthread_cond_t  wakeCondition;
+    time_t          cachedSecond;    // Second the cached timestamp was formatted for
+    char            cachedStamp[LOG_TIMESTAMP_SIZE];
+} Logger;
+
+int         loggerStart(Logger *logger, const char *path, LogBackend backend, size_t segmentSize);
+void        loggerLog(Logger *logger, const char *message);
+void        loggerStop(Logger *logger);
+LoggerStats loggerGetStats(Logger *logger);
+
+#endif   // LOGGER_H
@@ -0,0 +1,85 @@
+/*
+ * FILE: logsegment.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * logsegment.h declares the memory-mapped, segmented log backend. Each
+ * segment file is preallocated with fallocate and mapped; log lines are
+ * appended with memcpy and the file is rotated to the next segment when
+ * it fills. Segments are named "<path>.<index>", e.g. travel_agency.log.000001.
+*/
+#ifndef LOGSEGMENT_H
+#define LOGSEGMENT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#define LOG_SEGMENT_MAGIC        "TALOGSEG"
+#define LOG_SEGMENT_MAGIC_LEN    8
+#define LOG_SEGMENT_VERSION      1
+#define LOG_SEGMENT_HEADER_SIZE  64
+#define LOG_SEGMENT_DEFAULT_SIZE (16UL * 1024 * 1024)   // Rotate after 16 MiB
+#define LOG_SEGMENT_MIN_SIZE     (64UL * 1024)
+#define LOG_SEGMENT_INDEX_FORMAT "%s.%06lu"
+#define LOG_SEGMENT_SYNC_MS      1000   // Max time appended lines stay unsynced
+#define LOG_SEGMENT_MAX_PATH     256    // Segment file name including the index suffix
+
+// On-disk header at offset 0 of every segment. The records follow as plain
+// "[timestamp] message\n" lines; the unused tail of the segment is zero
+// filled, so the records end at the first NUL byte even if the process
+// died before 'committed' was updated.
+typedef struct LogSegmentHeader {
+    char     magic[LOG_SEGMENT_MAGIC_LEN];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t index;       // 1-based segment number
+    uint64_t capacity;    // Record bytes the segment can hold
+    uint64_t committed;   // Record bytes synced to disk so far
+    int64_t  created;     // time() when the segment was started
+    uint8_t  reserved[16];
+} LogSegmentHeader;
+
+_Static_assert(sizeof(LogSegmentHeader) == LOG_SEGMENT_HEADER_SIZE, "segment header must be 64 bytes");
+
+// Writer state for the active segment
+typedef struct LogSegment {
+    char              basePath[LOG_SEGMENT_MAX_PATH];
+    size_t            segmentSize;   // File size including the header
+    unsigned long     index;
+    int               fd;
+    char             *map;
+    LogSegmentHeader *header;
+    size_t            used;          // Record bytes appended
+    size_t            synced;        // Record bytes covered by the last msync
+    struct timespec   lastSync;
+    unsigned long     rotations;
+} LogSegment;
+
+int  logSegmentOpen(LogSegment *segment, const char *basePath, size_t segmentSize);
+int  logSegmentAppend(LogSegment *segment, const char *data, size_t length);
+void logSegmentSync(LogSegment *segment);
+bool logSegmentSyncDue(const LogSegment *segment);
+void logSegmentClose(LogSegment *segment);
+void logSegmentPath(char *out, size_t size, const char *basePath, unsigned long index);
+size_t logSegmentRecordLength(const LogSegmentHeader *header, const char *records);
+
+/*
+ * FUNCTION: millisecondsSince
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Returns the CLOCK_MONOTONIC milliseconds elapsed since a sample. Shared
+    *  by the segment sync timer and the logger's flush timer (logger.h
+    *  includes this header).
+ * PARAMETERS:
+    *  const struct timespec *since : Earlier sample.
+ * RETURNS : long - elapsed milliseconds.
+ */
+static inline long millisecondsSince(const struct timespec *since) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) * 1000L + (now.tv_nsec - since->tv_nsec) / 1000000L;
+}
+
+#endif   // LOGSEGMENT_H
@@ -0,0 +1,74 @@
+/*
+ * FILE: metrics.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * metrics.h declares the server's runtime metrics. Every pipeline thread
+ * owns a MetricsShard on cache lines of its own and is the only thread
+ * writing it, so counting is a plain load and store with no locked
+ * instruction and no line bouncing between threads. A WIRE_METRICS query
+ * sums the shards, which any thread may read at any time, into Prometheus
+ * text exposition format.
+ *
+ * Latencies go into an HDR-style histogram: values below
+ * METRICS_SUB_BUCKETS nanoseconds are counted exactly, larger ones in
+ * METRICS_SUB_BUCKETS buckets per power of two, so any value is known to
+ * within 1 / METRICS_SUB_BUCKETS of itself from a few kilobytes of counts.
+*/
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "shared.h"
+
+#define METRICS_SUB_BUCKET_BITS 4                               // 16 buckets per power of two, 6.25% apart
+#define METRICS_SUB_BUCKETS     (1 << METRICS_SUB_BUCKET_BITS)
+#define METRICS_MAX_EXPONENT    40                              // Up to 2^40 ns (18 minutes), longer goes in the last bucket
+#define METRICS_BUCKETS         ((METRICS_MAX_EXPONENT - METRICS_SUB_BUCKET_BITS + 1) * METRICS_SUB_BUCKETS)
+#define METRICS_NAME_PREFIX     "travel_agency_"
+
+// Counters every shard has
+typedef enum MetricsCounter {
+    METRICS_MESSAGES,       // Records read from client sessions for the parsers, HELLOs not included
+    METRICS_BYTES,          // Bytes read from client sessions
+    METRICS_PARTIES,        // Parties completed
+    METRICS_CLIENTS,        // Clients added to parties
+    METRICS_PARSE_ERRORS,   // Records the reader dropped or the parsers rejected
+    METRICS_COUNTERS
+} MetricsCounter;
+
+typedef struct LatencyHistogram {
+    atomic_uint_fast64_t buckets[METRICS_BUCKETS];
+    atomic_uint_fast64_t count;
+    atomic_uint_fast64_t sumNs;
+    atomic_uint_fast64_t maxNs;
+} LatencyHistogram;
+
+// Metrics of one thread, written by it alone
+typedef struct MetricsShard {
+    alignas(CACHE_LINE_SIZE) atomic_uint_fast64_t counters[METRICS_COUNTERS];
+    LatencyHistogram latency;   // Read to committed and acknowledged
+} MetricsShard;
+
+// Value the caller adds to a snapshot: a point-in-time gauge, or a
+// running total kept outside the shards
+typedef struct MetricsGauge {
+    const char *name;      // Without METRICS_NAME_PREFIX, ends in _total for a counter
+    const char *help;
+    double      value;
+    bool        counter;   // Published as a counter rather than a gauge
+} MetricsGauge;
+
+uint64_t metricsNow(void);
+void     metricsCount(MetricsShard *shard, MetricsCounter counter, uint64_t amount);
+void     metricsRecordLatency(MetricsShard *shard, uint64_t nanos);
+char    *metricsFormat(MetricsShard *const *shards, int shardCount, const MetricsGauge *gauges,
+                       int gaugeCount, size_t *length);
+
+#endif   // METRICS_H
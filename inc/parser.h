@@ -0,0 +1,95 @@
+/*
+ * FILE: parser.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * parser.h declares the record parser run by the server's parser threads.
+ * It turns the records of a session (text lines and wire frames, see
+ * framer.h) into ParsedRecords: the decoded party change plus the line the
+ * server logs for it. Everything that depends on a session's party state
+ * is left to the caller, and a session's parser state travels with the
+ * session, so any thread can parse the next record of any session.
+ * WIRE_BATCH chunks are reassembled here and the frames of a completed
+ * batch come out one by one, as if they had arrived alone.
+*/
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "framer.h"
+#include "protocol.h"
+#include "shared.h"
+
+#define MAX_PENDING_BATCHES 64                    // Batches being reassembled per session
+#define PARSER_MAX_LINE     WIRE_MAX_FRAME_SIZE   // Longest record parserFeed() takes
+
+// Party change a record asks for
+typedef enum ParsedKind {
+    PARSED_NOTHING,       // Only logged and counted (rejected records, batch chunks)
+    PARSED_PARTY,
+    PARSED_DESTINATION,   // Destination in line[0, destinationLength)
+    PARSED_CLIENT,
+    PARSED_END,
+    PARSED_STOP,
+    PARSED_QUERY,         // Statistics snapshot for pid
+    PARSED_METRICS,       // Runtime metrics for pid
+    PARSED_TEXT           // Text line whose meaning depends on the party state
+} ParsedKind;
+
+// What a PARSED_TEXT line is if it is not a party's destination
+typedef enum ParsedText {
+    PARSED_TEXT_OTHER,    // Not part of any party
+    PARSED_TEXT_PROMPT,   // "client"
+    PARSED_TEXT_END,      // "END_PARTY" or "end"
+    PARSED_TEXT_CLIENT    // Valid client data, decoded into client
+} ParsedText;
+
+// How a record changes whether its session is inside a WIRE_BATCH
+typedef enum ParsedBatch {
+    PARSED_BATCH_SAME,   // Not a batch chunk, or one dropped before it was placed
+    PARSED_BATCH_OPEN,   // More chunks of the batch are to come
+    PARSED_BATCH_DONE    // The batch is replayed or was given up
+} ParsedBatch;
+
+typedef struct ParsedRecord {
+    ParsedKind  kind;
+    ParsedText  text;
+    ParsedBatch batch;
+    bool        counted;    // Ends a record read from the session; false for frames replayed from a batch
+    bool        rejected;   // Counts as a rejected record
+    bool        echo;       // Print the line as "Received: ..." as well as logging it
+    long        pid;        // PARSED_QUERY, PARSED_METRICS
+    size_t      destinationLength;
+    Client      client;     // PARSED_CLIENT, PARSED_TEXT_CLIENT
+    char        line[PARSER_MAX_LINE + 1];   // Line to log, empty if none
+} ParsedRecord;
+
+// WIRE_BATCH chunks received so far for one sending client
+typedef struct PendingBatch {
+    bool     inUse;
+    uint32_t batchId;
+    uint16_t nextSequence;
+    char    *data;
+    size_t   length;
+    size_t   capacity;
+} PendingBatch;
+
+// Parser state of one session. A record fed in yields one or more
+// ParsedRecords; the last one is always counted.
+typedef struct Parser {
+    PendingBatch *batches;     // MAX_PENDING_BATCHES, allocated by the session's first batch chunk
+    RecordView    record;      // Record fed in, valid until parserNext() returns false
+    bool          fed;         // record is not parsed yet
+    PendingBatch *replaying;   // Completed batch whose frames are being handed out
+    const char   *cursor;      // Next frame of replaying
+} Parser;
+
+void parserInit(Parser *parser);
+void parserFree(Parser *parser);
+void parserFeed(Parser *parser, const RecordView *record);
+bool parserNext(Parser *parser, ParsedRecord *out);
+
+#endif   // PARSER_H
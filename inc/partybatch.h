@@ -0,0 +1,83 @@
+/*
+ * FILE: partybatch.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * partybatch.h declares the columnar party the server aggregates. Each
+ * field of a client is kept in its own array: ages are a plain int array
+ * and names and addresses are (offset, length) pairs into one string pool,
+ * so a client costs its real string lengths instead of a 304-byte Client.
+ * Destinations are interned once into a DestinationTable and referred to
+ * by id.
+*/
+#ifndef PARTYBATCH_H
+#define PARTYBATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "shared.h"
+
+#define PARTY_NO_DESTINATION      UINT32_MAX   // Id of a party whose destination is not known yet
+#define PARTY_INITIAL_CLIENTS     16           // Column capacity reserved by the first client
+#define STRING_POOL_INITIAL_SIZE  4096
+#define DESTINATION_TABLE_SLOTS   64           // Initial hash slots, a power of two
+
+// A string stored in a StringPool, null-terminated at data[offset + length]
+typedef struct PoolString {
+    uint32_t offset;
+    uint32_t length;
+} PoolString;
+
+// Append-only byte pool; emptied by setting used to 0
+typedef struct StringPool {
+    char  *data;
+    size_t used;
+    size_t capacity;
+} StringPool;
+
+// Open-addressed hash table of interned destinations. Ids are dense and
+// index names and hashes; a slot holds id + 1, or 0 when empty.
+typedef struct DestinationTable {
+    uint32_t   *slots;
+    uint32_t    slotCount;
+    uint32_t    count;      // Destinations interned, the next id
+    uint32_t    capacity;   // Entries in names and hashes
+    PoolString *names;
+    uint32_t   *hashes;
+    StringPool  pool;
+} DestinationTable;
+
+// One party in columns; row i of every column is client i
+typedef struct PartyBatch {
+    uint32_t    destinationId;   // PARTY_NO_DESTINATION until the destination arrives
+    int         count;
+    int         capacity;
+    int        *ages;
+    PoolString *firstNames;
+    PoolString *lastNames;
+    PoolString *addresses;
+    StringPool  strings;
+} PartyBatch;
+
+// Age statistics of a party
+typedef struct AgeStats {
+    int    min;
+    int    max;
+    double mean;
+} AgeStats;
+
+uint32_t    destinationIntern(DestinationTable *table, const char *name, size_t length);
+const char *destinationName(const DestinationTable *table, uint32_t id);
+void        destinationTableFree(DestinationTable *table);
+
+int         partyBatchAdd(PartyBatch *batch, const Client *client);
+const char *partyBatchString(const PartyBatch *batch, PoolString string);
+void        partyBatchClient(const PartyBatch *batch, int row, Client *client);
+AgeStats    partyBatchAgeStats(const PartyBatch *batch);
+void        partyBatchReset(PartyBatch *batch);
+void        partyBatchFree(PartyBatch *batch);
+
+#endif   // PARTYBATCH_H
@@ -0,0 +1,34 @@
+/*
+ * FILE: pattern.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * pattern.h declares the registry of precompiled input patterns used by the
+ * client's validators. Each pattern is compiled once and matched through a
+ * handle. Anchored literal patterns such as "^party$" never reach the regex
+ * engine; they are matched with a length check and memcmp.
+*/
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include <regex.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define MAX_PATTERNS       16   // Distinct patterns the registry can hold
+#define MAX_PATTERN_LEN    64   // Longest pattern source kept for lookups
+
+// A compiled pattern handle
+typedef struct Pattern {
+    char    source[MAX_PATTERN_LEN];
+    bool    isLiteral;              // "^text$" with no regex metacharacters
+    char    literal[MAX_PATTERN_LEN];
+    size_t  literalLength;
+    regex_t regex;                  // Compiled only when isLiteral is false
+} Pattern;
+
+const Pattern *patternCompile(const char *source);
+bool           patternMatches(const Pattern *pattern, const char *string, size_t length);
+void           patternRegistryFree(void);
+
+#endif   // PATTERN_H
@@ -0,0 +1,148 @@
+/*
+ * FILE: protocol.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * protocol.h defines the binary wire format used between the client and the
+ * server, along with the text format ("FirstName,LastName,Age,Address")
+ * helpers that are kept for debugging.
+ *
+ * A binary frame is a fixed WireHeader followed by length bytes of payload.
+ * Frames start with WIRE_MAGIC, a byte that never appears in the ASCII text
+ * protocol, so the server detects the format of every record on its own and
+ * both formats can share the FIFO.
+ *
+ * Payloads (integers in native byte order, the FIFO never leaves the host):
+ *  WIRE_PARTY, WIRE_END, WIRE_STOP: empty
+ *  WIRE_DEST:   u16 length, destination bytes
+ *  WIRE_CLIENT: u8 length, first name, u8 length, last name, i32 age,
+ *               u16 length, address bytes
+ *  WIRE_HELLO:  u32 pid of a client whose private session FIFO
+ *               (SESSION_FIFO_FORMAT) is ready to be opened by the server.
+ *               A client resuming a session it lost in a server restart
+ *               adds u64 resume: the records the server had acknowledged.
+ *               A client sending its records through shared memory
+ *               (shmring.h) adds u64 resume (WIRE_NEW_SESSION if new) and
+ *               u32 flags with WIRE_HELLO_SHM set. The text form is
+ *               "session <pid> [resume] [shm]".
+ *  WIRE_QUERY:  u32 pid of a client whose reply FIFO (REPLY_FIFO_FORMAT) is
+ *               open for reading. The server writes a tab-separated
+ *               snapshot of its destination statistics to it and closes it.
+ *  WIRE_METRICS: u32 pid, like WIRE_QUERY, but the server answers with
+ *               its runtime metrics in Prometheus text format (metrics.h).
+ *  WIRE_ACK:    WireAck, written by the server to the reply FIFO of a
+ *               session after the journal commit that made the session's
+ *               records durable. Counts are cumulative, so a reader only
+ *               needs the latest ACK.
+ *  WIRE_BATCH:  WireBatchHeader, then a fragment of a whole party encoded as
+ *               PARTY, DEST, CLIENT..., END frames. Fragments with the same
+ *               batchId are joined in sequence order and replayed when the
+ *               WIRE_BATCH_LAST chunk arrives.
+*/
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "shared.h"
+
+#define WIRE_MAGIC          0xA5   // First byte of every binary frame
+#define WIRE_VERSION        1
+#define WIRE_MAX_FRAME_SIZE 4096   // Header + payload
+#define WIRE_MAX_BATCH_SIZE (4 * 1024 * 1024)   // Reassembled party limit
+#define QUERY_TIMEOUT_MS    5000                // Client wait for a WIRE_QUERY or WIRE_METRICS reply
+#define QUERY_READ_SIZE     (64 * 1024)         // Reply bytes read per read()
+#define ACK_WINDOW_SIZE     64      // Session records a client keeps in flight
+#define ACK_TIMEOUT_MS      30000   // Client wait for the server to acknowledge anything
+#define ACK_RESUME_ATTEMPTS 3       // Reconnects tried when the server goes away mid-session
+#define SESSION_OPEN_POLL_MS 10     // Client retry interval while no server has opened its session FIFO
+
+// Message types carried in WireHeader.type
+typedef enum WireMessageType {
+    WIRE_TEXT   = 0,   // Newline-terminated text record (not a binary frame)
+    WIRE_PARTY  = 1,
+    WIRE_DEST   = 2,
+    WIRE_CLIENT = 3,
+    WIRE_END    = 4,
+    WIRE_STOP   = 5,
+    WIRE_BATCH  = 6,
+    WIRE_HELLO  = 7,
+    WIRE_QUERY  = 8,
+    WIRE_ACK    = 9,
+    WIRE_METRICS = 10
+} WireMessageType;
+
+// Fixed header at the start of every binary frame
+typedef struct WireHeader {
+    uint8_t  magic;      // WIRE_MAGIC
+    uint8_t  version;    // WIRE_VERSION
+    uint8_t  type;       // WireMessageType
+    uint8_t  reserved;   // Always 0
+    uint32_t length;     // Payload bytes following the header
+} WireHeader;
+
+// Prefix of every WIRE_BATCH payload
+typedef struct WireBatchHeader {
+    uint32_t batchId;    // Unique per sending client (its pid)
+    uint16_t sequence;   // Chunk number, starting at 0 for every party
+    uint16_t flags;      // WIRE_BATCH_LAST on the final chunk
+} WireBatchHeader;
+
+#define WIRE_BATCH_LAST 0x0001
+
+#define WIRE_NEW_SESSION UINT64_MAX   // HELLO resume count of a session that is not resumed
+#define WIRE_HELLO_SHM   0x0001       // HELLO flag: records arrive through the client's ring
+
+// WIRE_ACK payload: records read from a session so far, in the order the
+// client wrote them (text lines, frames and batch chunks count one each)
+typedef struct WireAck {
+    uint64_t records;    // Records handled (and journaled) so far
+    uint64_t rejected;   // Records or batched frames among them that were discarded
+} WireAck;
+
+#define WIRE_HEADER_SIZE         sizeof(WireHeader)
+#define WIRE_MAX_PAYLOAD_SIZE    (WIRE_MAX_FRAME_SIZE - WIRE_HEADER_SIZE)
+#define WIRE_MAX_FRAGMENT_SIZE   (WIRE_MAX_PAYLOAD_SIZE - sizeof(WireBatchHeader))
+#define WIRE_MAX_CLIENT_FRAME    (WIRE_HEADER_SIZE + 1 + MAX_NAME_LEN + 1 + MAX_NAME_LEN \
+                                  + sizeof(int32_t) + sizeof(uint16_t) + MAX_ADDRESS_LEN)
+
+// Frames must fit in PIPE_BUF so that every write() of one frame is atomic
+_Static_assert(WIRE_MAX_FRAME_SIZE <= PIPE_BUF, "wire frames must be written atomically");
+
+// Binary frame encoders - return the frame size, or 0 if out is too small
+size_t wireEncodeControl(char *out, size_t outSize, WireMessageType type);
+size_t wireEncodeDestination(char *out, size_t outSize, const Trip *trip);
+size_t wireEncodeClient(char *out, size_t outSize, const Client *client);
+size_t wireEncodeTrip(char *out, size_t outSize, const Trip *trip);
+size_t wireEncodeHello(char *out, size_t outSize, long pid, uint64_t resume, uint32_t flags);
+size_t wireEncodeQuery(char *out, size_t outSize, long pid);
+size_t wireEncodeMetrics(char *out, size_t outSize, long pid);
+size_t wireEncodeAck(char *out, size_t outSize, const WireAck *ack);
+size_t wireTripSizeBound(const Trip *trip);
+
+// Binary payload decoders (payload excludes the header)
+bool wireDecodeDestination(const char *payload, size_t length, Trip *trip);
+bool wireDecodeClient(const char *payload, size_t length, Client *client);
+bool wireDecodeHello(const char *payload, size_t length, long *pid, uint64_t *resume,
+                     uint32_t *flags);
+bool wireDecodeQuery(const char *payload, size_t length, long *pid);
+bool wireDecodeAck(const char *payload, size_t length, WireAck *ack);
+bool wireNextFrame(const char **cursor, const char *end, WireHeader *header,
+                   const char **payload);
+
+// Text record decoders for "FirstName,LastName,Age,Address" and "session <pid> [resume] [shm]"
+bool textDecodeClient(const char *record, size_t length, Client *client);
+bool textDecodeHello(const char *record, size_t length, long *pid, uint64_t *resume,
+                     uint32_t *flags);
+
+// Paths of the private FIFOs of a client
+int sessionFifoPath(char *out, size_t outSize, long pid);
+int replyFifoPath(char *out, size_t outSize, long pid);
+
+const char *wireTypeName(int type);
+
+#endif   // PROTOCOL_H
@@ -1,78 +1,92 @@
-/*
- * FILE: shared.h
- * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca, Tuan Thanh Nguyen, George S.
- * PROJECT: SENG2031 - Assignment 1
- * DESCRIPTION:
- * shared.h contains shared definitions, structs, and function declarations
- * used by both the client and server programs.
-*/
-#ifndef SHARED_H
-#define SHARED_H
-
-// FIFO definitions ----> Not sure which one to use for final copy
-#define FIFO_PATH           "./travel_agency_fifo"
-#define PERM_OWNER_RW       0600   // (Owner: rw, Group: --, Other: --)
-#define PERM_OWNER_RW_ALL_R 0644   // (Owner: rw, Group: r-, Other: r-)
-#define PERM_ALL_RW         0666   // (Owner: rw, Group: rw, Other: rw)
-#define PERM_ALL_RWX        0777   // (Owner: rwx, Group: rwx, Other: rwx)
-
-// General purpose defines
-#define MAX_BUFFER_SIZE 256
-
-// Regex patterns for input validation (*: 0 or more, +: 1 or more)
-#define REGEX_NAME   "^[A-Z][a-z]* [A-Z][a-z]*$"   // Format: Firstname Lastname
-#define REGEX_NUMBER "^[0-9]+$"   // Format: Numbers only, At least one digit
-
-// Client field defines
-#define MAX_NAME_LEN        50
-#define MAX_ADDRESS_LEN     200
-#define MAX_DESTINATION_LEN 200
-#define MIN_CLIENT_AGE      18
-#define MAX_CLIENT_AGE      125
-#define MAX_CLIENTS         100
-#define MAX_AGE_STR_LEN     8
-
-// Constant return codes
-#define SUCCESS       0
-#define ERROR        -1
-
-// Constant for timeout duration (in seconds)
-#define TIMEOUT_DURATION 120
-#define CANCEL_TIMEOUT   0
-#define TIMEOUT_SUCCESSFUL 0
-
-// Constants for buffer size
-#define BUFFER_SIZE_OF_ZERO 0
-#define BUFFER_SIZE_OF_ONE 1
-#define BUFFER_SIZE_OF_TWO 2
-#define BUFFER_SIZE_OF_THREE 3
-#define BUFFER_SIZE_OF_FOUR 4
-
-// Constants for summary size
-#define SUMMARY_SIZE 512
-
-// Define of Client struct
-typedef struct Client {
-    char firstName[MAX_NAME_LEN];
-    char lastName[MAX_NAME_LEN];
-    int  age;
-    char address[MAX_ADDRESS_LEN];
-} Client;
-
-// Define of Party struct
-typedef struct Trip {
-    char   destination[MAX_DESTINATION_LEN];
-    int    numberOfClients;
-    Client clients[MAX_CLIENTS];   // Change to dynamic array?
-} Trip;
-
-// Stream-based input gathering functions
-int clearStream(FILE *stream);
-int getInputFromStream(FILE *stream, char *destination, size_t bufSize, bool keepNewline);
-
-// Validation Utility Functions
-void printInputError(const char *fieldName, int errorCode, size_t bufSize);
-bool isNullTerminated(const char *buffer, size_t bufSize);
-bool stringMatchesRegex(const char *string, size_t bufSize, const char *pattern);
-
-#endif   // SHARED_H
+/*
+ * FILE: shared.h
+ * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca, Tuan Thanh Nguyen, George S.
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * shared.h contains shared definitions, structs, and function declarations
+ * used by both the client and server programs.
+*/
+#ifndef SHARED_H
+#define SHARED_H
+
+#include "arena.h"
+
+// FIFO definitions ----> Not sure which one to use for final copy
+#define FIFO_PATH           "./travel_agency_fifo"
+#define SESSION_FIFO_FORMAT FIFO_PATH ".%ld"   // Private per-client FIFO, %ld = client pid
+#define REPLY_FIFO_FORMAT   FIFO_PATH ".%ld.reply"   // Server to client replies, %ld = client pid
+#define MAX_FIFO_PATH_LEN   64
+#define PERM_OWNER_RW       0600   // (Owner: rw, Group: --, Other: --)
+#define PERM_OWNER_RW_ALL_R 0644   // (Owner: rw, Group: r-, Other: r-)
+#define PERM_ALL_RW         0666   // (Owner: rw, Group: rw, Other: rw)
+#define PERM_ALL_RWX        0777   // (Owner: rwx, Group: rwx, Other: rwx)
+
+// General purpose defines
+#define MAX_BUFFER_SIZE 256
+#define CACHE_LINE_SIZE 64   // Keeps data written by different threads apart
+
+// Regex patterns for input validation (*: 0 or more, +: 1 or more)
+#define REGEX_NAME   "^[A-Z][a-z]* [A-Z][a-z]*$"   // Format: Firstname Lastname
+#define REGEX_NUMBER "^[0-9]+$"   // Format: Numbers only, At least one digit
+
+// Client field defines
+#define MAX_NAME_LEN        50
+#define MAX_ADDRESS_LEN     200
+#define MAX_DESTINATION_LEN 200
+#define MIN_CLIENT_AGE      18
+#define MAX_CLIENT_AGE      125
+#define MAX_AGE_STR_LEN     8
+
+// Constant return codes
+#define SUCCESS       0
+#define ERROR        -1
+
+// Constant for timeout duration (in seconds)
+#define TIMEOUT_DURATION 120
+#define CANCEL_TIMEOUT   0
+#define TIMEOUT_SUCCESSFUL 0
+
+// Constants for buffer size
+#define BUFFER_SIZE_OF_ZERO 0
+#define BUFFER_SIZE_OF_ONE 1
+#define BUFFER_SIZE_OF_TWO 2
+#define BUFFER_SIZE_OF_THREE 3
+#define BUFFER_SIZE_OF_FOUR 4
+
+// Constants for summary size
+#define SUMMARY_SIZE 512
+
+// Define of Client struct
+typedef struct Client {
+    char firstName[MAX_NAME_LEN];
+    char lastName[MAX_NAME_LEN];
+    int  age;
+    char address[MAX_ADDRESS_LEN];
+} Client;
+
+// Clients reserved by the first tripAddClient() of a party
+#define TRIP_INITIAL_CLIENTS 8
+
+// Define of Party struct
+typedef struct Trip {
+    char    destination[MAX_DESTINATION_LEN];
+    int     numberOfClients;
+    int     clientCapacity;
+    Client *clients;   // Grows in arena, see tripAddClient()
+    Arena  *arena;     // Per-party storage, emptied by tripReset()
+} Trip;
+
+// Trip client list functions
+void    tripInit(Trip *trip, Arena *arena);
+Client *tripAddClient(Trip *trip);
+void    tripReset(Trip *trip);
+
+// Stream-based input gathering functions
+int clearStream(FILE *stream);
+int getInputFromStream(FILE *stream, char *destination, size_t bufSize, bool keepNewline);
+
+// Validation Utility Functions
+void printInputError(const char *fieldName, int errorCode, size_t bufSize);
+bool isNullTerminated(const char *buffer, size_t bufSize);
+
+#endif   // SHARED_H
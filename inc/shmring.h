@@ -0,0 +1,82 @@
+/*
+ * FILE: shmring.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * shmring.h declares the shared memory transport for session records. A
+ * client that connects with --shm creates a POSIX shared memory segment
+ * (SHM_RING_NAME_FORMAT with its pid) holding a single-producer,
+ * single-consumer ring of fixed-size slots, and the server maps it when the
+ * session registers. Each record (text line, frame or batch chunk) is
+ * copied into one slot, so sending it costs no syscall.
+ *
+ * The session FIFO stays open next to the ring. The server sleeps in epoll
+ * on it as before: a client writes a one-byte doorbell to it only when the
+ * server has flagged that it drained the ring and went idle, and closing it
+ * still ends the session. A client that finds the ring full spins briefly,
+ * then sleeps on a futex the server wakes after freeing slots.
+*/
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "protocol.h"
+
+#define SHM_RING_NAME_FORMAT "/travel_agency_ring.%ld"   // %ld = client pid
+#define SHM_RING_MAGIC       0x474E4952u                 // "RING"
+#define SHM_RING_SLOTS       32                          // Must be a power of two
+#define SHM_RING_SLOT_SIZE   WIRE_MAX_FRAME_SIZE         // Largest record
+#define SHM_RING_SPINS       1000                        // Polls of a full ring before sleeping
+#define SHM_RING_WAIT_MS     100                         // Wait on a full ring between server checks
+#define SHM_RING_DOORBELL    '\n'                        // Byte written to wake the server
+
+// Outcome of shmRingPush()
+typedef enum ShmRingStatus {
+    SHM_RING_PUSHED,   // Record is in the ring, the server is awake
+    SHM_RING_WAKE,     // Record is in the ring, ring the doorbell
+    SHM_RING_FULL      // No slot freed up within the timeout
+} ShmRingStatus;
+
+// One record slot
+typedef struct ShmRingSlot {
+    uint32_t length;
+    char     data[SHM_RING_SLOT_SIZE];
+} ShmRingSlot;
+
+// Layout of the shared segment. head and tail count records since the
+// ring was created; slot n is slots[n % SHM_RING_SLOTS]. Each index lives
+// on its own cache line so producer and consumer never share one.
+typedef struct ShmRingShared {
+    uint32_t magic;
+    uint32_t slotCount;
+    uint32_t slotSize;
+    alignas(CACHE_LINE_SIZE) atomic_uint head;   // Next slot the client fills
+    atomic_uint consumerSleeping;                 // Server wants a doorbell for the next record
+    alignas(CACHE_LINE_SIZE) atomic_uint tail;   // Next slot the server reads, futex word
+    atomic_uint producerSleeping;                 // Client waits on tail for a free slot
+    alignas(CACHE_LINE_SIZE) ShmRingSlot slots[SHM_RING_SLOTS];
+} ShmRingShared;
+
+_Static_assert(sizeof(atomic_uint) == sizeof(uint32_t), "futex words must be 32 bits");
+
+// A mapped ring; shared is NULL when the session uses the FIFO alone
+typedef struct ShmRing {
+    ShmRingShared *shared;
+    bool           owner;   // The creating client unlinks the segment on close
+    long           pid;
+} ShmRing;
+
+int           shmRingCreate(ShmRing *ring, long pid);
+int           shmRingAttach(ShmRing *ring, long pid);
+void          shmRingClose(ShmRing *ring);
+ShmRingStatus shmRingPush(ShmRing *ring, const void *record, size_t length, int timeoutMs);
+const char   *shmRingPeek(ShmRing *ring, size_t *length);
+void          shmRingRelease(ShmRing *ring);
+bool          shmRingSleep(ShmRing *ring);
+
+#endif   // SHMRING_H
@@ -0,0 +1,78 @@
+/*
+ * FILE: snapshot.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * snapshot.h declares the server state snapshot written next to the
+ * journal (journal.h). A snapshot holds the interned destinations with
+ * their statistics and every open client session (its acknowledged record
+ * count and party in progress), plus the sequence number of the last
+ * journal record it covers. Its size depends on the number of destinations
+ * and open sessions, not on how much history has been received, so restart
+ * time stays flat.
+ *
+ * Layout after the 64-byte SnapshotHeader:
+ *   destinationCount x { u32 name length, name bytes, DestinationStats }
+ *   sessionCount x { SnapshotSessionRecord, client count x WIRE_CLIENT frame }
+*/
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aggregate.h"
+#include "partybatch.h"
+
+#define SNAPSHOT_PATH        "travel_agency.snapshot"
+#define SNAPSHOT_TEMP_SUFFIX ".tmp"
+#define SNAPSHOT_MAGIC       "TASNAP01"
+#define SNAPSHOT_MAGIC_LEN   8
+#define SNAPSHOT_VERSION     2
+#define SNAPSHOT_HEADER_SIZE 64
+
+typedef struct SnapshotHeader {
+    char     magic[SNAPSHOT_MAGIC_LEN];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t sequence;           // Last journal record included
+    uint64_t length;             // Bytes after the header
+    uint32_t destinationCount;
+    uint32_t sessionCount;
+    uint32_t checksum;           // journalChecksum() of the bytes after the header
+    uint32_t reserved32;
+    int64_t  created;
+    uint8_t  reserved[8];
+} SnapshotHeader;
+
+_Static_assert(sizeof(SnapshotHeader) == SNAPSHOT_HEADER_SIZE, "snapshot header must be 64 bytes");
+
+// Fixed part of a saved session
+typedef struct SnapshotSessionRecord {
+    uint32_t pid;
+    uint32_t inParty;         // 1 if a party is in progress
+    uint64_t records;         // Session records acknowledged
+    uint32_t destinationId;   // PARTY_NO_DESTINATION outside a party
+    uint32_t clientCount;     // WIRE_CLIENT frames that follow
+} SnapshotSessionRecord;
+
+_Static_assert(sizeof(SnapshotSessionRecord) == 24, "snapshot session record must be 24 bytes");
+
+// An open session to save
+typedef struct SnapshotSession {
+    long              pid;
+    uint64_t          records;
+    const PartyBatch *batch;   // NULL when no party is in progress
+} SnapshotSession;
+
+// Returns the batch snapshotLoad() should restore the session of pid into
+// (its party, when inParty), or NULL if the session cannot be restored
+typedef PartyBatch *(*SnapshotClaim)(void *context, long pid, uint64_t records, bool inParty);
+
+int snapshotWrite(const char *path, uint64_t sequence, const DestinationTable *destinations,
+                  const AggregateIndex *index, const SnapshotSession *sessions, size_t sessionCount);
+int snapshotLoad(const char *path, uint64_t *sequence, DestinationTable *destinations,
+                 AggregateIndex *index, SnapshotClaim claim, void *context);
+
+#endif   // SNAPSHOT_H
@@ -0,0 +1,65 @@
+/*
+ * FILE: stagequeue.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * stagequeue.h declares the bounded queues between the server's pipeline
+ * threads (see server.c). A queue has exactly one producer and one
+ * consumer thread and holds fixed-size items in a power-of-two ring. Items
+ * are filled and read in place, and head and tail are atomics on cache
+ * lines of their own, so passing an item takes no lock and no syscall.
+ *
+ * A consumer with nothing to read, or a producer facing a full queue,
+ * sleeps on a StageSignal. The other side only takes the signal's lock
+ * when it sees the sleeping flag, the same handshake the logger's writer
+ * thread uses (logger.c). Several queues may share a consumer signal, so
+ * one thread can sleep until any of its queues has work.
+*/
+#ifndef STAGEQUEUE_H
+#define STAGEQUEUE_H
+
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "shared.h"
+
+// Where a pipeline thread sleeps
+typedef struct StageSignal {
+    atomic_bool     sleeping;
+    pthread_mutex_t lock;
+    pthread_cond_t  condition;
+} StageSignal;
+
+// Tells a sleeping thread whether it can go on
+typedef bool (*StageReady)(void *context);
+
+typedef struct StageQueue {
+    char        *items;
+    size_t       itemSize;
+    size_t       capacity;   // Items, a power of two
+    StageSignal *consumer;   // Woken when an item is published, may be shared; NULL if never waited on
+    StageSignal  producer;   // The producer sleeps here while the queue is full
+    alignas(CACHE_LINE_SIZE) atomic_size_t head;   // Next item the consumer reads
+    alignas(CACHE_LINE_SIZE) atomic_size_t tail;   // Next item the producer fills
+} StageQueue;
+
+int   stageSignalInit(StageSignal *signal);
+void  stageSignalDestroy(StageSignal *signal);
+void  stageSignalWake(StageSignal *signal);
+void  stageSignalWait(StageSignal *signal, StageReady ready, void *context);
+
+int   stageQueueInit(StageQueue *queue, size_t capacity, size_t itemSize, StageSignal *consumer);
+void  stageQueueFree(StageQueue *queue);
+void *stageQueueReserve(StageQueue *queue, bool wait);
+void  stageQueuePublish(StageQueue *queue);
+void *stageQueuePeek(StageQueue *queue);
+void  stageQueueRelease(StageQueue *queue);
+bool  stageQueueReadable(void *queue);
+size_t stageQueueMark(StageQueue *queue);
+bool  stageQueueConsumed(StageQueue *queue, size_t mark);
+
+#endif   // STAGEQUEUE_H
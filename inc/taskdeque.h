@@ -0,0 +1,38 @@
+/*
+ * FILE: taskdeque.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * taskdeque.h declares the work-stealing queues of the server's parser
+ * threads (see server.c). Each thread owns one TaskDeque of session slots
+ * waiting for a turn. Only the owner adds to the bottom; the owner and any
+ * idle thread take from the top with a compare-and-swap, so a thread with
+ * nothing to do steals the sessions that waited longest elsewhere. The
+ * owner taking from the top as well gives its sessions turns in order
+ * instead of running the busiest one again straight away.
+*/
+#ifndef TASKDEQUE_H
+#define TASKDEQUE_H
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "shared.h"
+
+typedef struct TaskDeque {
+    atomic_int *tasks;
+    size_t      capacity;   // Tasks, a power of two
+    alignas(CACHE_LINE_SIZE) atomic_size_t top;      // Next task taken, by the owner or a thief
+    alignas(CACHE_LINE_SIZE) atomic_size_t bottom;   // Next slot the owner fills
+} TaskDeque;
+
+int    taskDequeInit(TaskDeque *deque, size_t capacity);
+void   taskDequeFree(TaskDeque *deque);
+int    taskDequePush(TaskDeque *deque, int task);
+bool   taskDequeTake(TaskDeque *deque, int *task);
+size_t taskDequeDepth(TaskDeque *deque);
+
+#endif   // TASKDEQUE_H
@@ -0,0 +1,49 @@
+/*
+ * FILE: transport.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * transport.h declares how client sessions reach the server. Besides the
+ * session FIFOs (optionally with a shared memory ring, see shmring.h) the
+ * server can listen on an AF_UNIX stream socket and on a loopback TCP port.
+ * A socket connection carries the same records as a session FIFO, after a
+ * HELLO that names the client, and the server acknowledges them on the
+ * same connection. TCP listeners set SO_REUSEPORT, so several server
+ * processes can share a port and have the kernel spread connections across
+ * them. Each must run in its own directory, with its own journal, snapshot,
+ * log and FIFOs: a server locks its directory at startup and refuses to
+ * start where another is running.
+*/
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRANSPORT_LOOPBACK       "127.0.0.1"
+#define TRANSPORT_LISTEN_BACKLOG 128
+#define TRANSPORT_RETRY_MS       100   // Wait between connects while the server (re)starts
+
+// Session transport chosen on the command line
+typedef enum TransportKind {
+    TRANSPORT_FIFO,   // Private session FIFO registered on the shared FIFO
+    TRANSPORT_SHM,    // Session FIFO for doorbells, records in a shared memory ring (--shm)
+    TRANSPORT_UNIX,   // AF_UNIX stream socket (--socket PATH)
+    TRANSPORT_TCP     // Loopback TCP connection (--tcp PORT)
+} TransportKind;
+
+typedef struct TransportAddress {
+    TransportKind kind;
+    const char   *path;   // TRANSPORT_UNIX socket path
+    uint16_t      port;   // TRANSPORT_TCP port on TRANSPORT_LOOPBACK
+} TransportAddress;
+
+bool transportIsSocket(const TransportAddress *address);
+int  transportParsePort(const char *text, uint16_t *port);
+int  transportListen(const TransportAddress *address);
+int  transportAccept(int listenFd);
+int  transportConnect(const TransportAddress *address, int timeoutMs);
+void transportDescribe(const TransportAddress *address, char *out, size_t size);
+
+#endif   // TRANSPORT_H
@@ -0,0 +1,27 @@
+/*
+ * FILE: validate.h
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * validate.h declares the single-pass input scanners used by the client's
+ * name and age validators. They accept exactly what REGEX_NAME and
+ * REGEX_NUMBER accept, without going through the regex engine, and the
+ * name scanner reports where the name splits so it is never rescanned.
+*/
+#ifndef VALIDATE_H
+#define VALIDATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Where a "Firstname Lastname" input splits
+typedef struct NameSplit {
+    size_t firstLength;   // Bytes before the space
+    size_t lastOffset;    // First byte after the space
+    size_t lastLength;    // Bytes from lastOffset to the end
+} NameSplit;
+
+bool scanClientName(const char *buffer, size_t length, NameSplit *split);
+bool scanDigits(const char *buffer, int *result);
+
+#endif   // VALIDATE_H
@@ -0,0 +1,149 @@
+/*
+ * FILE: ackwindow.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Keeps the unacknowledged records of a client session and reads the
+ * server's cumulative WIRE_ACK frames from the reply FIFO. The window only
+ * tracks records; writing them and reopening sessions is up to the client.
+*/
+
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ackwindow.h"
+#include "shared.h"
+
+/*
+ * FUNCTION: ackWindowReset
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Empties the window for a new session.
+ * PARAMETERS:
+    *  AckWindow *window : Window to reset.
+    *  int replyFd : Non-blocking read end of the reply FIFO, -1 for none.
+ * RETURNS : n/a
+ */
+void ackWindowReset(AckWindow *window, int replyFd) {
+    window->replyFd  = replyFd;
+    window->sent     = 0;
+    window->acked    = 0;
+    window->rejected = 0;
+    window->partial  = 0;
+}
+
+/*
+ * FUNCTION: ackWindowInFlight
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Counts the records written but not yet acknowledged.
+ * PARAMETERS:
+    *  const AckWindow *window : Window to inspect.
+ * RETURNS : size_t - records in flight, at most ACK_WINDOW_SIZE.
+ */
+size_t ackWindowInFlight(const AckWindow *window) {
+    return (size_t)(window->sent - window->acked);
+}
+
+/*
+ * FUNCTION: ackWindowPush
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Keeps a copy of the next record before it is written. The window must not be full.
+ * PARAMETERS:
+    *  AckWindow *window : Window of the session.
+    *  const char *record : Record exactly as it is written to the FIFO.
+    *  size_t length : Record size, at most WIRE_MAX_FRAME_SIZE.
+ * RETURNS : int - SUCCESS, or ERROR if the window is full or the record too large.
+ */
+int ackWindowPush(AckWindow *window, const char *record, size_t length) {
+    if (ackWindowInFlight(window) >= ACK_WINDOW_SIZE || length > WIRE_MAX_FRAME_SIZE) {
+        return ERROR;
+    }
+    size_t slot = (size_t)(window->sent % ACK_WINDOW_SIZE);
+    memcpy(window->records[slot], record, length);
+    window->lengths[slot] = length;
+    window->sent++;
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: ackWindowRecord
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Returns an unacknowledged record so it can be written again.
+ * PARAMETERS:
+    *  const AckWindow *window : Window of the session.
+    *  uint64_t number : Record number, from window->acked to window->sent - 1.
+    *  size_t *length : Receives the record size.
+ * RETURNS : const char * - the record, or NULL if it is not in the window.
+ */
+const char *ackWindowRecord(const AckWindow *window, uint64_t number, size_t *length) {
+    if (number < window->acked || number >= window->sent) {
+        return NULL;
+    }
+    size_t slot = (size_t)(number % ACK_WINDOW_SIZE);
+    *length     = window->lengths[slot];
+    return window->records[slot];
+}
+
+/*
+ * FUNCTION: ackWindowPoll
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Waits up to timeoutMs for the reply FIFO and reads every WIRE_ACK in
+    *  it. Acknowledgements are cumulative, so the highest count wins; a
+    *  count beyond the records sent (a resumed session) is clamped.
+ * PARAMETERS:
+    *  AckWindow *window : Window of the session.
+    *  int timeoutMs : Longest wait, 0 to only read what has arrived.
+ * RETURNS : AckStatus - ACK_RECEIVED, ACK_WAITING on timeout, ACK_HANGUP once the server closed its end.
+ */
+AckStatus ackWindowPoll(AckWindow *window, int timeoutMs) {
+    struct pollfd reply = { .fd = window->replyFd, .events = POLLIN };
+    int           ready;
+    do {
+        ready = poll(&reply, 1, timeoutMs);
+    } while (ready == -1 && errno == EINTR);
+    if (ready == 0) {
+        return ACK_WAITING;
+    }
+    if (ready == -1 || !(reply.revents & POLLIN)) {
+        return ACK_HANGUP;   // POLLHUP without data: no server is writing any more
+    }
+    
+    bool received = false;
+    for (;;) {
+        ssize_t bytesRead = read(window->replyFd, window->input + window->partial,
+                                 sizeof(window->input) - window->partial);
+        if (bytesRead == -1 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead == -1 && errno == EAGAIN) {
+            return received ? ACK_RECEIVED : ACK_WAITING;
+        }
+        if (bytesRead <= 0) {
+            return received ? ACK_RECEIVED : ACK_HANGUP;
+        }
+        
+        const char *cursor = window->input;
+        const char *end    = window->input + window->partial + (size_t)bytesRead;
+        const char *payload;
+        WireHeader  header;
+        WireAck     ack;
+        while (wireNextFrame(&cursor, end, &header, &payload)) {
+            if (header.type == WIRE_ACK && wireDecodeAck(payload, header.length, &ack)
+                && ack.records >= window->acked) {
+                window->acked    = ack.records < window->sent ? ack.records : window->sent;
+                window->rejected = ack.rejected;
+                received         = true;
+            }
+        }
+        
+        // Keep a frame split across reads; anything that cannot become one is dropped
+        window->partial = (size_t)(end - cursor);
+        if (window->partial >= ACK_FRAME_SIZE) {
+            window->partial = 0;
+        }
+        memmove(window->input, cursor, window->partial);
+    }
+}
@@ -0,0 +1,170 @@
+/*
+ * FILE: aggregate.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Incremental per-destination statistics for the server and the
+ * tab-separated snapshot returned for a WIRE_QUERY.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "aggregate.h"
+
+#define SNAPSHOT_NUMBER_WIDTH 21   // Tab plus the digits of an unsigned long
+#define SNAPSHOT_TIME_FORMAT  "%Y-%m-%dT%H:%M:%S"
+#define SNAPSHOT_TIME_LEN     32
+
+/*
+ * FUNCTION: aggregateAddClient
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Counts a client and its age bucket for a destination.
+ * PARAMETERS:
+    *  AggregateIndex *index : Index to update.
+    *  uint32_t destinationId : Id from the server's DestinationTable.
+    *  int age : Client age; ages outside MIN_CLIENT_AGE..MAX_CLIENT_AGE go in the end buckets.
+    *  time_t now : Arrival time.
+ * RETURNS : int - SUCCESS, or ERROR if the index could not grow.
+ */
+int aggregateAddClient(AggregateIndex *index, uint32_t destinationId, int age, time_t now) {
+    DestinationStats *entry = aggregateEntry(index, destinationId);
+    if (!entry) {
+        return ERROR;
+    }
+
+    int bucket = (age - MIN_CLIENT_AGE) / AGE_BUCKET_WIDTH;
+    if (age < MIN_CLIENT_AGE) {
+        bucket = 0;
+    } else if (bucket >= AGE_BUCKET_COUNT) {
+        bucket = AGE_BUCKET_COUNT - 1;
+    }
+    entry->clients++;
+    entry->ageBuckets[bucket]++;
+    entry->lastSeen = now;
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: aggregateAddParty
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Counts a completed party for a destination.
+ * PARAMETERS:
+    *  AggregateIndex *index : Index to update.
+    *  uint32_t destinationId : Id from the server's DestinationTable.
+    *  time_t now : Completion time.
+ * RETURNS : int - SUCCESS, or ERROR if the index could not grow.
+ */
+int aggregateAddParty(AggregateIndex *index, uint32_t destinationId, time_t now) {
+    DestinationStats *entry = aggregateEntry(index, destinationId);
+    if (!entry) {
+        return ERROR;
+    }
+    entry->parties++;
+    entry->lastSeen = now;
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: aggregateSnapshot
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Formats every destination seen so far as tab-separated text: a header
+    *  row, then one row per destination with its parties, clients, last
+    *  seen time (local, ISO 8601) and one column per age bucket.
+ * PARAMETERS:
+    *  const AggregateIndex *index : Statistics to format.
+    *  const DestinationTable *destinations : Names of the destination ids.
+    *  size_t *length : Receives the snapshot length.
+ * RETURNS : char * - malloc'd snapshot for the caller to free, or NULL if memory ran out.
+ */
+char *aggregateSnapshot(const AggregateIndex *index, const DestinationTable *destinations,
+                        size_t *length) {
+    const size_t numberColumns = AGE_BUCKET_COUNT + BUFFER_SIZE_OF_TWO;
+    size_t       size          = (numberColumns + 1) * SNAPSHOT_NUMBER_WIDTH + SNAPSHOT_TIME_LEN;
+    uint32_t     count         = index->capacity < destinations->count ? index->capacity
+                                                                       : destinations->count;
+    for (uint32_t id = 0; id < count; id++) {
+        size += destinations->names[id].length + numberColumns * SNAPSHOT_NUMBER_WIDTH
+              + SNAPSHOT_TIME_LEN;
+    }
+
+    char *out = malloc(size);
+    if (!out) {
+        return NULL;
+    }
+
+    size_t used = (size_t)snprintf(out, size, "destination\tparties\tclients\tlast_seen");
+    for (int bucket = 0; bucket < AGE_BUCKET_COUNT; bucket++) {
+        int low  = MIN_CLIENT_AGE + bucket * AGE_BUCKET_WIDTH;
+        int high = low + AGE_BUCKET_WIDTH - 1 < MAX_CLIENT_AGE ? low + AGE_BUCKET_WIDTH - 1
+                                                               : MAX_CLIENT_AGE;
+        used += (size_t)snprintf(out + used, size - used, "\t%d-%d", low, high);
+    }
+    out[used++] = '\n';
+
+    for (uint32_t id = 0; id < count; id++) {
+        const DestinationStats *entry = &index->entries[id];
+        if (entry->lastSeen == 0) {
+            continue;   // Interned but nothing counted yet
+        }
+
+        char      lastSeen[SNAPSHOT_TIME_LEN];
+        struct tm local;
+        localtime_r(&entry->lastSeen, &local);
+        strftime(lastSeen, sizeof(lastSeen), SNAPSHOT_TIME_FORMAT, &local);
+
+        used += (size_t)snprintf(out + used, size - used, "%s\t%lu\t%lu\t%s",
+                                 destinationName(destinations, id), entry->parties, entry->clients,
+                                 lastSeen);
+        for (int bucket = 0; bucket < AGE_BUCKET_COUNT; bucket++) {
+            used += (size_t)snprintf(out + used, size - used, "\t%lu", entry->ageBuckets[bucket]);
+        }
+        out[used++] = '\n';
+    }
+
+    *length = used;
+    return out;
+}
+
+/*
+ * FUNCTION: aggregateFree
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Frees the index and leaves it empty.
+ * PARAMETERS:
+    *  AggregateIndex *index : Index to free.
+ * RETURNS : n/a
+ */
+void aggregateFree(AggregateIndex *index) {
+    free(index->entries);
+    memset(index, 0, sizeof(*index));
+}
+
+/*
+ * FUNCTION: aggregateEntry
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Returns the statistics of a destination, growing the index to cover its id.
+ * PARAMETERS:
+    *  AggregateIndex *index : Index to look in.
+    *  uint32_t destinationId : Destination id.
+ * RETURNS : DestinationStats * - the entry, or NULL for PARTY_NO_DESTINATION or if memory ran out.
+ */
+DestinationStats *aggregateEntry(AggregateIndex *index, uint32_t destinationId) {
+    if (destinationId == PARTY_NO_DESTINATION) {
+        return NULL;
+    }
+    if (destinationId >= index->capacity) {
+        uint32_t capacity = index->capacity ? index->capacity : DESTINATION_TABLE_SLOTS;
+        while (capacity <= destinationId) {
+            capacity *= 2;
+        }
+        DestinationStats *entries = realloc(index->entries, sizeof(*entries) * capacity);
+        if (!entries) {
+            return NULL;
+        }
+        memset(entries + index->capacity, 0, sizeof(*entries) * (capacity - index->capacity));
+        index->entries  = entries;
+        index->capacity = capacity;
+    }
+    return &index->entries[destinationId];
+}
@@ -0,0 +1,158 @@
+/*
+ * FILE: arena.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Bump allocator used for the client list of a party. Every allocation is
+ * aligned for any type. Blocks are kept across arenaReset() calls, so a
+ * client or server that handles party after party stops calling malloc
+ * once its arena has grown to fit the largest party.
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+static ArenaBlock *arenaNextBlock(Arena *arena, size_t size);
+
+/*
+ * FUNCTION: arenaAlloc
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Returns size bytes from the arena, moving to another block when the current one is full.
+ * PARAMETERS:
+    *  Arena *arena : Arena to allocate from.
+    *  size_t size : Bytes needed.
+ * RETURNS : void * - max_align_t aligned memory, or NULL if malloc failed.
+ */
+void *arenaAlloc(Arena *arena, size_t size) {
+    // Round up so the next allocation stays aligned
+    size_t rounded = (size + sizeof(max_align_t) - 1) & ~(sizeof(max_align_t) - 1);
+    if (rounded < size) {
+        return NULL;
+    }
+
+    ArenaBlock *block = arena->current;
+    if (!block || block->capacity - block->used < rounded) {
+        if (!(block = arenaNextBlock(arena, rounded))) {
+            return NULL;
+        }
+    }
+
+    void *memory = (char *)block->data + block->used;
+    block->used += rounded;
+    arena->last  = memory;
+    return memory;
+}
+
+/*
+ * FUNCTION: arenaGrow
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Resizes an allocation. The most recent allocation is extended in place
+    *  when its block has room; otherwise a new allocation is made and the
+    *  old bytes copied (the old space is reclaimed at the next reset).
+ * PARAMETERS:
+    *  Arena *arena : Arena old came from.
+    *  void *old : Allocation to grow, or NULL.
+    *  size_t oldSize : Size old was allocated with.
+    *  size_t newSize : Size needed.
+ * RETURNS : void * - the grown allocation, or NULL if malloc failed (old stays valid).
+ */
+void *arenaGrow(Arena *arena, void *old, size_t oldSize, size_t newSize) {
+    ArenaBlock *block = arena->current;
+    if (old && old == arena->last) {
+        size_t newRounded = (newSize + sizeof(max_align_t) - 1) & ~(sizeof(max_align_t) - 1);
+        size_t offset     = (size_t)((char *)old - (char *)block->data);
+        if (newRounded >= newSize && offset + newRounded <= block->capacity) {
+            block->used = offset + newRounded;
+            return old;
+        }
+    }
+
+    void *memory = arenaAlloc(arena, newSize);
+    if (memory && old) {
+        memcpy(memory, old, oldSize);
+    }
+    return memory;
+}
+
+/*
+ * FUNCTION: arenaReset
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Releases every allocation at once. Blocks are kept and reused in order.
+ * PARAMETERS:
+    *  Arena *arena : Arena to reset.
+ * RETURNS : n/a
+ */
+void arenaReset(Arena *arena) {
+    arena->current = arena->first;
+    arena->last    = NULL;
+    if (arena->first) {
+        arena->first->used = 0;
+    }
+}
+
+/*
+ * FUNCTION: arenaFree
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Returns every block to the system and leaves the arena empty.
+ * PARAMETERS:
+    *  Arena *arena : Arena to free.
+ * RETURNS : n/a
+ */
+void arenaFree(Arena *arena) {
+    ArenaBlock *block = arena->first;
+    while (block) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    size_t blockSize = arena->blockSize;
+    memset(arena, 0, sizeof(*arena));
+    arena->blockSize = blockSize;
+}
+
+/*
+ * FUNCTION: arenaNextBlock
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Makes the block after the current one current, reusing it if it is
+    *  big enough, or links in a new block of at least size bytes.
+ * PARAMETERS:
+    *  Arena *arena : Arena to advance.
+    *  size_t size : Bytes the next allocation needs.
+ * RETURNS : ArenaBlock * - the new current block, or NULL if malloc failed.
+ */
+static ArenaBlock *arenaNextBlock(Arena *arena, size_t size) {
+    ArenaBlock *next = arena->current ? arena->current->next : arena->first;
+    if (next && next->capacity >= size) {
+        next->used     = 0;
+        arena->current = next;
+        return next;
+    }
+
+    size_t capacity = arena->blockSize ? arena->blockSize : ARENA_DEFAULT_BLOCK_SIZE;
+    if (capacity < size) {
+        capacity = size;   // Oversized allocations get a block of their own
+    }
+    if (capacity > SIZE_MAX - sizeof(ArenaBlock)) {
+        return NULL;
+    }
+
+    ArenaBlock *block = malloc(sizeof(ArenaBlock) + capacity);
+    if (!block) {
+        return NULL;
+    }
+    block->capacity = capacity;
+    block->used     = 0;
+    block->next     = next;   // A too-small next block stays in the chain for later
+    if (arena->current) {
+        arena->current->next = block;
+    } else {
+        arena->first = block;
+    }
+    arena->current = block;
+    return block;
+}
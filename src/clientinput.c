@@ -0,0 +1,224 @@
+/*
+ * FILE: clientinput.c
+ * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * The client's input helpers that do not touch stdin or the server:
+ * checking, converting and splitting what the user typed, and formatting
+ * a client record. They live apart from client.c so the micro benchmark
+ * (bench/micro_bench.c) can link them without the client's main().
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "clientinput.h"
+
+/* FUNCTION: isNullTerminated
+ * PROGRAMMER: Tyler Gee
+ * DESCRIPTION:
+ *  Checks whether a buffer contains a null terminator ('\0') within the
+ *  first bufSize bytes.
+ *  **NOTE:** This function does not check for a null terminator in the
+ *  rest of the buffer that exceeds bufSize bytes.
+ *
+ * PARAMETERS:
+ *   const char *buffer:    Pointer to the buffer to check.
+ *   size_t bufSize:        Max number of bytes to examine in the buffer.
+ * RETURN:
+ *   true: A null terminator was found within the first bufSize bytes.
+ *   false: No null terminator was found.
+ */
+bool isNullTerminated(const char *buffer, size_t bufSize) {
+    if (!buffer || bufSize == BUFFER_SIZE_OF_ZERO) {   // Invalid input
+        return false;
+    }
+
+    /* Iterate through the buffer and check for a null terminator
+    size_t is used to ensure the loop doesn't go beyond the buffer's
+    boundaries. (e.g., bufSize > INT_MAX)*/
+    for (size_t i = 0; i < bufSize; i++) {
+        if (buffer[i] == '\0') {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * FUNCTION: stringMatchesRegex
+ * PROGRAMMER: Tyler Gee
+ * DESCRIPTION:
+    *  Using a precompiled pattern, check if the given string matches the pattern.
+    *  String is null-terminated and does not exceed bufSize bytes.
+ * PARAMETERS:
+    *  const char *string:     The string to match against the pattern.
+    *  size_t bufSize:         Max size of the buffer in bytes, including the null
+    *                          terminator.
+    *  const Pattern *pattern: Handle from patternCompile() to match against.
+ * RETURN:
+    *   true: The string matches the pattern.
+    *   false: The string does not match the pattern.
+ */
+bool stringMatchesRegex(const char *string, size_t bufSize, const Pattern *pattern) {
+    if (!string || !pattern || bufSize <= BUFFER_SIZE_OF_ZERO) {   // invalid input parameters
+        return false;
+    }
+
+    if (!isNullTerminated(string, bufSize)) {
+        return false;
+    }
+
+    size_t length = strlen(string);
+    if (length == 0 || length > (bufSize - BUFFER_SIZE_OF_ONE)) {
+        return false;
+    }
+
+    // Literal patterns are a memcmp, the rest were compiled at startup
+    return patternMatches(pattern, string, length);
+}
+
+/*
+ * FUNCTION: convertToInt
+ * PROGRAMMER: Tyler Gee
+ * DESCRIPTION:
+ *  Attempts to convert a string of decimal digits to an integer in a single
+ *  pass (see scanDigits() in validate.c), without strtol() or a copy.
+ *  If the string is empty, contains a non-digit character or does not fit in
+ *  an int, the function returns false.
+ * PARAMETERS:
+ *  const char *buffer:     String to convert.
+ *  int *result:            Pointer to integer to store the result.
+ * RETURN:
+ *  true: Conversion successful and base 10 integer stored in result.
+ *  false: Conversion failed (not an valid integer or contains non-digits).
+ */
+bool convertToInt(const char *buffer, int *result) {
+    return scanDigits(buffer, result);
+}
+
+/* FUNCTION: splitClientName
+ * PROGRAMMER: Tyler Gee
+ * DESCRIPTION:
+ *  Split a client's full name into first and last names at the offsets found
+ *  by scanClientName(), so the buffer is not searched a second time.
+ *
+ *  All characters before the space are copied in the buffer pointed to by
+ *  *firstName, and all characters after the space are copied into the buffer
+ *  pointed to by *lastName.
+ *
+ *  IMPORTANT NOTE: Validation of input is not performed in this function, the
+ *  caller is responsible for ensuring the input is valid and safe:
+ *      - split came from a successful scanClientName() of buffer.
+ *      - firstName and lastName have enough space for copied values
+ *
+ * PARAMETERS:
+ *  const char *buffer:     buffer containing a space to split at
+ *  const NameSplit *split: Where the first and last names are in buffer
+ *  char *firstName:        Pointer to store the first split string into
+ *  char *lastName          Pointer to store the remaining bytes into
+ * RETURN: None
+ */
+void splitClientName(
+    const char *buffer, const NameSplit *split, char *firstName, char *lastName
+) {
+    memcpy(firstName, buffer, split->firstLength);
+    firstName[split->firstLength] = '\0';
+
+    memcpy(lastName, buffer + split->lastOffset, split->lastLength);
+    lastName[split->lastLength] = '\0';
+}
+
+/*
+ * FUNCTION: clientToString
+ * PROGRAMMER: Tyler Gee
+ * DESCRIPTION:
+ *  Converts a Client struct into a comma-separated string in the format:
+ *  "firstName,lastName,age,address". Dynamically allocates memory for
+ *  the returned string or returns NULL if any of the required fields are
+ *  missing, invalid or a memory allocation error occurs.
+ *
+ *  The returned string must be freed by the caller.
+ *
+ * PARAMETERS:
+ *  const Client *client: Pointer to the Client struct to convert to a string.
+ *
+ * RETURN:
+ *  char *: Dynamically allocated string representing the client's information
+ *          int the format specified or NULL if an error occurred, a field is
+ *          missing or memory allocation fails.
+ *
+ */
+char *clientToString(const Client *client) {
+    if (!client || strlen(client->firstName) == BUFFER_SIZE_OF_ZERO || strlen(client->lastName) == BUFFER_SIZE_OF_ZERO
+        || strlen(client->address) == BUFFER_SIZE_OF_ZERO || client->age <= BUFFER_SIZE_OF_ZERO) {
+        return NULL;
+    }
+    // (*__stream = NULL, * __n = 0) -> snprint calculates characters count
+    const int totalLength = snprintf(
+        NULL, 0, "%s,%s,%d,%s", client->firstName, client->lastName, client->age,
+        client->address
+    );
+
+    // Allocate memory for the client string + null terminator
+    char *clientString = calloc(totalLength + 1, sizeof(char));
+    if (!clientString) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+
+    // Construct the client string
+    snprintf(
+        clientString, totalLength + 1, "%s,%s,%d,%s", client->firstName, client->lastName,
+        client->age, client->address
+    );
+
+    return clientString;
+}
+
+/*
+ * FUNCTION: formatClientRecord
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Formats a client as the text record the client sends,
+    *  "firstName,lastName,age,address\n", into the caller's buffer. Unlike
+    *  clientToString() it allocates nothing, so a session can reuse one
+    *  buffer for every record.
+ * PARAMETERS:
+    *  char *out : Buffer to format into; it is null-terminated as well.
+    *  size_t size : Size of out.
+    *  const Client *client : Client to format.
+ * RETURNS : size_t - length of the record with its newline, or 0 if a field is missing or it does not fit.
+ */
+size_t formatClientRecord(char *out, size_t size, const Client *client) {
+    if (!client || client->firstName[0] == '\0' || client->lastName[0] == '\0'
+        || client->address[0] == '\0' || client->age <= BUFFER_SIZE_OF_ZERO) {
+        return 0;
+    }
+    int length = snprintf(out, size, "%s,%s,%d,%s\n", client->firstName, client->lastName,
+                          client->age, client->address);
+    return length > 0 && (size_t)length < size ? (size_t)length : 0;
+}
+
+/*
+ * FUNCTION: formatTextRecord
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Copies a text line and the newline that ends its record into the caller's buffer.
+ * PARAMETERS:
+    *  char *out : Buffer to copy into; it is null-terminated as well.
+    *  size_t size : Size of out.
+    *  const char *string : Line to send, without a newline.
+ * RETURNS : size_t - length of the record with its newline, or 0 if it does not fit.
+ */
+size_t formatTextRecord(char *out, size_t size, const char *string) {
+    size_t length = strlen(string);
+    if (length + 2 > size) {
+        return 0;
+    }
+    memcpy(out, string, length);
+    out[length]     = '\n';
+    out[length + 1] = '\0';
+    return length + 1;
+}
@@ -0,0 +1,734 @@
+/*
+ * FILE: clientsession.c
+ * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * The client's send path: a session with the server over a FIFO pair,
+ * the shared memory ring or a socket, every record kept in an AckWindow
+ * until the server acknowledges it. It lives apart from client.c so the
+ * allocation test (test/send_alloc_test.c) can link the real send path
+ * without the client's main().
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "ackwindow.h"
+#include "clientinput.h"
+#include "clientsession.h"
+#include "protocol.h"
+#include "shared.h"
+#include "shmring.h"
+#include "transport.h"
+
+// Wire format used by sendMessage(): binary frames unless --text is given
+static bool useTextProtocol = false;
+// How sessions reach the server: session FIFOs unless --shm, --socket or --tcp is given
+static TransportAddress transport = { .kind = TRANSPORT_FIFO };
+
+// Ring of the open session with --shm (see shmring.h)
+static ShmRing sendRing;
+
+// Records of the open FIFO session the server has not acknowledged yet
+static AckWindow sendWindow = { .replyFd = -1 };
+
+// Encoded party of sendTripBatch(), reused for the session's later parties
+// and only grown when a larger one comes along; freed with the session
+static char  *batchBuffer;
+static size_t batchBufferSize;
+
+/*
+ * FUNCTION: clientSessionConfigure
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Sets the wire format and transport of the sessions opened from now on.
+ * PARAMETERS:
+    *  bool textProtocol: Send text lines (--text) instead of binary frames.
+    *  const TransportAddress *address: Transport chosen on the command line.
+ * RETURN: n/a
+ */
+void clientSessionConfigure(bool textProtocol, const TransportAddress *address) {
+    useTextProtocol = textProtocol;
+    transport       = *address;
+}
+
+/*
+ * FUNCTION: openFIFOSession
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Opens a private session with the server and returns the write
+    *  descriptor, so that a whole party ("party", destination, clients,
+    *  "END_PARTY") is sent on a FIFO no other client writes to. Every record
+    *  written to the session is acknowledged by the server (see ackwindow.h).
+ * PARAMETERS:
+    *  const char *fifoname: Name of the shared FIFO the server listens on.
+    *  bool showConnectionMsg: If true, displays "Waiting for server..." and "Connected to server!" messages.
+ * RETURN:
+    *  int: The open file descriptor on success, ERROR on failure.
+ */
+int openFIFOSession(const char *fifoname, bool showConnectionMsg) {
+    ackWindowReset(&sendWindow, sendWindow.replyFd);
+    int fd = ERROR;
+    for (int attempt = 0; attempt < ACK_RESUME_ATTEMPTS && fd == ERROR; attempt++) {
+        fd = connectFIFOSession(fifoname, WIRE_NEW_SESSION, showConnectionMsg);
+        if (fd == ERROR && errno != ETIMEDOUT) {
+            break;   // Only a HELLO lost with its server is worth sending again
+        }
+    }
+    return fd;
+}
+
+/*
+ * FUNCTION: connectFIFOSession
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Connects a new or resumed session. The client creates its session FIFO
+    *  (SESSION_FIFO_FORMAT with its pid) and opens its reply FIFO
+    *  (REPLY_FIFO_FORMAT) for reading, registers them by sending a HELLO
+    *  message on the shared FIFO and then waits up to ACK_TIMEOUT_MS for the
+    *  server to open the session FIFO. A server killed between taking the
+    *  HELLO and reading it never opens it, so the wait must end: the caller
+    *  sends a fresh HELLO on ETIMEDOUT. With --shm a fresh record ring
+    *  is created first and announced in the HELLO. With --socket or --tcp
+    *  the session is a connection instead (see connectSocketSession()).
+ * PARAMETERS:
+    *  const char *fifoname: Name of the shared FIFO the server listens on.
+    *  uint64_t resume: Records acknowledged on the session being resumed, or WIRE_NEW_SESSION.
+    *  bool showConnectionMsg: If true, displays "Waiting for server..." and "Connected to server!" messages.
+ * RETURN:
+    *  int: The open file descriptor on success, ERROR on failure (errno ETIMEDOUT if the HELLO went unanswered).
+ */
+int connectFIFOSession(const char *fifoname, uint64_t resume, bool showConnectionMsg) {
+    char sessionPath[MAX_FIFO_PATH_LEN];
+    char replyPath[MAX_FIFO_PATH_LEN];
+    char hello[MAX_BUFFER_SIZE];
+    long pid = (long)getpid();
+
+    if (transportIsSocket(&transport)) {
+        return connectSocketSession(resume, showConnectionMsg);
+    }
+
+    // Create the private session FIFO. Records a lost server never read are
+    // sent again, so it is made anew: the old pipe still holds them while
+    // this client's write end is open, and the next server would read them
+    // ahead of the resent ones
+    if (sessionFifoPath(sessionPath, sizeof(sessionPath), pid) == ERROR
+        || (unlink(sessionPath) == ERROR && errno != ENOENT)
+        || mkfifo(sessionPath, PERM_OWNER_RW) == ERROR) {
+        perror("Error creating session FIFO");
+        return ERROR;
+    }
+
+    // Open the reply FIFO before registering so the server can open its write end
+    if (sendWindow.replyFd != -1) {
+        close(sendWindow.replyFd);
+    }
+    sendWindow.partial = 0;
+    if (replyFifoPath(replyPath, sizeof(replyPath), pid) == ERROR
+        || (mkfifo(replyPath, PERM_OWNER_RW) == ERROR && errno != EEXIST)
+        || (sendWindow.replyFd = open(replyPath, O_RDONLY | O_NONBLOCK | O_CLOEXEC)) == -1) {
+        perror("Error creating reply FIFO");
+        unlink(sessionPath);
+        return ERROR;
+    }
+
+    // Records a lost server never read are sent again, so the ring starts empty
+    shmRingClose(&sendRing);
+    if (transport.kind == TRANSPORT_SHM && shmRingCreate(&sendRing, pid) == ERROR) {
+        perror("Error creating shared memory ring");
+        unlink(sessionPath);
+        return ERROR;
+    }
+
+    if (showConnectionMsg) {
+        printf("Waiting for server...\n");
+    }
+
+    // Register the session on the shared FIFO (one atomic write)
+    size_t helloLength = encodeSessionHello(hello, sizeof(hello), resume);
+    int    sharedFd    = open(fifoname, O_WRONLY);
+    if (sharedFd == -1) {   // Check for error
+        perror("Error opening FIFO stream for writing");
+        unlink(sessionPath);
+        return ERROR;
+    }
+    ssize_t bytesWritten = write(sharedFd, hello, helloLength);
+    close(sharedFd);
+    if (bytesWritten != (ssize_t)helloLength) {
+        perror("Error writing to FIFO stream");
+        unlink(sessionPath);
+        return ERROR;
+    }
+
+    // ENXIO until the server opens the read end of the session FIFO
+    int fd;
+    int waitedMs = 0;
+    while ((fd = open(sessionPath, O_WRONLY | O_NONBLOCK)) == -1) {
+        if (errno != ENXIO) {
+            perror("Error opening session FIFO for writing");
+            unlink(sessionPath);
+            return ERROR;
+        }
+        if (waitedMs >= ACK_TIMEOUT_MS) {
+            printf("Error: The server did not open the session FIFO\n");
+            unlink(sessionPath);
+            errno = ETIMEDOUT;
+            return ERROR;
+        }
+        poll(NULL, 0, SESSION_OPEN_POLL_MS);
+        waitedMs += SESSION_OPEN_POLL_MS;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);   // Records are written blocking, whole
+    if (showConnectionMsg) {
+        printf("Connected to server!\n");
+    }
+    return fd;
+}
+
+/*
+ * FUNCTION: connectSocketSession
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Connects a new or resumed session over the unix socket or loopback
+    *  TCP port given on the command line. The first record names the
+    *  session with the same HELLO the shared FIFO takes, and the server
+    *  acknowledges on the connection itself, read through a second
+    *  descriptor so the session and reply ends close like the FIFO pair.
+ * PARAMETERS:
+    *  uint64_t resume: Records acknowledged on the session being resumed, or WIRE_NEW_SESSION.
+    *  bool showConnectionMsg: If true, displays "Waiting for server..." and "Connected to server!" messages.
+ * RETURN:
+    *  int: The connected, non-blocking socket on success, ERROR on failure.
+ */
+int connectSocketSession(uint64_t resume, bool showConnectionMsg) {
+    char hello[MAX_BUFFER_SIZE];
+
+    if (sendWindow.replyFd != -1) {
+        close(sendWindow.replyFd);
+        sendWindow.replyFd = -1;
+    }
+    sendWindow.partial = 0;
+    if (showConnectionMsg) {
+        printf("Waiting for server...\n");
+    }
+
+    int fd = transportConnect(&transport, ACK_TIMEOUT_MS);
+    if (fd == -1) {
+        perror("Error connecting to the server");
+        return ERROR;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);   // Shared with the reply descriptor
+    size_t helloLength = encodeSessionHello(hello, sizeof(hello), resume);
+    if (writeRecordToSocket(fd, hello, helloLength) == ERROR
+        || (sendWindow.replyFd = fcntl(fd, F_DUPFD_CLOEXEC, 0)) == -1) {
+        perror("Error registering the session");
+        close(fd);
+        return ERROR;
+    }
+    if (showConnectionMsg) {
+        printf("Connected to server!\n");
+    }
+    return fd;
+}
+
+/*
+ * FUNCTION: encodeSessionHello
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Builds the HELLO that registers this client's session, as text with --text.
+ * PARAMETERS:
+    *  char *hello: Receives the record.
+    *  size_t size: Size of hello.
+    *  uint64_t resume: Records acknowledged on the session being resumed, or WIRE_NEW_SESSION.
+ * RETURN:
+    *  size_t: Length of the record.
+ */
+size_t encodeSessionHello(char *hello, size_t size, uint64_t resume) {
+    long pid = (long)getpid();
+    if (!useTextProtocol) {
+        return wireEncodeHello(hello, size, pid, resume, transport.kind == TRANSPORT_SHM ? WIRE_HELLO_SHM : 0);
+    }
+
+    const char *shmField = transport.kind == TRANSPORT_SHM ? " shm" : "";
+    return resume != WIRE_NEW_SESSION
+        ? (size_t)snprintf(hello, size, "session %ld %llu%s\n", pid, (unsigned long long)resume, shmField)
+        : (size_t)snprintf(hello, size, "session %ld%s\n", pid, shmField);
+}
+
+/*
+ * FUNCTION: resumeFIFOSession
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Reconnects a session whose server went away (a restart) and writes
+    *  every unacknowledged record again. A resumed session is acknowledged
+    *  straight away with the records the server kept in its journal, so only
+    *  the ones it never made durable are sent twice. The new session takes
+    *  over the descriptor number of the old one.
+ * PARAMETERS:
+    *  int fd: Descriptor of the lost session, replaced by the new one.
+ * RETURN:
+    *  int: Returns 0 on success, ERROR if the session could not be resumed.
+ */
+int resumeFIFOSession(int fd) {
+    for (int attempt = 0; attempt < ACK_RESUME_ATTEMPTS; attempt++) {
+        // Acknowledgements the old server sent before it went away still count
+        ackWindowPoll(&sendWindow, 0);
+        printf("Lost the server, reconnecting to resend %zu records...\n",
+               ackWindowInFlight(&sendWindow));
+        int newFd = connectFIFOSession(FIFO_PATH, sendWindow.acked, false);
+        if (newFd == ERROR) {
+            continue;   // Counts as an attempt; the next one sends a fresh HELLO
+        }
+        if (dup2(newFd, fd) == -1) {
+            close(newFd);
+            return ERROR;
+        }
+        close(newFd);
+
+        AckStatus status = ackWindowPoll(&sendWindow, ACK_TIMEOUT_MS);
+        if (status == ACK_WAITING) {
+            printf("Error: The server did not confirm the resumed session\n");
+            return ERROR;
+        }
+
+        bool lost = status == ACK_HANGUP;
+        for (uint64_t number = sendWindow.acked; number < sendWindow.sent && !lost; number++) {
+            size_t      length;
+            const char *record = ackWindowRecord(&sendWindow, number, &length);
+            if (writeRecordToTransport(fd, record, length) == ERROR) {
+                if (errno != EPIPE) {
+                    perror("Error writing to FIFO stream");
+                    return ERROR;
+                }
+                lost = true;
+            }
+        }
+        if (!lost) {
+            printf("Session resumed.\n");
+            return SUCCESS;
+        }
+    }
+    printf("Error: Could not resume the session with the server\n");
+    return ERROR;
+}
+
+/*
+ * FUNCTION: writeSessionRecord
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Writes one record (text line, frame or batch chunk) to a FIFO session
+    *  and keeps it until the server acknowledges it. Waits first if
+    *  ACK_WINDOW_SIZE records are already unacknowledged.
+ * PARAMETERS:
+    *  int fd: Descriptor returned by openFIFOSession().
+    *  const char *record: Record to write, at most WIRE_MAX_FRAME_SIZE bytes.
+    *  size_t length: Size of the record in bytes.
+ * RETURN:
+    *  int: Returns 0 on success, ERROR on failure.
+ */
+int writeSessionRecord(int fd, const char *record, size_t length) {
+    if (waitForAcknowledgements(fd, ACK_WINDOW_SIZE - 1) == ERROR
+        || ackWindowPush(&sendWindow, record, length) == ERROR) {
+        return ERROR;
+    }
+
+    if (writeRecordToTransport(fd, record, length) == SUCCESS) {
+        return SUCCESS;
+    }
+    if (errno == EPIPE) {
+        return resumeFIFOSession(fd);   // The record is in the window and is sent again
+    }
+    perror("Error writing to FIFO stream");
+    return ERROR;
+}
+
+/*
+ * FUNCTION: writeRecordToTransport
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Hands one session record to the server over the transport chosen on
+    *  the command line: one write() to the session FIFO or socket, or a copy
+    *  into the shared memory ring. The ring only costs a syscall when the
+    *  server is idle and needs the doorbell, or when it is full and the
+    *  client sleeps.
+ * PARAMETERS:
+    *  int fd: Descriptor returned by openFIFOSession().
+    *  const char *record: Record to send, at most WIRE_MAX_FRAME_SIZE bytes.
+    *  size_t length: Size of the record in bytes.
+ * RETURN:
+    *  int: Returns 0 on success, ERROR with errno set (EPIPE if the server went away).
+ */
+int writeRecordToTransport(int fd, const char *record, size_t length) {
+    if (transportIsSocket(&transport)) {
+        return writeRecordToSocket(fd, record, length);
+    }
+    if (!sendRing.shared) {
+        ssize_t bytesWritten = write(fd, record, length);
+        if (bytesWritten != (ssize_t)length && bytesWritten != -1) {
+            errno = EIO;   // Frames fit in PIPE_BUF, so a short write is a broken session
+        }
+        return bytesWritten == (ssize_t)length ? SUCCESS : ERROR;
+    }
+
+    ShmRingStatus status;
+    int           waitedMs = 0;
+    while ((status = shmRingPush(&sendRing, record, length, SHM_RING_WAIT_MS)) == SHM_RING_FULL) {
+        // A server that stopped reading the ring may have gone away
+        if (ackWindowPoll(&sendWindow, 0) == ACK_HANGUP) {
+            errno = EPIPE;
+            return ERROR;
+        }
+        if ((waitedMs += SHM_RING_WAIT_MS) >= ACK_TIMEOUT_MS) {
+            errno = ETIMEDOUT;
+            return ERROR;
+        }
+    }
+    const char doorbell = SHM_RING_DOORBELL;
+    if (status == SHM_RING_WAKE && write(fd, &doorbell, sizeof(doorbell)) == -1) {
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: writeRecordToSocket
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Writes one record to a non-blocking socket session. Unlike a FIFO, a
+    *  stream socket may take part of a record; the rest is written once the
+    *  server has read enough for it to fit.
+ * PARAMETERS:
+    *  int fd: Socket returned by connectSocketSession().
+    *  const char *record: Record to send.
+    *  size_t length: Size of the record in bytes.
+ * RETURN:
+    *  int: Returns 0 on success, ERROR with errno set (EPIPE if the server went away).
+ */
+int writeRecordToSocket(int fd, const char *record, size_t length) {
+    size_t sent = 0;
+    while (sent < length) {
+        ssize_t bytesWritten = send(fd, record + sent, length - sent, MSG_NOSIGNAL);
+        if (bytesWritten >= 0) {
+            sent += (size_t)bytesWritten;
+            continue;
+        }
+        if (errno == ECONNRESET) {
+            errno = EPIPE;   // Both mean the server went away
+        }
+        if (errno != EAGAIN && errno != EINTR) {
+            return ERROR;
+        }
+
+        struct pollfd room = { .fd = fd, .events = POLLOUT };
+        int           ready = poll(&room, 1, ACK_TIMEOUT_MS);
+        if (ready == 0) {
+            errno = ETIMEDOUT;
+            return ERROR;
+        }
+        if (ready == -1 && errno != EINTR) {
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: waitForAcknowledgements
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Reads the server's acknowledgements until at most maxInFlight records
+    *  are unacknowledged, resuming the session if the server went away.
+    *  Once half the window is in use, whatever has arrived is read without
+    *  waiting so acknowledgements never pile up in the reply FIFO.
+ * PARAMETERS:
+    *  int fd: Descriptor returned by openFIFOSession().
+    *  size_t maxInFlight: Unacknowledged records allowed on return, 0 to wait for all.
+ * RETURN:
+    *  int: Returns 0 on success, ERROR if the server stopped acknowledging.
+ */
+int waitForAcknowledgements(int fd, size_t maxInFlight) {
+    int timeoutMs = 0;
+    while (ackWindowInFlight(&sendWindow) > maxInFlight
+           || (timeoutMs == 0 && ackWindowInFlight(&sendWindow) >= ACK_WINDOW_SIZE / 2)) {
+        AckStatus status = ackWindowPoll(&sendWindow, timeoutMs);
+        if (status == ACK_HANGUP && resumeFIFOSession(fd) == ERROR) {
+            return ERROR;
+        }
+        if (status == ACK_WAITING && timeoutMs > 0) {
+            printf("Error: The server has not acknowledged %zu records in %d seconds\n",
+                   ackWindowInFlight(&sendWindow), ACK_TIMEOUT_MS / 1000);
+            return ERROR;
+        }
+        timeoutMs = ACK_TIMEOUT_MS;
+    }
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: writestringToFIFOSession
+ * PROGRAMMER: Tyler Gee & Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Writes a string followed by a newline to an already open FIFO session.
+    *  The newline is the record separator the server frames messages on.
+ * PARAMETERS:
+    *  int fd: Descriptor returned by openFIFOSession().
+    *  const char *string: String to write to the FIFO.
+ * RETURN:
+    *  int: Returns 0 on success, ERROR on failure.
+ */
+int writestringToFIFOSession(int fd, const char *string) {
+    if (fd < 0 || !string) {
+        return ERROR;
+    }
+
+    // String plus newline, built on the stack: a record is at most one frame
+    char   record[WIRE_MAX_FRAME_SIZE];
+    size_t length = formatTextRecord(record, sizeof(record), string);
+    if (length == 0) {
+        printf("Error: Message is too long to send\n");
+        return ERROR;
+    }
+    return writeTextRecord(fd, record, length);
+}
+
+/*
+ * FUNCTION: writeTextRecord
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Writes a text record that already ends in its newline to a FIFO
+    *  session and echoes it without the newline.
+ * PARAMETERS:
+    *  int fd: Descriptor returned by openFIFOSession().
+    *  const char *record: Record from formatTextRecord() or formatClientRecord().
+    *  size_t length: Size of the record in bytes, newline included.
+ * RETURN:
+    *  int: Returns 0 on success, ERROR on failure.
+ */
+int writeTextRecord(int fd, const char *record, size_t length) {
+    if (writeSessionRecord(fd, record, length) == ERROR) {
+        return ERROR;
+    }
+
+    printf("Sent to server: %.*s\n", (int)(length - 1), record);
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: writeFrameToFIFOSession
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Writes an encoded binary wire frame to an already open FIFO session.
+    *  Frames are at most WIRE_MAX_FRAME_SIZE bytes, which is within PIPE_BUF,
+    *  so each frame is written atomically.
+ * PARAMETERS:
+    *  int fd: Descriptor returned by openFIFOSession().
+    *  const char *frame: Encoded frame (header and payload).
+    *  size_t length: Size of the frame in bytes.
+ * RETURN:
+    *  int: Returns 0 on success, ERROR on failure.
+ */
+int writeFrameToFIFOSession(int fd, const char *frame, size_t length) {
+    if (fd < 0 || !frame || length < WIRE_HEADER_SIZE) {
+        return ERROR;
+    }
+
+    if (writeSessionRecord(fd, frame, length) == ERROR) {
+        return ERROR;
+    }
+
+    WireHeader header;
+    memcpy(&header, frame, WIRE_HEADER_SIZE);
+    printf("Sent to server: [%s frame, %zu bytes]\n", wireTypeName(header.type), length);
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: sendMessage
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Sends one protocol message over a FIFO session, either as a binary
+    *  wire frame or, when --text was given, as a text line.
+ * PARAMETERS:
+    *  int fd: Descriptor returned by openFIFOSession().
+    *  WireMessageType type: Message to send.
+    *  const Trip *trip: Trip holding the destination (WIRE_DEST only).
+    *  const Client *client: Client to send (WIRE_CLIENT only).
+ * RETURN:
+    *  int: Returns 0 on success, ERROR on failure.
+ */
+int sendMessage(int fd, WireMessageType type, const Trip *trip, const Client *client) {
+    if (fd < 0 || (type == WIRE_DEST && !trip) || (type == WIRE_CLIENT && !client)) {
+        return ERROR;
+    }
+
+    if (useTextProtocol) {
+        switch (type) {
+            case WIRE_PARTY:
+                return writestringToFIFOSession(fd, "party");
+            case WIRE_DEST:
+                return writestringToFIFOSession(fd, trip->destination);
+            case WIRE_END:
+                return writestringToFIFOSession(fd, "END_PARTY");
+            case WIRE_STOP:
+                return writestringToFIFOSession(fd, "stop");
+            case WIRE_CLIENT: {
+                char   record[WIRE_MAX_FRAME_SIZE];
+                size_t length = formatClientRecord(record, sizeof(record), client);
+                if (length == 0) {
+                    printf("Error: Client is missing a field and cannot be sent\n");
+                    return ERROR;
+                }
+                return writeTextRecord(fd, record, length);
+            }
+            default:
+                return ERROR;
+        }
+    }
+
+    char   frame[WIRE_MAX_FRAME_SIZE];
+    size_t length = 0;
+    switch (type) {
+        case WIRE_PARTY:
+        case WIRE_END:
+        case WIRE_STOP:
+            length = wireEncodeControl(frame, sizeof(frame), type);
+            break;
+        case WIRE_DEST:
+            length = wireEncodeDestination(frame, sizeof(frame), trip);
+            break;
+        case WIRE_CLIENT:
+            length = wireEncodeClient(frame, sizeof(frame), client);
+            break;
+        default:
+            break;
+    }
+    if (length == 0) {
+        return ERROR;
+    }
+    return writeFrameToFIFOSession(fd, frame, length);
+}
+
+/*
+ * FUNCTION: sendTripBatch
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Sends a whole party (destination and every client in trip->clients) as
+    *  one WIRE_BATCH. The party is encoded into the session's batch buffer
+    *  and split into chunks of at most WIRE_MAX_FRAME_SIZE bytes. Each chunk is written
+    *  with one write() of its headers and its slice of the buffer, so each
+    *  chunk is atomic and chunks from concurrent clients never mix. The
+    *  sequence number in each chunk lets the server rebuild the party.
+ * PARAMETERS:
+    *  int fd: Descriptor returned by openFIFOSession().
+    *  const Trip *trip: Trip to send, numberOfClients must be set.
+    *  bool showSentMsg: Print a line describing the batch once it is sent.
+ * RETURN:
+    *  int: Returns 0 on success, ERROR on failure.
+ */
+int sendTripBatch(int fd, const Trip *trip, bool showSentMsg) {
+    if (fd < 0 || !trip) {
+        return ERROR;
+    }
+
+    size_t bufferSize = wireTripSizeBound(trip);
+    if (bufferSize > batchBufferSize) {
+        char *grown = realloc(batchBuffer, bufferSize);
+        if (!grown) {
+            perror("Memory allocation failed");
+            return ERROR;
+        }
+        batchBuffer     = grown;
+        batchBufferSize = bufferSize;
+    }
+    char *buffer = batchBuffer;
+
+    size_t length = wireEncodeTrip(buffer, bufferSize, trip);
+    if (length == 0 || length > WIRE_MAX_BATCH_SIZE) {
+        printf("Error: Party is too large to send as a batch\n");
+        return ERROR;
+    }
+
+    // Frame header and batch header of the chunk being written
+    struct {
+        WireHeader      frame;
+        WireBatchHeader batch;
+    } headers = {
+        .frame = { .magic = WIRE_MAGIC, .version = WIRE_VERSION, .type = WIRE_BATCH },
+        .batch = { .batchId = (uint32_t)getpid() },
+    };
+    _Static_assert(sizeof(headers) == WIRE_HEADER_SIZE + sizeof(WireBatchHeader),
+                   "batch chunk headers must be packed");
+
+    char     chunk[WIRE_MAX_FRAME_SIZE];
+    size_t   offset = 0;
+    uint16_t chunks = 0;
+    while (offset < length) {
+        size_t fragmentLength = length - offset;
+        if (fragmentLength > WIRE_MAX_FRAGMENT_SIZE) {
+            fragmentLength = WIRE_MAX_FRAGMENT_SIZE;
+        }
+        headers.frame.length   = (uint32_t)(sizeof(headers.batch) + fragmentLength);
+        headers.batch.sequence = chunks;
+        headers.batch.flags    = (offset + fragmentLength == length) ? WIRE_BATCH_LAST : 0;
+
+        memcpy(chunk, &headers, sizeof(headers));
+        memcpy(chunk + sizeof(headers), buffer + offset, fragmentLength);
+        if (writeSessionRecord(fd, chunk, sizeof(headers) + fragmentLength) == ERROR) {
+            return ERROR;
+        }
+        offset += fragmentLength;
+        chunks++;
+    }
+
+    if (showSentMsg) {
+        printf("Sent to server: [BATCH of %d clients, %zu bytes in %u chunks]\n",
+               trip->numberOfClients, length, (unsigned)chunks);
+    }
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: closeFIFOSession
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Waits until the server has acknowledged every record of a FIFO session
+    *  opened with openFIFOSession(), then closes it, removes the session and
+    *  reply FIFOs and marks the descriptor as closed. The server sees EOF
+    *  once it has read everything sent. Safe to call on a closed session.
+ * PARAMETERS:
+    *  int *fd: Pointer to the session descriptor, set to -1 after closing.
+ * RETURN: n/a
+ */
+void closeFIFOSession(int *fd) {
+    if (fd && *fd >= 0) {
+        char path[MAX_FIFO_PATH_LEN];
+        if (waitForAcknowledgements(*fd, 0) == SUCCESS && sendWindow.rejected > 0) {
+            printf("Warning: The server rejected %llu of the records sent\n",
+                   (unsigned long long)sendWindow.rejected);
+        }
+        close(*fd);
+        *fd = -1;
+        if (sessionFifoPath(path, sizeof(path), (long)getpid()) == SUCCESS) {
+            unlink(path);
+        }
+        shmRingClose(&sendRing);
+        free(batchBuffer);
+        batchBuffer     = NULL;
+        batchBufferSize = 0;
+
+        if (sendWindow.replyFd != -1) {
+            close(sendWindow.replyFd);
+            sendWindow.replyFd = -1;
+        }
+        if (replyFifoPath(path, sizeof(path), (long)getpid()) == SUCCESS) {
+            unlink(path);
+        }
+    }
+}
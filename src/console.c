@@ -0,0 +1,145 @@
+/*
+ * FILE: console.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Buffered console output. Text is formatted straight into the buffer and
+ * written to the stream with one fwrite() and fflush() when the buffer
+ * fills or the owner calls consoleFlush(), so lines from other threads'
+ * printf() calls still come out whole and in stream order. A Console is
+ * not thread safe; one thread owns it at a time.
+*/
+
+#include <stdarg.h>
+#include <string.h>
+
+#include "console.h"
+
+/*
+ * FUNCTION: consoleInit
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Starts an empty console on a stream.
+ * PARAMETERS:
+    *  Console *console : Console to initialise.
+    *  FILE *stream : Stream the text is written to, usually stdout.
+ * RETURNS : n/a
+ */
+void consoleInit(Console *console, FILE *stream) {
+    console->stream = stream;
+    console->used   = 0;
+}
+
+/*
+ * FUNCTION: consoleFormat
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Appends printf-style text, flushing first if it does not fit in what
+    *  is left of the buffer. Text longer than the whole buffer is cut off.
+ * PARAMETERS:
+    *  Console *console : Console to append to.
+    *  const char *format : printf format.
+ * RETURNS : n/a
+ */
+void consoleFormat(Console *console, const char *format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    int written = vsnprintf(console->buffer + console->used, sizeof(console->buffer) - console->used,
+                            format, arguments);
+    va_end(arguments);
+    if (written < 0) {
+        return;
+    }
+    
+    if ((size_t)written >= sizeof(console->buffer) - console->used) {
+        consoleFlush(console);
+        va_start(arguments, format);
+        written = vsnprintf(console->buffer, sizeof(console->buffer), format, arguments);
+        va_end(arguments);
+        if (written < 0) {
+            return;
+        }
+        if ((size_t)written >= sizeof(console->buffer)) {
+            written = (int)sizeof(console->buffer) - 1;
+        }
+    }
+    console->used += (size_t)written;
+}
+
+/*
+ * FUNCTION: consoleQuote
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Appends a value as a double-quoted string, with backslashes, quotes
+    *  and control characters escaped so a key=value line stays one line.
+ * PARAMETERS:
+    *  Console *console : Console to append to.
+    *  const char *value : Null-terminated value.
+ * RETURNS : n/a
+ */
+void consoleQuote(Console *console, const char *value) {
+    static const char hex[] = "0123456789abcdef";
+    const size_t      worst = 4 * strlen(value) + 2;   // Every byte as \xNN, plus the quotes
+    if (worst > sizeof(console->buffer) - console->used) {
+        consoleFlush(console);
+        if (worst > sizeof(console->buffer)) {
+            return;
+        }
+    }
+    
+    char *out = console->buffer + console->used;
+    *out++ = '"';
+    for (const unsigned char *in = (const unsigned char *)value; *in != '\0'; in++) {
+        if (*in == '"' || *in == '\\') {
+            *out++ = '\\';
+            *out++ = (char)*in;
+        } else if (*in < ' ' || *in == 0x7F) {
+            *out++ = '\\';
+            *out++ = 'x';
+            *out++ = hex[*in >> 4];
+            *out++ = hex[*in & 0x0F];
+        } else {
+            *out++ = (char)*in;
+        }
+    }
+    *out++ = '"';
+    console->used = (size_t)(out - console->buffer);
+}
+
+/*
+ * FUNCTION: consoleFlush
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Writes whatever the console holds to its stream.
+ * PARAMETERS:
+    *  Console *console : Console to flush.
+ * RETURNS : n/a
+ */
+void consoleFlush(Console *console) {
+    if (console->used == 0) {
+        return;
+    }
+    fwrite(console->buffer, 1, console->used, console->stream);
+    fflush(console->stream);
+    console->used = 0;
+}
+
+/*
+ * FUNCTION: consoleParseMode
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Reads a ConsoleMode from its --output name.
+ * PARAMETERS:
+    *  const char *name : "quiet", "compact" or "pretty".
+    *  ConsoleMode *mode : Receives the mode.
+ * RETURNS : bool - false if the name is not a mode.
+ */
+bool consoleParseMode(const char *name, ConsoleMode *mode) {
+    static const char *const names[] = {
+        [CONSOLE_QUIET] = "quiet", [CONSOLE_COMPACT] = "compact", [CONSOLE_PRETTY] = "pretty"
+    };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *mode = (ConsoleMode)i;
+            return true;
+        }
+    }
+    return false;
+}
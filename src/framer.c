@@ -0,0 +1,247 @@
+/*
+ * FILE: framer.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * framer.c implements a streaming line framer. Large chunks are read from a
+ * descriptor into one buffer, newline boundaries are found with memchr, and
+ * every record is handed out as a (pointer, length) view into that buffer
+ * without copying. Bytes of an incomplete record carry over to the next read.
+ *
+ * Records starting with WIRE_MAGIC are binary frames and are cut by the
+ * length in their header instead of by newline.
+*/
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "framer.h"
+#include "protocol.h"
+#include "shared.h"
+
+static int framerReserve(LineFramer *framer);
+
+/*
+ * FUNCTION: framerInit
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Initialises a framer. The buffer is only allocated by the first
+    *  framerFill(), so idle sessions do not hold one. The capacity must be
+    *  larger than the longest record that should be accepted.
+ * PARAMETERS:
+    *  LineFramer *framer : Framer to initialise.
+    *  size_t capacity : Size of the buffer in bytes.
+ * RETURNS : int - SUCCESS, or ERROR if the capacity is invalid.
+ */
+int framerInit(LineFramer *framer, size_t capacity) {
+    if (!framer || capacity < BUFFER_SIZE_OF_TWO) {
+        return ERROR;
+    }
+
+    memset(framer, 0, sizeof(*framer));
+    framer->capacity = capacity;
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: framerFree
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Releases the framer buffer. Outstanding views become invalid.
+ * PARAMETERS:
+    *  LineFramer *framer : Framer to release.
+ * RETURNS : n/a
+ */
+void framerFree(LineFramer *framer) {
+    if (framer) {
+        free(framer->buffer);
+        memset(framer, 0, sizeof(*framer));
+    }
+}
+
+/*
+ * FUNCTION: framerFill
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Reads the next chunk from fd into the framer. When the free space at
+    *  the tail drops below FRAMER_READ_SIZE the unconsumed bytes (at most
+    *  one partial record) are moved back to the front first. If the buffer
+    *  is full without a newline the record is too long and is dropped up to
+    *  its newline.
+    *
+    *  Record views returned before this call must not be used afterwards.
+ * PARAMETERS:
+    *  LineFramer *framer : Framer to fill.
+    *  int fd : Descriptor to read from.
+ * RETURNS : ssize_t - bytes read, 0 on EOF, or -1 with errno set (ENOMEM if
+ *                     the buffer could not be allocated).
+ */
+ssize_t framerFill(LineFramer *framer, int fd) {
+    if (framerReserve(framer) == ERROR) {
+        return -1;
+    }
+
+    ssize_t bytesRead = read(fd, framer->buffer + framer->end, framer->capacity - framer->end);
+    if (bytesRead > 0) {
+        framer->end += (size_t)bytesRead;
+    }
+    return bytesRead;
+}
+
+/*
+ * FUNCTION: framerPush
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Adds bytes that arrived some other way than read() (a shared memory
+    *  ring slot, see shmring.h) to the framer, exactly as framerFill()
+    *  would. Record views returned before this call must not be used
+    *  afterwards.
+ * PARAMETERS:
+    *  LineFramer *framer : Framer to fill.
+    *  const char *data : Bytes to add.
+    *  size_t length : Number of bytes, at most FRAMER_READ_SIZE.
+ * RETURNS : int - SUCCESS, or ERROR if the buffer could not be allocated.
+ */
+int framerPush(LineFramer *framer, const char *data, size_t length) {
+    if (framerReserve(framer) == ERROR) {
+        return ERROR;
+    }
+
+    // Not enough room behind a record that never ended - drop it
+    if (length > framer->capacity - framer->end) {
+        if (!framer->discarding) {
+            framer->discarded++;
+        }
+        framer->discarding = true;
+        framer->start = framer->end = framer->scanned = 0;
+    }
+    memcpy(framer->buffer + framer->end, data, length);
+    framer->end += length;
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: framerReserve
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Allocates the buffer on first use and makes room at its tail, as described in framerFill().
+ * PARAMETERS:
+    *  LineFramer *framer : Framer about to be filled.
+ * RETURNS : int - SUCCESS, or ERROR with errno ENOMEM if the buffer could not be allocated.
+ */
+static int framerReserve(LineFramer *framer) {
+    if (!framer->buffer && !(framer->buffer = malloc(framer->capacity))) {
+        errno = ENOMEM;
+        return ERROR;
+    }
+
+    // Slide the carried over bytes to the front when the tail is short
+    if (framer->capacity - framer->end < FRAMER_READ_SIZE && framer->start > 0) {
+        size_t pending = framer->end - framer->start;
+        memmove(framer->buffer, framer->buffer + framer->start, pending);
+        framer->start = 0;
+        framer->end   = pending;
+    }
+
+    // Buffer full and no newline anywhere - drop the oversized record
+    if (framer->end == framer->capacity) {
+        if (!framer->discarding) {
+            framer->discarded++;
+        }
+        framer->discarding = true;
+        framer->start = framer->end = framer->scanned = 0;
+    }
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: framerNext
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Hands out the next complete record in the buffer. For text records the
+    *  newline is replaced by '\0' and is not counted in the record length.
+    *  For binary frames the view covers the payload after the header. A
+    *  frame with a bad header is dropped up to the next newline.
+ * PARAMETERS:
+    *  LineFramer *framer : Framer to take the record from.
+    *  RecordView *record : Set to the record on success.
+ * RETURNS :
+    *  true : A record was returned.
+    *  false : No complete record is buffered; call framerFill() again.
+ */
+bool framerNext(LineFramer *framer, RecordView *record) {
+    while (framer->start + framer->scanned < framer->end) {
+        // Binary frame: cut by the length in its header
+        if (!framer->discarding && (unsigned char)framer->buffer[framer->start] == WIRE_MAGIC) {
+            size_t     available = framer->end - framer->start;
+            WireHeader header;
+            if (available < WIRE_HEADER_SIZE) {
+                return false;
+            }
+            memcpy(&header, framer->buffer + framer->start, WIRE_HEADER_SIZE);
+            if (header.version != WIRE_VERSION || header.length > WIRE_MAX_PAYLOAD_SIZE) {
+                framer->discarded++;
+                framer->discarding = true;
+                framer->start++;
+                continue;
+            }
+            if (available < WIRE_HEADER_SIZE + header.length) {
+                return false;
+            }
+
+            record->data    = framer->buffer + framer->start + WIRE_HEADER_SIZE;
+            record->length  = header.length;
+            record->type    = header.type;
+            framer->start  += WIRE_HEADER_SIZE + header.length;
+            framer->scanned = 0;
+            return true;
+        }
+
+        char *searchFrom = framer->buffer + framer->start + framer->scanned;
+        char *newline    = memchr(searchFrom, '\n', framer->end - framer->start - framer->scanned);
+        if (!newline) {
+            // Remember how far we looked so the next call doesn't rescan
+            framer->scanned = framer->end - framer->start;
+            return false;
+        }
+
+        char  *recordStart = framer->buffer + framer->start;
+        size_t length      = (size_t)(newline - recordStart);
+        *newline           = '\0';
+        framer->start     += length + 1;
+        framer->scanned    = 0;
+
+        if (framer->discarding) {   // Tail of an oversized record
+            framer->discarding = false;
+            continue;
+        }
+
+        record->data   = recordStart;
+        record->length = length;
+        record->type   = WIRE_TEXT;
+        return true;
+    }
+
+    // Everything consumed - restart at the front of the buffer
+    if (framer->start == framer->end) {
+        framer->start = framer->end = framer->scanned = 0;
+    }
+    return false;
+}
+
+/*
+ * FUNCTION: recordEquals
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Compares a record against a string literal without strlen on the record.
+ * PARAMETERS:
+    *  const RecordView *record : Record to compare.
+    *  const char *literal : Null-terminated string to compare against.
+ * RETURNS : bool - true if the record is exactly the literal.
+ */
+bool recordEquals(const RecordView *record, const char *literal) {
+    size_t literalLength = strlen(literal);
+    return record->length == literalLength
+        && memcmp(record->data, literal, literalLength) == SUCCESS;
+}
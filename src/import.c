@@ -0,0 +1,179 @@
+/*
+ * FILE: import.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Parses and validates manifest rows for the client's bulk import mode.
+ * Rows are read in place from the mapped manifest and their fields are
+ * copied into the Client being filled, with no allocation per row.
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "import.h"
+#include "shared.h"
+#include "validate.h"
+
+#define IMPORT_COLUMN_COUNT 4
+#define IMPORT_MAX_AGE_LEN  3   // Same limit as the interactive age prompt
+
+static bool importNextField(const char **cursor, const char *end, char *out, size_t outSize,
+                            size_t *length, bool *tooLong);
+
+/*
+ * FUNCTION: importParseRow
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Splits one manifest row into its four fields and validates them with
+    *  the interactive rules: destination and address must be non-empty and
+    *  fit their buffers, the name must be "Firstname Lastname" and the age
+    *  must be 1-3 digits within MIN_CLIENT_AGE..MAX_CLIENT_AGE.
+ * PARAMETERS:
+    *  const char *line : Row text without its line terminator.
+    *  size_t length : Bytes in line.
+    *  char *destination : Receives the destination (MAX_DESTINATION_LEN bytes).
+    *  Client *client : Receives the client fields.
+ * RETURNS : ImportRowStatus - IMPORT_ROW_OK, or the first problem found.
+ */
+ImportRowStatus importParseRow(const char *line, size_t length, char *destination, Client *client) {
+    const char *cursor = line;
+    const char *end    = line + length;
+    char        name[MAX_NAME_LEN];
+    char        age[IMPORT_MAX_AGE_LEN + 1];
+    size_t      fieldLength[IMPORT_COLUMN_COUNT];
+    bool        tooLong[IMPORT_COLUMN_COUNT];
+
+    if (!importNextField(&cursor, end, destination, MAX_DESTINATION_LEN, &fieldLength[0], &tooLong[0])
+        || !importNextField(&cursor, end, name, sizeof(name), &fieldLength[1], &tooLong[1])
+        || !importNextField(&cursor, end, age, sizeof(age), &fieldLength[2], &tooLong[2])
+        || !importNextField(&cursor, end, client->address, MAX_ADDRESS_LEN, &fieldLength[3], &tooLong[3])
+        || cursor != NULL) {
+        return IMPORT_ROW_BAD_COLUMNS;
+    }
+
+    if (fieldLength[0] == 0 || tooLong[0]) {
+        return IMPORT_ROW_BAD_DESTINATION;
+    }
+
+    NameSplit split;
+    if (tooLong[1] || !scanClientName(name, fieldLength[1], &split)) {
+        return IMPORT_ROW_BAD_NAME;
+    }
+    memcpy(client->firstName, name, split.firstLength);
+    client->firstName[split.firstLength] = '\0';
+    memcpy(client->lastName, name + split.lastOffset, split.lastLength);
+    client->lastName[split.lastLength] = '\0';
+
+    if (tooLong[2] || !scanDigits(age, &client->age) || client->age < MIN_CLIENT_AGE
+        || client->age > MAX_CLIENT_AGE) {
+        return IMPORT_ROW_BAD_AGE;
+    }
+
+    if (fieldLength[3] == 0 || tooLong[3]) {
+        return IMPORT_ROW_BAD_ADDRESS;
+    }
+    return IMPORT_ROW_OK;
+}
+
+/*
+ * FUNCTION: importIsHeaderRow
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Recognises the optional IMPORT_HEADER_ROW (any letter case).
+ * PARAMETERS:
+    *  const char *line : Row text without its line terminator.
+    *  size_t length : Bytes in line.
+ * RETURNS : bool - true if the row is the column header.
+ */
+bool importIsHeaderRow(const char *line, size_t length) {
+    return length == sizeof(IMPORT_HEADER_ROW) - 1
+           && strncasecmp(line, IMPORT_HEADER_ROW, length) == SUCCESS;
+}
+
+/*
+ * FUNCTION: importRowStatusName
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Returns a short description of a row status for reports.
+ * PARAMETERS:
+    *  ImportRowStatus status : Status from importParseRow().
+ * RETURNS : const char * - static description.
+ */
+const char *importRowStatusName(ImportRowStatus status) {
+    switch (status) {
+        case IMPORT_ROW_OK:              return "ok";
+        case IMPORT_ROW_BAD_COLUMNS:     return "expected destination,name,age,address";
+        case IMPORT_ROW_BAD_DESTINATION: return "invalid destination";
+        case IMPORT_ROW_BAD_NAME:        return "name must be in 'First Last' format";
+        case IMPORT_ROW_BAD_AGE:         return "age is not a number or out of range";
+        case IMPORT_ROW_BAD_ADDRESS:     return "invalid address";
+    }
+    return "unknown";
+}
+
+/*
+ * FUNCTION: importNextField
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Copies the next CSV field into out and advances the cursor past its
+    *  comma. The cursor becomes NULL after the last field of the row.
+    *  Quoted fields may contain commas and "" for a quote. Bytes that do
+    *  not fit in out are skipped and reported through tooLong.
+ * PARAMETERS:
+    *  const char **cursor : Start of the field, NULL once the row is used up.
+    *  const char *end : End of the row.
+    *  char *out : Receives the null-terminated field.
+    *  size_t outSize : Size of out.
+    *  size_t *length : Receives the number of bytes stored in out.
+    *  bool *tooLong : Set when the field did not fit in out.
+ * RETURNS : bool - false if there was no field left or a quote was not closed.
+ */
+static bool importNextField(const char **cursor, const char *end, char *out, size_t outSize,
+                            size_t *length, bool *tooLong) {
+    const char *in = *cursor;
+    size_t      stored = 0;
+    size_t      seen   = 0;
+    if (!in) {
+        return false;
+    }
+
+    if (in < end && *in == '"') {
+        // Quoted field: runs to the closing quote, "" is a literal quote
+        in++;
+        for (;;) {
+            if (in == end) {
+                return false;   // Unterminated quote
+            }
+            if (*in == '"') {
+                if (in + 1 < end && in[1] == '"') {
+                    in++;
+                } else {
+                    in++;
+                    break;
+                }
+            }
+            if (stored + 1 < outSize) {
+                out[stored++] = *in;
+            }
+            seen++;
+            in++;
+        }
+        if (in != end && *in != ',') {
+            return false;   // Text after the closing quote
+        }
+    } else {
+        const char *comma = memchr(in, ',', (size_t)(end - in));
+        const char *stop  = comma ? comma : end;
+        seen              = (size_t)(stop - in);
+        stored            = seen < outSize ? seen : outSize - 1;
+        memcpy(out, in, stored);
+        in = stop;
+    }
+
+    out[stored] = '\0';
+    *length     = stored;
+    *tooLong    = seen > stored;
+    *cursor     = in < end ? in + 1 : NULL;   // Skip the comma, NULL after the last field
+    return true;
+}
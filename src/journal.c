@@ -0,0 +1,328 @@
+/*
+ * FILE: journal.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Binary write-ahead journal of party state changes. Appends go to an
+ * in-memory buffer; journalCommit() writes the buffer and issues a single
+ * fdatasync for everything appended since the previous commit. Replay maps
+ * the journal read-only and applies only complete commit groups: the
+ * records after the last JOURNAL_COMMIT marker, or from the first short or
+ * corrupt record on, are cut off so new records follow the last good group.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "journal.h"
+#include "shared.h"
+
+#define CRC32_POLYNOMIAL 0xEDB88320u   // Reflected IEEE 802.3 polynomial
+
+static int  journalWriteBuffer(Journal *journal);
+static bool journalReadRecord(const char *map, size_t size, size_t offset, JournalRecordHeader *header);
+
+/*
+ * FUNCTION: journalOpen
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Opens (creating if needed) the journal for appending after a replay.
+ * PARAMETERS:
+    *  Journal *journal : Journal state to initialise.
+    *  const char *path : Journal file.
+    *  uint64_t nextSequence : Sequence number of the first new record.
+ * RETURNS : int - SUCCESS, or ERROR (the journal is left off, fd -1).
+ */
+int journalOpen(Journal *journal, const char *path, uint64_t nextSequence) {
+    memset(journal, 0, sizeof(*journal));
+    journal->fd           = -1;
+    journal->nextSequence = nextSequence;
+
+    if (!(journal->buffer = malloc(JOURNAL_BUFFER_SIZE))) {
+        return ERROR;
+    }
+    if ((journal->fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, PERM_OWNER_RW_ALL_R)) == -1) {
+        free(journal->buffer);
+        journal->buffer = NULL;
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: journalAppend
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Adds a record to the journal buffer. The record is durable only after
+    *  the next journalCommit(). Does nothing when journaling is off.
+ * PARAMETERS:
+    *  Journal *journal : Open journal.
+    *  JournalRecordType type : Kind of change.
+    *  long pid : Session the change belongs to.
+    *  const void *payload : Record payload, may be NULL when length is 0.
+    *  size_t length : Payload bytes, at most JOURNAL_MAX_RECORD_SIZE.
+ * RETURNS : int - SUCCESS, or ERROR if the record is too large or a write failed.
+ */
+int journalAppend(Journal *journal, JournalRecordType type, long pid, const void *payload,
+                  size_t length) {
+    if (journal->fd == -1) {
+        return SUCCESS;
+    }
+    if (length > JOURNAL_MAX_RECORD_SIZE) {
+        return ERROR;
+    }
+    // Leave room for the commit marker so journalCommit() never writes twice
+    if (journal->used + BUFFER_SIZE_OF_TWO * sizeof(JournalRecordHeader) + length > JOURNAL_BUFFER_SIZE
+        && journalWriteBuffer(journal) == ERROR) {
+        return ERROR;
+    }
+
+    JournalRecordHeader header = {
+        .length   = (uint32_t)length,
+        .sequence = journal->nextSequence++,
+        .time     = (int64_t)time(NULL),
+        .pid      = (uint32_t)pid,
+        .type     = (uint8_t)type,
+    };
+    header.checksum = journalChecksum(&header, sizeof(header), 0);
+    header.checksum = journalChecksum(payload, length, header.checksum);
+
+    memcpy(journal->buffer + journal->used, &header, sizeof(header));
+    if (length > 0) {
+        memcpy(journal->buffer + journal->used + sizeof(header), payload, length);
+    }
+    journal->used += sizeof(header) + length;
+    if (type != JOURNAL_COMMIT) {
+        journal->sinceSnapshot++;
+        journal->records++;
+        journal->uncommitted = true;
+    }
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: journalCommit
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Makes every appended record durable: closes the group with a commit
+    *  marker, writes the buffer and runs one fdatasync for all records
+    *  written since the previous commit.
+ * PARAMETERS:
+    *  Journal *journal : Open journal.
+ * RETURNS : int - SUCCESS, or ERROR if the write or sync failed.
+ */
+int journalCommit(Journal *journal) {
+    if (journal->fd == -1 || !journal->uncommitted) {
+        return SUCCESS;
+    }
+    if (journalAppend(journal, JOURNAL_COMMIT, 0, NULL, 0) == ERROR
+        || journalWriteBuffer(journal) == ERROR || fdatasync(journal->fd) == -1) {
+        return ERROR;
+    }
+    journal->uncommitted = false;
+    journal->commits++;
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: journalTruncate
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Empties the journal once a snapshot covering all of its records has
+    *  been written. Sequence numbers keep counting from where they were.
+ * PARAMETERS:
+    *  Journal *journal : Open, committed journal.
+ * RETURNS : int - SUCCESS, or ERROR if the file could not be truncated.
+ */
+int journalTruncate(Journal *journal) {
+    if (journal->fd == -1) {
+        return SUCCESS;
+    }
+    if (journalCommit(journal) == ERROR || ftruncate(journal->fd, 0) == -1
+        || fdatasync(journal->fd) == -1) {
+        return ERROR;
+    }
+    journal->sinceSnapshot = 0;
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: journalClose
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Commits outstanding records and closes the journal. Later appends are ignored.
+ * PARAMETERS:
+    *  Journal *journal : Journal to close.
+ * RETURNS : n/a
+ */
+void journalClose(Journal *journal) {
+    if (journal->fd != -1) {
+        journalCommit(journal);
+        close(journal->fd);
+        journal->fd = -1;
+    }
+    free(journal->buffer);
+    journal->buffer = NULL;
+    journal->used   = 0;
+}
+
+/*
+ * FUNCTION: journalReplay
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Maps the journal and hands every committed record with a sequence
+    *  number above afterSequence to apply, in order. A first pass finds the
+    *  end of the last complete commit group, stopping at any record that is
+    *  cut short or fails its checksum (a write torn by a crash); the second
+    *  pass applies the records before it and the file is truncated there.
+ * PARAMETERS:
+    *  const char *path : Journal file; a missing file replays nothing.
+    *  uint64_t afterSequence : Last sequence number already in the snapshot.
+    *  JournalApply apply : Called for each record to replay.
+    *  void *context : Passed to apply.
+    *  uint64_t *lastSequence : Receives the highest sequence number seen (at least afterSequence).
+ * RETURNS : long - records applied, or ERROR if the journal could not be read.
+ */
+long journalReplay(const char *path, uint64_t afterSequence, JournalApply apply, void *context,
+                   uint64_t *lastSequence) {
+    struct stat info;
+    *lastSequence = afterSequence;
+
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd == -1) {
+        return errno == ENOENT ? 0 : ERROR;
+    }
+    if (fstat(fd, &info) == -1) {
+        close(fd);
+        return ERROR;
+    }
+    size_t size = (size_t)info.st_size;
+    if (size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    char *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return ERROR;
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+
+    JournalRecordHeader header;
+    size_t              committed = 0;
+    for (size_t offset = 0; journalReadRecord(map, size, offset, &header);) {
+        offset += sizeof(header) + header.length;
+        if (header.type == JOURNAL_COMMIT) {
+            committed = offset;
+        }
+    }
+
+    long applied = 0;
+    for (size_t offset = 0; offset < committed; offset += sizeof(header) + header.length) {
+        memcpy(&header, map + offset, sizeof(header));
+        if (header.sequence > afterSequence && header.type != JOURNAL_COMMIT) {
+            apply(context, &header, map + offset + sizeof(header));
+            applied++;
+        }
+        if (header.sequence > *lastSequence) {
+            *lastSequence = header.sequence;
+        }
+    }
+
+    munmap(map, size);
+
+    // Drop the torn tail so new records follow the last complete group
+    int result = committed < size ? ftruncate(fd, (off_t)committed) : SUCCESS;
+    close(fd);
+    return result == SUCCESS ? applied : ERROR;
+}
+
+/*
+ * FUNCTION: journalChecksum
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: CRC-32 (IEEE) of a buffer, continuing from a previous result.
+ * PARAMETERS:
+    *  const void *data : Bytes to add.
+    *  size_t length : Number of bytes.
+    *  uint32_t checksum : 0 to start, or the result of the previous call.
+ * RETURNS : uint32_t - the updated checksum.
+ */
+uint32_t journalChecksum(const void *data, size_t length, uint32_t checksum) {
+    static uint32_t table[256];
+    static bool     tableReady = false;
+    if (!tableReady) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? (value >> 1) ^ CRC32_POLYNOMIAL : value >> 1;
+            }
+            table[i] = value;
+        }
+        tableReady = true;
+    }
+
+    const unsigned char *bytes = data;
+    checksum = ~checksum;
+    for (size_t i = 0; i < length; i++) {
+        checksum = table[(checksum ^ bytes[i]) & 0xFF] ^ (checksum >> 8);
+    }
+    return ~checksum;
+}
+
+/*
+ * FUNCTION: journalReadRecord
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Reads and verifies the record at offset in the mapped journal.
+ * PARAMETERS:
+    *  const char *map : Mapped journal.
+    *  size_t size : Journal size.
+    *  size_t offset : Start of the record.
+    *  JournalRecordHeader *header : Receives the record header.
+ * RETURNS : bool - false at the end of the journal or if the record is short or corrupt.
+ */
+static bool journalReadRecord(const char *map, size_t size, size_t offset, JournalRecordHeader *header) {
+    if (size - offset < sizeof(*header)) {
+        return false;
+    }
+    memcpy(header, map + offset, sizeof(*header));
+    if (header->length > JOURNAL_MAX_RECORD_SIZE || size - offset - sizeof(*header) < header->length) {
+        return false;
+    }
+
+    uint32_t expected = header->checksum;
+    header->checksum  = 0;
+    uint32_t checksum = journalChecksum(header, sizeof(*header), 0);
+    checksum          = journalChecksum(map + offset + sizeof(*header), header->length, checksum);
+    header->checksum  = expected;
+    return checksum == expected;
+}
+
+/*
+ * FUNCTION: journalWriteBuffer
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Writes the buffered records to the journal file (no sync).
+ * PARAMETERS:
+    *  Journal *journal : Open journal.
+ * RETURNS : int - SUCCESS, or ERROR if the write failed.
+ */
+static int journalWriteBuffer(Journal *journal) {
+    size_t written = 0;
+    while (written < journal->used) {
+        ssize_t result = write(journal->fd, journal->buffer + written, journal->used - written);
+        if (result == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return ERROR;
+        }
+        written += (size_t)result;
+    }
+    journal->used = 0;
+    return SUCCESS;
+}
@@ -0,0 +1,393 @@
+/*
+ * FILE: logger.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * logger.c implements the asynchronous server logger.
+ *
+ * The queue is a bounded multi-producer / single-consumer ring. Each slot
+ * carries a sequence number: a slot at position pos is free for a producer
+ * when sequence == pos and holds a message for the writer when
+ * sequence == pos + 1. Producers claim positions with a compare-and-swap on
+ * tail and never block; when the ring is full the message is dropped and
+ * counted.
+ *
+ * The writer thread formats messages into a LOG_BATCH_SIZE buffer and
+ * writes it when it is nearly full or LOG_FLUSH_INTERVAL_MS after the last
+ * write. The "[Sat Oct 17 01:47:39 2026]" timestamp is formatted once per
+ * second and reused for every message in that second.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "shared.h"
+
+static void *loggerWriterThread(void *argument);
+static bool  loggerDequeue(Logger *logger, size_t *batchUsed, char *batch);
+static void  loggerFlush(Logger *logger, char *batch, size_t *batchUsed);
+static void  loggerCloseFile(Logger *logger);
+
+/*
+ * FUNCTION: loggerStart
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Opens the log file for appending, or the newest log segment for the
+    *  mmap backend, and starts the writer thread.
+ * PARAMETERS:
+    *  Logger *logger : Logger to start.
+    *  const char *path : Log file path (segment base name for LOG_BACKEND_MMAP).
+    *  LogBackend backend : How the writer thread stores lines.
+    *  size_t segmentSize : Bytes per segment before rotating (LOG_BACKEND_MMAP only).
+ * RETURNS : int - SUCCESS, or ERROR if the file, queue or thread failed.
+ */
+int loggerStart(Logger *logger, const char *path, LogBackend backend, size_t segmentSize) {
+    memset(logger, 0, sizeof(*logger));
+    logger->backend = backend;
+    logger->fd      = -1;
+    if (backend == LOG_BACKEND_MMAP) {
+        if (logSegmentOpen(&logger->segment, path, segmentSize) == ERROR) {
+            return ERROR;
+        }
+    } else {
+        logger->fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, PERM_OWNER_RW_ALL_R);
+        if (logger->fd == -1) {
+            perror("Error opening log file");
+            return ERROR;
+        }
+    }
+
+    logger->slots = malloc(sizeof(LogSlot) * LOG_QUEUE_CAPACITY);
+    if (!logger->slots) {
+        perror("Memory allocation failed");
+        loggerCloseFile(logger);
+        return ERROR;
+    }
+    for (size_t i = 0; i < LOG_QUEUE_CAPACITY; i++) {
+        atomic_init(&logger->slots[i].sequence, i);
+    }
+
+    pthread_mutex_init(&logger->wakeLock, NULL);
+    pthread_cond_init(&logger->wakeCondition, NULL);
+    logger->cachedSecond = (time_t)-1;
+
+    // The writer inherits a fully blocked mask so process signals are
+    // always delivered to the main thread's signalfd, never to the writer
+    sigset_t allSignals;
+    sigset_t previous;
+    sigfillset(&allSignals);
+    pthread_sigmask(SIG_SETMASK, &allSignals, &previous);
+    int created = pthread_create(&logger->writer, NULL, loggerWriterThread, logger);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    if (created != SUCCESS) {
+        errno = created;
+        perror("Error starting log writer");
+        pthread_cond_destroy(&logger->wakeCondition);
+        pthread_mutex_destroy(&logger->wakeLock);
+        free(logger->slots);
+        loggerCloseFile(logger);
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: loggerLog
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Queues a message for the writer thread. Never blocks and makes no
+    *  syscall unless the writer is asleep and has to be woken. Safe to call
+    *  from any thread.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  const char *message : Message to log (truncated to LOG_MAX_MESSAGE_LEN).
+ * RETURNS : n/a
+ */
+void loggerLog(Logger *logger, const char *message) {
+    if (!logger || !logger->slots || !message) {
+        return;
+    }
+
+    // Claim a slot
+    size_t   position = atomic_load_explicit(&logger->tail, memory_order_relaxed);
+    LogSlot *slot     = NULL;
+    for (;;) {
+        slot = &logger->slots[position & (LOG_QUEUE_CAPACITY - 1)];
+        size_t   sequence   = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&logger->tail, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            atomic_fetch_add_explicit(&logger->dropped, 1, memory_order_relaxed);
+            return;   // Queue full
+        } else {
+            position = atomic_load_explicit(&logger->tail, memory_order_relaxed);
+        }
+    }
+
+    // Fill and publish it
+    size_t length = strnlen(message, LOG_MAX_MESSAGE_LEN);
+    memcpy(slot->text, message, length);
+    slot->length    = (uint32_t)length;
+    slot->timestamp = time(NULL);
+    // Sequentially consistent so this store and the writerSleeping load
+    // pair up with the writer's store/load in the opposite order
+    atomic_store(&slot->sequence, position + 1);
+
+    if (atomic_load(&logger->writerSleeping)) {
+        pthread_mutex_lock(&logger->wakeLock);
+        pthread_cond_signal(&logger->wakeCondition);
+        pthread_mutex_unlock(&logger->wakeLock);
+    }
+}
+
+/*
+ * FUNCTION: loggerStop
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Writes every queued message, stops the writer thread and closes the log file.
+ * PARAMETERS:
+    *  Logger *logger : Logger to stop.
+ * RETURNS : n/a
+ */
+void loggerStop(Logger *logger) {
+    if (!logger || !logger->slots) {
+        return;
+    }
+
+    pthread_mutex_lock(&logger->wakeLock);
+    atomic_store(&logger->stopping, true);
+    pthread_cond_signal(&logger->wakeCondition);
+    pthread_mutex_unlock(&logger->wakeLock);
+    pthread_join(logger->writer, NULL);
+
+    pthread_cond_destroy(&logger->wakeCondition);
+    pthread_mutex_destroy(&logger->wakeLock);
+    free(logger->slots);
+    logger->slots = NULL;
+    loggerCloseFile(logger);
+}
+
+/*
+ * FUNCTION: loggerGetStats
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Returns a snapshot of the logger counters.
+ * PARAMETERS:
+    *  Logger *logger : Logger to inspect.
+ * RETURNS : LoggerStats - queue depth and message/batch counters.
+ */
+LoggerStats loggerGetStats(Logger *logger) {
+    LoggerStats stats = {0};
+    size_t      tail  = atomic_load(&logger->tail);
+    size_t      head  = atomic_load(&logger->headSnapshot);
+
+    stats.queueDepth    = tail > head ? tail - head : 0;
+    stats.maxQueueDepth = atomic_load(&logger->maxQueueDepth);
+    stats.logged        = atomic_load(&logger->logged);
+    stats.dropped       = atomic_load(&logger->dropped);
+    stats.batches       = atomic_load(&logger->batches);
+    stats.rotations     = atomic_load(&logger->rotations);
+    return stats;
+}
+
+/*
+ * FUNCTION: loggerDequeue
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Takes the next message off the queue (writer thread only) and appends
+    *  it to the batch as "[timestamp] message\n".
+ * PARAMETERS:
+    *  Logger *logger : Logger to read from.
+    *  size_t *batchUsed : Bytes used in batch, advanced by the line length.
+    *  char *batch : Batch buffer with room for one more line.
+ * RETURNS : bool - false if the queue was empty.
+ */
+static bool loggerDequeue(Logger *logger, size_t *batchUsed, char *batch) {
+    LogSlot *slot     = &logger->slots[logger->head & (LOG_QUEUE_CAPACITY - 1)];
+    size_t   sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (sequence != logger->head + 1) {
+        return false;
+    }
+
+    // Reformat the timestamp only when the second changes
+    if (slot->timestamp != logger->cachedSecond) {
+        struct tm local;
+        logger->cachedSecond = slot->timestamp;
+        if (!localtime_r(&slot->timestamp, &local)
+            || strftime(logger->cachedStamp, sizeof(logger->cachedStamp),
+                        "%a %b %e %H:%M:%S %Y", &local) == 0) {
+            snprintf(logger->cachedStamp, sizeof(logger->cachedStamp), "Unknown time");
+        }
+    }
+
+    char  *line          = batch + *batchUsed;
+    size_t stampLength   = strlen(logger->cachedStamp);
+    line[0]              = '[';
+    memcpy(line + 1, logger->cachedStamp, stampLength);
+    line[stampLength + 1] = ']';
+    line[stampLength + 2] = ' ';
+    memcpy(line + stampLength + 3, slot->text, slot->length);
+    line[stampLength + 3 + slot->length] = '\n';
+    *batchUsed += stampLength + 4 + slot->length;
+
+    // Hand the slot back to the producers
+    atomic_store_explicit(&slot->sequence, logger->head + LOG_QUEUE_CAPACITY, memory_order_release);
+    logger->head++;
+    atomic_fetch_add_explicit(&logger->logged, 1, memory_order_relaxed);
+    return true;
+}
+
+/*
+ * FUNCTION: loggerFlush
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Appends the batch to the log, with as few write() calls as possible
+    *  or, for the mmap backend, by copying it into the active segment and
+    *  syncing the segment when LOG_SEGMENT_SYNC_MS has passed.
+ * PARAMETERS:
+    *  Logger *logger : Logger owning the file.
+    *  char *batch : Formatted lines.
+    *  size_t *batchUsed : Bytes in batch, reset to 0.
+ * RETURNS : n/a
+ */
+static void loggerFlush(Logger *logger, char *batch, size_t *batchUsed) {
+    if (logger->backend == LOG_BACKEND_MMAP) {
+        unsigned long rotations = logger->segment.rotations;
+        if (logSegmentAppend(&logger->segment, batch, *batchUsed) == ERROR) {
+            fprintf(stderr, "Error appending to log segment, %zu bytes lost\n", *batchUsed);
+        }
+        atomic_fetch_add_explicit(&logger->rotations, logger->segment.rotations - rotations,
+                                  memory_order_relaxed);
+        if (logSegmentSyncDue(&logger->segment)) {
+            logSegmentSync(&logger->segment);
+        }
+    } else {
+        size_t written = 0;
+        while (written < *batchUsed) {
+            ssize_t result = write(logger->fd, batch + written, *batchUsed - written);
+            if (result == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                perror("Error writing log file");
+                break;
+            }
+            written += (size_t)result;
+        }
+    }
+    if (*batchUsed > 0) {
+        atomic_fetch_add_explicit(&logger->batches, 1, memory_order_relaxed);
+    }
+    *batchUsed = 0;
+}
+
+/*
+ * FUNCTION: loggerCloseFile
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Closes the log file or, for the mmap backend, syncs and unmaps the active segment.
+ * PARAMETERS:
+    *  Logger *logger : Logger owning the file.
+ * RETURNS : n/a
+ */
+static void loggerCloseFile(Logger *logger) {
+    if (logger->backend == LOG_BACKEND_MMAP) {
+        logSegmentClose(&logger->segment);
+    } else if (logger->fd != -1) {
+        close(logger->fd);
+        logger->fd = -1;
+    }
+}
+
+/*
+ * FUNCTION: loggerWriterThread
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Writer thread body. Drains the queue into the batch buffer and writes
+    *  the batch when it is nearly full or has waited LOG_FLUSH_INTERVAL_MS.
+    *  Sleeps on a condition variable while the queue is empty.
+ * PARAMETERS:
+    *  void *argument : The Logger.
+ * RETURNS : void * - NULL.
+ */
+static void *loggerWriterThread(void *argument) {
+    Logger         *logger    = argument;
+    const size_t    lineLimit = LOG_TIMESTAMP_SIZE + LOG_MAX_MESSAGE_LEN + BUFFER_SIZE_OF_FOUR;
+    char           *batch     = malloc(LOG_BATCH_SIZE);
+    size_t          batchUsed = 0;
+    struct timespec lastFlush;
+
+    if (!batch) {
+        perror("Memory allocation failed");
+        return NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &lastFlush);
+
+    for (;;) {
+        // Sample the backlog before draining it so the peak is meaningful
+        size_t depth = atomic_load(&logger->tail) - logger->head;
+        if (depth > atomic_load(&logger->maxQueueDepth)) {
+            atomic_store(&logger->maxQueueDepth, depth);
+        }
+
+        // Drain everything queued so far
+        while (loggerDequeue(logger, &batchUsed, batch)) {
+            if (LOG_BATCH_SIZE - batchUsed < lineLimit) {
+                loggerFlush(logger, batch, &batchUsed);
+                clock_gettime(CLOCK_MONOTONIC, &lastFlush);
+            }
+        }
+
+        atomic_store(&logger->headSnapshot, logger->head);
+
+        bool stopping = atomic_load(&logger->stopping);
+        if (batchUsed > 0 && (stopping || millisecondsSince(&lastFlush) >= LOG_FLUSH_INTERVAL_MS)) {
+            loggerFlush(logger, batch, &batchUsed);
+            clock_gettime(CLOCK_MONOTONIC, &lastFlush);
+        }
+        if (stopping && depth == 0) {
+            break;
+        }
+
+        // Going idle is the cheapest moment to push mapped lines to disk
+        if (batchUsed == 0 && logger->backend == LOG_BACKEND_MMAP) {
+            logSegmentSync(&logger->segment);
+        }
+
+        // Sleep until a producer wakes us or a partial batch is due
+        pthread_mutex_lock(&logger->wakeLock);
+        atomic_store(&logger->writerSleeping, true);
+        LogSlot *next = &logger->slots[logger->head & (LOG_QUEUE_CAPACITY - 1)];
+        if (atomic_load(&next->sequence) != logger->head + 1 && !atomic_load(&logger->stopping)) {
+            if (batchUsed == 0) {
+                pthread_cond_wait(&logger->wakeCondition, &logger->wakeLock);
+            } else {
+                struct timespec wakeAt;
+                clock_gettime(CLOCK_REALTIME, &wakeAt);
+                wakeAt.tv_nsec += LOG_FLUSH_INTERVAL_MS * 1000000L;
+                if (wakeAt.tv_nsec >= 1000000000L) {
+                    wakeAt.tv_sec++;
+                    wakeAt.tv_nsec -= 1000000000L;
+                }
+                pthread_cond_timedwait(&logger->wakeCondition, &logger->wakeLock, &wakeAt);
+            }
+        }
+        atomic_store(&logger->writerSleeping, false);
+        pthread_mutex_unlock(&logger->wakeLock);
+    }
+
+    free(batch);
+    return NULL;
+}
@@ -0,0 +1,127 @@
+/*
+ * FILE: logreader.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * The log reader prints the lines of a segmented, memory-mapped server log
+ * (server --mmap-log) in order, as if it were one plain travel_agency.log.
+ * With --stat it lists each segment's index, size and line count instead.
+*/
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "logsegment.h"
+#include "shared.h"
+
+int readSegment(const char *path, bool statOnly);
+
+int main(int argc, char *argv[]) {
+    const char *basePath = LOG_FILE_PATH;
+    bool        statOnly = false;
+
+    // Command line options
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stat") == SUCCESS) {
+            statOnly = true;
+        } else if (argv[i][0] != '-') {
+            basePath = argv[i];
+        } else {
+            printf("Usage: %s [--stat] [log path]\n", argv[0]);
+            return ERROR;
+        }
+    }
+
+    // Segments are numbered from 1 without gaps
+    char          path[LOG_SEGMENT_MAX_PATH];
+    unsigned long index = 1;
+    for (;; index++) {
+        logSegmentPath(path, sizeof(path), basePath, index);
+        if (access(path, F_OK) == -1) {
+            break;
+        }
+        if (readSegment(path, statOnly) == ERROR) {
+            return ERROR;
+        }
+    }
+
+    if (index == 1) {
+        fprintf(stderr, "No log segments found for %s\n", basePath);
+        return ERROR;
+    }
+    fflush(stdout);
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: readSegment
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Maps one segment read-only, validates its header and either writes
+    *  its lines to stdout or prints a one line summary of it.
+ * PARAMETERS:
+    *  const char *path : Segment file.
+    *  bool statOnly : Print the summary instead of the lines.
+ * RETURNS : int - SUCCESS, or ERROR if the segment is not a valid log segment.
+ */
+int readSegment(const char *path, bool statOnly) {
+    struct stat info;
+    int         fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1 || fstat(fd, &info) == -1) {
+        perror(path);
+        if (fd != -1) {
+            close(fd);
+        }
+        return ERROR;
+    }
+    if ((size_t)info.st_size < LOG_SEGMENT_HEADER_SIZE) {
+        fprintf(stderr, "%s: too short for a log segment\n", path);
+        close(fd);
+        return ERROR;
+    }
+
+    char *map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror(path);
+        return ERROR;
+    }
+
+    const LogSegmentHeader *header = (const LogSegmentHeader *)map;
+    if (memcmp(header->magic, LOG_SEGMENT_MAGIC, LOG_SEGMENT_MAGIC_LEN) != SUCCESS
+        || header->version != LOG_SEGMENT_VERSION
+        || header->capacity > (size_t)info.st_size - LOG_SEGMENT_HEADER_SIZE) {
+        fprintf(stderr, "%s: not a version %d log segment\n", path, LOG_SEGMENT_VERSION);
+        munmap(map, (size_t)info.st_size);
+        return ERROR;
+    }
+
+    const char *records = map + LOG_SEGMENT_HEADER_SIZE;
+    size_t      length  = logSegmentRecordLength(header, records);
+    if (statOnly) {
+        size_t      lines   = 0;
+        const char *cursor  = records;
+        const char *end     = records + length;
+        time_t      created = (time_t)header->created;
+        char        stamp[LOG_TIMESTAMP_SIZE];
+        while ((cursor = memchr(cursor, '\n', (size_t)(end - cursor))) != NULL) {
+            lines++;
+            cursor++;
+        }
+        strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localtime(&created));
+        printf("%s  index %lu  created %s  %zu/%lu bytes (%lu committed)  %zu lines\n",
+               path, (unsigned long)header->index, stamp, length,
+               (unsigned long)header->capacity, (unsigned long)header->committed, lines);
+    } else {
+        fwrite(records, 1, length, stdout);
+    }
+
+    munmap(map, (size_t)info.st_size);
+    return SUCCESS;
+}
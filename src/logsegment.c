@@ -0,0 +1,358 @@
+/*
+ * FILE: logsegment.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Memory-mapped log segments. A segment is fallocated to its full size up
+ * front and mapped MAP_SHARED, so appending a batch of log lines is a
+ * memcpy with no write() call and no stdio buffer. Dirty pages are pushed
+ * out with msync at most LOG_SEGMENT_SYNC_MS apart, and the header's
+ * committed length only advances after the data it covers has been synced,
+ * so a crash can lose the newest lines but never reorder or tear older ones.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "logsegment.h"
+#include "shared.h"
+
+static int  logSegmentCreate(LogSegment *segment, unsigned long index);
+static int  logSegmentResume(LogSegment *segment, unsigned long index);
+static int  logSegmentMap(LogSegment *segment);
+static void logSegmentRetire(LogSegment *segment);
+
+/*
+ * FUNCTION: logSegmentOpen
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Opens the newest segment for basePath and continues appending to it,
+    *  or starts segment 1 if none exist yet. A newest segment that is full
+    *  or unreadable is left alone and the next index is started.
+ * PARAMETERS:
+    *  LogSegment *segment : Segment state to initialise.
+    *  const char *basePath : Log path the segment names are derived from.
+    *  size_t segmentSize : Size of each segment file (rotate-by-size limit).
+ * RETURNS : int - SUCCESS, or ERROR if no segment could be opened.
+ */
+int logSegmentOpen(LogSegment *segment, const char *basePath, size_t segmentSize) {
+    memset(segment, 0, sizeof(*segment));
+    segment->fd = -1;
+    if (segmentSize < LOG_SEGMENT_MIN_SIZE) {
+        segmentSize = LOG_SEGMENT_MIN_SIZE;
+    }
+    segment->segmentSize = segmentSize;
+    snprintf(segment->basePath, sizeof(segment->basePath), "%s", basePath);
+
+    // Find the newest existing segment
+    unsigned long newest = 0;
+    char          path[LOG_SEGMENT_MAX_PATH];
+    struct stat   info;
+    for (;;) {
+        logSegmentPath(path, sizeof(path), basePath, newest + 1);
+        if (stat(path, &info) == -1) {
+            break;
+        }
+        newest++;
+    }
+
+    if (newest > 0 && logSegmentResume(segment, newest) == SUCCESS) {
+        return SUCCESS;
+    }
+    return logSegmentCreate(segment, newest + 1);
+}
+
+/*
+ * FUNCTION: logSegmentAppend
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Copies complete log lines into the mapped segment. When the lines do
+    *  not fit, the ones that do are copied, the segment is rotated, and the
+    *  rest continue in the new segment, so no line is split across files.
+ * PARAMETERS:
+    *  LogSegment *segment : Active segment.
+    *  const char *data : One or more newline-terminated lines.
+    *  size_t length : Bytes in data.
+ * RETURNS : int - SUCCESS, or ERROR if rotation failed.
+ */
+int logSegmentAppend(LogSegment *segment, const char *data, size_t length) {
+    while (length > 0) {
+        if (!segment->map) {
+            return ERROR;
+        }
+
+        size_t room = segment->header->capacity - segment->used;
+        size_t take = length;
+        if (take > room) {
+            // Fill up to the last line that still fits
+            const char *lastNewline = room > 0 ? memrchr(data, '\n', room) : NULL;
+            take = lastNewline ? (size_t)(lastNewline - data) + 1 : 0;
+            if (take == 0 && segment->used == 0) {
+                take = room;   // A single line larger than a whole segment
+            }
+        }
+
+        memcpy(segment->map + LOG_SEGMENT_HEADER_SIZE + segment->used, data, take);
+        segment->used += take;
+        data          += take;
+        length        -= take;
+
+        if (length > 0) {
+            unsigned long next = segment->index + 1;
+            logSegmentRetire(segment);
+            if (logSegmentCreate(segment, next) == ERROR) {
+                return ERROR;
+            }
+            segment->rotations++;
+        }
+    }
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: logSegmentSync
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Synchronously flushes the lines appended since the last sync, then
+    *  advances the header's committed length to cover them.
+ * PARAMETERS:
+    *  LogSegment *segment : Active segment.
+ * RETURNS : n/a
+ */
+void logSegmentSync(LogSegment *segment) {
+    if (!segment->map) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &segment->lastSync);
+    if (segment->used == segment->synced) {
+        return;
+    }
+
+    // msync needs a page aligned start address
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t from     = (LOG_SEGMENT_HEADER_SIZE + segment->synced) & ~(pageSize - 1);
+    size_t to       = LOG_SEGMENT_HEADER_SIZE + segment->used;
+    if (msync(segment->map + from, to - from, MS_SYNC) == -1) {
+        perror("Error syncing log segment");
+        return;
+    }
+
+    // Only now is it safe to claim these bytes as committed
+    segment->synced             = segment->used;
+    segment->header->committed  = segment->used;
+    msync(segment->map, pageSize, MS_ASYNC);
+}
+
+/*
+ * FUNCTION: logSegmentSyncDue
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Reports whether unsynced lines have waited LOG_SEGMENT_SYNC_MS.
+ * PARAMETERS:
+    *  const LogSegment *segment : Active segment.
+ * RETURNS : bool - true if logSegmentSync should run now.
+ */
+bool logSegmentSyncDue(const LogSegment *segment) {
+    return segment->used != segment->synced
+           && millisecondsSince(&segment->lastSync) >= LOG_SEGMENT_SYNC_MS;
+}
+
+/*
+ * FUNCTION: logSegmentClose
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Syncs and closes the active segment. The file keeps its full size so it can be resumed.
+ * PARAMETERS:
+    *  LogSegment *segment : Active segment.
+ * RETURNS : n/a
+ */
+void logSegmentClose(LogSegment *segment) {
+    if (!segment->map) {
+        return;
+    }
+    logSegmentSync(segment);
+    munmap(segment->map, segment->segmentSize);
+    close(segment->fd);
+    segment->map    = NULL;
+    segment->header = NULL;
+    segment->fd     = -1;
+}
+
+/*
+ * FUNCTION: logSegmentPath
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Builds the file name of a segment, e.g. "travel_agency.log.000003".
+ * PARAMETERS:
+    *  char *out : Output buffer.
+    *  size_t size : Size of out.
+    *  const char *basePath : Log path.
+    *  unsigned long index : 1-based segment number.
+ * RETURNS : n/a
+ */
+void logSegmentPath(char *out, size_t size, const char *basePath, unsigned long index) {
+    snprintf(out, size, LOG_SEGMENT_INDEX_FORMAT, basePath, index);
+}
+
+/*
+ * FUNCTION: logSegmentRecordLength
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Returns how many record bytes a segment holds: everything up to the
+    *  committed length, plus any later lines that reached the page cache
+    *  before a crash (they end at the first NUL of the zero filled tail).
+ * PARAMETERS:
+    *  const LogSegmentHeader *header : Header of a mapped segment.
+    *  const char *records : First byte after the header.
+ * RETURNS : size_t - record bytes in the segment.
+ */
+size_t logSegmentRecordLength(const LogSegmentHeader *header, const char *records) {
+    size_t committed = header->committed < header->capacity ? header->committed : header->capacity;
+    return committed + strnlen(records + committed, header->capacity - committed);
+}
+
+/*
+ * FUNCTION: logSegmentCreate
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Creates, preallocates and maps a new segment and writes its header.
+ * PARAMETERS:
+    *  LogSegment *segment : Segment state (basePath and segmentSize set).
+    *  unsigned long index : Segment number to create.
+ * RETURNS : int - SUCCESS, or ERROR if the file could not be created or mapped.
+ */
+static int logSegmentCreate(LogSegment *segment, unsigned long index) {
+    char path[LOG_SEGMENT_MAX_PATH];
+    logSegmentPath(path, sizeof(path), segment->basePath, index);
+
+    segment->fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, PERM_OWNER_RW_ALL_R);
+    if (segment->fd == -1) {
+        perror("Error creating log segment");
+        return ERROR;
+    }
+
+    // Reserve the whole extent now so appends never allocate blocks
+    int result = fallocate(segment->fd, 0, 0, (off_t)segment->segmentSize);
+    if (result == -1 && (errno == EOPNOTSUPP || errno == ENOSYS)) {
+        result = ftruncate(segment->fd, (off_t)segment->segmentSize);
+    }
+    if (result == -1) {
+        perror("Error preallocating log segment");
+        close(segment->fd);
+        unlink(path);
+        segment->fd = -1;
+        return ERROR;
+    }
+
+    if (logSegmentMap(segment) == ERROR) {
+        close(segment->fd);
+        unlink(path);
+        segment->fd = -1;
+        return ERROR;
+    }
+
+    LogSegmentHeader *header = segment->header;
+    memcpy(header->magic, LOG_SEGMENT_MAGIC, LOG_SEGMENT_MAGIC_LEN);
+    header->version    = LOG_SEGMENT_VERSION;
+    header->headerSize = LOG_SEGMENT_HEADER_SIZE;
+    header->index      = index;
+    header->capacity   = segment->segmentSize - LOG_SEGMENT_HEADER_SIZE;
+    header->committed  = 0;
+    header->created    = (int64_t)time(NULL);
+
+    segment->index  = index;
+    segment->used   = 0;
+    segment->synced = 0;
+    msync(segment->map, LOG_SEGMENT_HEADER_SIZE, MS_SYNC);
+    clock_gettime(CLOCK_MONOTONIC, &segment->lastSync);
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: logSegmentResume
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Maps an existing segment and positions the writer after its last line.
+ * PARAMETERS:
+    *  LogSegment *segment : Segment state (basePath and segmentSize set).
+    *  unsigned long index : Segment number to resume.
+ * RETURNS : int - SUCCESS, or ERROR if the segment is full, foreign or a different size.
+ */
+static int logSegmentResume(LogSegment *segment, unsigned long index) {
+    char        path[LOG_SEGMENT_MAX_PATH];
+    struct stat info;
+    logSegmentPath(path, sizeof(path), segment->basePath, index);
+
+    segment->fd = open(path, O_RDWR | O_CLOEXEC);
+    if (segment->fd == -1) {
+        return ERROR;
+    }
+    if (fstat(segment->fd, &info) == -1 || (size_t)info.st_size != segment->segmentSize
+        || logSegmentMap(segment) == ERROR) {
+        close(segment->fd);
+        segment->fd = -1;
+        return ERROR;
+    }
+
+    LogSegmentHeader *header = segment->header;
+    if (memcmp(header->magic, LOG_SEGMENT_MAGIC, LOG_SEGMENT_MAGIC_LEN) != SUCCESS
+        || header->version != LOG_SEGMENT_VERSION
+        || header->capacity != segment->segmentSize - LOG_SEGMENT_HEADER_SIZE) {
+        logSegmentClose(segment);
+        return ERROR;
+    }
+
+    segment->index  = index;
+    segment->used   = logSegmentRecordLength(header, segment->map + LOG_SEGMENT_HEADER_SIZE);
+    segment->synced = header->committed;
+    if (segment->used == header->capacity) {
+        logSegmentClose(segment);
+        return ERROR;
+    }
+    logSegmentSync(segment);
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: logSegmentMap
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Maps segment->fd read/write and shared.
+ * PARAMETERS:
+    *  LogSegment *segment : Segment with an open, full size fd.
+ * RETURNS : int - SUCCESS or ERROR.
+ */
+static int logSegmentMap(LogSegment *segment) {
+    void *map = mmap(NULL, segment->segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, segment->fd, 0);
+    if (map == MAP_FAILED) {
+        perror("Error mapping log segment");
+        return ERROR;
+    }
+    segment->map    = map;
+    segment->header = map;
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: logSegmentRetire
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Closes a full segment and trims the file to the lines it holds, giving
+    *  back the unused part of the preallocated extent.
+ * PARAMETERS:
+    *  LogSegment *segment : Active segment.
+ * RETURNS : n/a
+ */
+static void logSegmentRetire(LogSegment *segment) {
+    // Retired segments are never appended to again, so mark them full
+    segment->header->capacity = segment->used;
+    size_t length = LOG_SEGMENT_HEADER_SIZE + segment->used;
+    int    fd     = dup(segment->fd);
+
+    logSegmentClose(segment);
+    if (fd != -1) {
+        if (ftruncate(fd, (off_t)length) == -1) {
+            perror("Error trimming log segment");
+        }
+        close(fd);
+    }
+}
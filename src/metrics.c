@@ -0,0 +1,258 @@
+/*
+ * FILE: metrics.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Per-thread metric shards and their Prometheus text snapshot.
+ *
+ * Histogram bucket i < METRICS_SUB_BUCKETS holds the value i. Above that,
+ * a value with its highest bit at position e lands in group
+ * e - METRICS_SUB_BUCKET_BITS + 1, at the sub-bucket given by the
+ * METRICS_SUB_BUCKET_BITS bits below the highest one. The histogram is
+ * published with a bucket per power of two between
+ * METRICS_FIRST_LE_EXPONENT and METRICS_LAST_LE_EXPONENT nanoseconds, which
+ * are bucket edges, and with quantiles read from the full resolution.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "metrics.h"
+
+#define METRICS_FIRST_LE_EXPONENT 10     // 1.024 microseconds
+#define METRICS_LAST_LE_EXPONENT  34     // 17.2 seconds
+#define METRICS_TEXT_SIZE         8192   // Counters, histogram and quantiles
+#define METRICS_GAUGE_TEXT_SIZE   512    // Per gauge
+
+// How each counter is published
+static const struct {
+    const char *name;
+    const char *help;
+} counterInfo[METRICS_COUNTERS] = {
+    [METRICS_MESSAGES]     = {"messages_total", "Records read from client sessions, not counting HELLO registrations."},
+    [METRICS_BYTES]        = {"received_bytes_total", "Bytes read from client sessions."},
+    [METRICS_PARTIES]      = {"parties_total", "Parties completed."},
+    [METRICS_CLIENTS]      = {"clients_total", "Clients added to parties."},
+    [METRICS_PARSE_ERRORS] = {"parse_errors_total", "Records dropped by the reader or rejected by the parsers."},
+};
+
+// Quantiles published from the histogram
+static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+/*
+ * FUNCTION: bucketIndex
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Finds the histogram bucket of a value.
+ * PARAMETERS:
+    *  uint64_t value : Nanoseconds.
+ * RETURNS : int - bucket index, the last bucket for values beyond the range.
+ */
+static int bucketIndex(uint64_t value) {
+    if (value < METRICS_SUB_BUCKETS) {
+        return (int)value;
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent >= METRICS_MAX_EXPONENT) {
+        return METRICS_BUCKETS - 1;
+    }
+    int shift = exponent - METRICS_SUB_BUCKET_BITS;
+    return (shift + 1) * METRICS_SUB_BUCKETS + (int)((value >> shift) & (METRICS_SUB_BUCKETS - 1));
+}
+
+/*
+ * FUNCTION: bucketLimit
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Returns the first value past a bucket.
+ * PARAMETERS:
+    *  int index : Bucket index.
+ * RETURNS : uint64_t - the bucket's exclusive upper bound in nanoseconds.
+ */
+static uint64_t bucketLimit(int index) {
+    if (index < METRICS_SUB_BUCKETS) {
+        return (uint64_t)index + 1;
+    }
+    int group    = index / METRICS_SUB_BUCKETS;
+    int position = index % METRICS_SUB_BUCKETS;
+    return (uint64_t)(METRICS_SUB_BUCKETS + position + 1) << (group - 1);
+}
+
+/*
+ * FUNCTION: appendText
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: snprintf()s onto the end of a buffer; output that does not fit is cut off.
+ * PARAMETERS:
+    *  char *out : Buffer.
+    *  size_t size : Size of out.
+    *  size_t *used : Bytes in out so far, advanced past the new text.
+    *  const char *format : printf format.
+ * RETURNS : n/a
+ */
+static void appendText(char *out, size_t size, size_t *used, const char *format, ...) {
+    if (*used + 1 >= size) {
+        return;
+    }
+    va_list arguments;
+    va_start(arguments, format);
+    int written = vsnprintf(out + *used, size - *used, format, arguments);
+    va_end(arguments);
+    if (written > 0) {
+        *used += (size_t)written < size - *used ? (size_t)written : size - *used - 1;
+    }
+}
+
+/*
+ * FUNCTION: metricsNow
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Reads CLOCK_MONOTONIC, the clock latencies are measured on.
+ * PARAMETERS: n/a
+ * RETURNS : uint64_t - nanoseconds.
+ */
+uint64_t metricsNow(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/*
+ * FUNCTION: metricsCount
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Adds to a counter of the calling thread's shard, without a locked instruction.
+ * PARAMETERS:
+    *  MetricsShard *shard : Shard only the calling thread writes.
+    *  MetricsCounter counter : Counter to add to.
+    *  uint64_t amount : Amount to add.
+ * RETURNS : n/a
+ */
+void metricsCount(MetricsShard *shard, MetricsCounter counter, uint64_t amount) {
+    atomic_uint_fast64_t *value = &shard->counters[counter];
+    atomic_store_explicit(value, atomic_load_explicit(value, memory_order_relaxed) + amount,
+                          memory_order_relaxed);
+}
+
+/*
+ * FUNCTION: metricsRecordLatency
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Counts one latency in the calling thread's histogram.
+ * PARAMETERS:
+    *  MetricsShard *shard : Shard only the calling thread writes.
+    *  uint64_t nanos : Latency.
+ * RETURNS : n/a
+ */
+void metricsRecordLatency(MetricsShard *shard, uint64_t nanos) {
+    LatencyHistogram     *histogram = &shard->latency;
+    atomic_uint_fast64_t *bucket    = &histogram->buckets[bucketIndex(nanos)];
+    atomic_store_explicit(bucket, atomic_load_explicit(bucket, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_store_explicit(&histogram->count,
+                          atomic_load_explicit(&histogram->count, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_store_explicit(&histogram->sumNs,
+                          atomic_load_explicit(&histogram->sumNs, memory_order_relaxed) + nanos,
+                          memory_order_relaxed);
+    if (nanos > atomic_load_explicit(&histogram->maxNs, memory_order_relaxed)) {
+        atomic_store_explicit(&histogram->maxNs, nanos, memory_order_relaxed);
+    }
+}
+
+/*
+ * FUNCTION: metricsFormat
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Sums the shards and formats them, with the caller's extra values, in
+    *  Prometheus text exposition format. The shards keep counting while
+    *  they are read, so a snapshot may be a few updates behind; the
+    *  histogram's own count is the sum of the buckets read, so its buckets
+    *  and count always agree.
+ * PARAMETERS:
+    *  MetricsShard *const *shards : Shards of every thread.
+    *  int shardCount : Number of shards.
+    *  const MetricsGauge *gauges : Gauges and outside counters to add.
+    *  int gaugeCount : Number of them.
+    *  size_t *length : Receives the snapshot length.
+ * RETURNS : char * - malloc'd snapshot for the caller to free, or NULL if memory ran out.
+ */
+char *metricsFormat(MetricsShard *const *shards, int shardCount, const MetricsGauge *gauges,
+                    int gaugeCount, size_t *length) {
+    uint64_t counters[METRICS_COUNTERS] = {0};
+    uint64_t buckets[METRICS_BUCKETS]   = {0};
+    uint64_t count                      = 0;
+    uint64_t sumNs                      = 0;
+    uint64_t maxNs                      = 0;
+    for (int i = 0; i < shardCount; i++) {
+        const MetricsShard *shard = shards[i];
+        for (int counter = 0; counter < METRICS_COUNTERS; counter++) {
+            counters[counter] += atomic_load_explicit(&shard->counters[counter], memory_order_relaxed);
+        }
+        for (int bucket = 0; bucket < METRICS_BUCKETS; bucket++) {
+            uint64_t hits = atomic_load_explicit(&shard->latency.buckets[bucket], memory_order_relaxed);
+            buckets[bucket] += hits;
+            count           += hits;
+        }
+        sumNs += atomic_load_explicit(&shard->latency.sumNs, memory_order_relaxed);
+        uint64_t shardMax = atomic_load_explicit(&shard->latency.maxNs, memory_order_relaxed);
+        maxNs = shardMax > maxNs ? shardMax : maxNs;
+    }
+
+    size_t size = METRICS_TEXT_SIZE + (size_t)gaugeCount * METRICS_GAUGE_TEXT_SIZE;
+    size_t used = 0;
+    char  *out  = malloc(size);
+    if (!out) {
+        return NULL;
+    }
+
+    for (int counter = 0; counter < METRICS_COUNTERS; counter++) {
+        const char *name = counterInfo[counter].name;
+        appendText(out, size, &used, "# HELP " METRICS_NAME_PREFIX "%s %s\n# TYPE " METRICS_NAME_PREFIX
+                   "%s counter\n" METRICS_NAME_PREFIX "%s %llu\n", name, counterInfo[counter].help, name,
+                   name, (unsigned long long)counters[counter]);
+    }
+
+    const char *latency = METRICS_NAME_PREFIX "record_latency_seconds";
+    appendText(out, size, &used, "# HELP %s Time from reading a record to committing and acknowledging it.\n"
+               "# TYPE %s histogram\n", latency, latency);
+    uint64_t below = 0;
+    int      index = 0;
+    for (int exponent = METRICS_FIRST_LE_EXPONENT; exponent <= METRICS_LAST_LE_EXPONENT; exponent++) {
+        for (int edge = bucketIndex(1ULL << exponent); index < edge; index++) {
+            below += buckets[index];
+        }
+        // The bound is a whole number of nanoseconds, so nine decimals print it exactly
+        uint64_t bound = 1ULL << exponent;
+        appendText(out, size, &used, "%s_bucket{le=\"%llu.%09llu\"} %llu\n", latency,
+                   (unsigned long long)(bound / 1000000000ULL), (unsigned long long)(bound % 1000000000ULL),
+                   (unsigned long long)below);
+    }
+    appendText(out, size, &used, "%s_bucket{le=\"+Inf\"} %llu\n%s_sum %.9f\n%s_count %llu\n", latency,
+               (unsigned long long)count, latency, (double)sumNs / 1e9, latency, (unsigned long long)count);
+
+    // Quantiles at the histogram's full resolution: the upper edge of the bucket holding the rank
+    const char *quantile = METRICS_NAME_PREFIX "record_latency_quantile_seconds";
+    appendText(out, size, &used, "# HELP %s Record latency quantiles, within %.2f%%.\n# TYPE %s gauge\n",
+               quantile, 100.0 / METRICS_SUB_BUCKETS, quantile);
+    for (size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++) {
+        uint64_t rank  = (uint64_t)(quantiles[q] * (double)count);
+        uint64_t seen  = 0;
+        uint64_t value = 0;
+        for (int bucket = 0; count > 0 && bucket < METRICS_BUCKETS; bucket++) {
+            if ((seen += buckets[bucket]) > rank || seen == count) {
+                value = bucketLimit(bucket) - 1;
+                break;
+            }
+        }
+        appendText(out, size, &used, "%s{quantile=\"%g\"} %.9f\n", quantile, quantiles[q],
+                   (double)(value < maxNs ? value : maxNs) / 1e9);
+    }
+    appendText(out, size, &used, "%s{quantile=\"1\"} %.9f\n", quantile, (double)maxNs / 1e9);
+
+    for (int i = 0; i < gaugeCount; i++) {
+        appendText(out, size, &used, "# HELP " METRICS_NAME_PREFIX "%s %s\n# TYPE " METRICS_NAME_PREFIX
+                   "%s %s\n" METRICS_NAME_PREFIX "%s %.17g\n", gauges[i].name, gauges[i].help,
+                   gauges[i].name, gauges[i].counter ? "counter" : "gauge", gauges[i].name, gauges[i].value);
+    }
+
+    *length = used;
+    return out;
+}
@@ -0,0 +1,375 @@
+/*
+ * FILE: parser.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Decodes session records into ParsedRecords for the server's aggregator
+ * and reassembles WIRE_BATCH chunks. A Parser holds the state of one
+ * session and travels with it, so whichever parser thread runs or steals
+ * the session's turn parses its next records; a session only has one turn
+ * at a time. The decoders keep no state of their own, so any number of
+ * sessions are parsed at once.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parser.h"
+
+static void parseText(const RecordView *record, ParsedRecord *out);
+static void parseFrame(const RecordView *record, ParsedRecord *out);
+static bool parseBatchChunk(Parser *parser, ParsedRecord *out);
+static bool parseReplay(Parser *parser, ParsedRecord *out);
+static void parseReject(ParsedRecord *out, const char *reason);
+
+/*
+ * FUNCTION: parserInit
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Prepares a parser with no batches in progress.
+ * PARAMETERS:
+    *  Parser *parser : Parser to initialise.
+ * RETURNS : n/a
+ */
+void parserInit(Parser *parser) {
+    memset(parser, 0, sizeof(*parser));
+}
+
+/*
+ * FUNCTION: parserFree
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Releases the reassembly buffers of all batches.
+ * PARAMETERS:
+    *  Parser *parser : Parser to free.
+ * RETURNS : n/a
+ */
+void parserFree(Parser *parser) {
+    for (int i = 0; parser->batches && i < MAX_PENDING_BATCHES; i++) {
+        free(parser->batches[i].data);
+    }
+    free(parser->batches);
+    memset(parser, 0, sizeof(*parser));
+}
+
+/*
+ * FUNCTION: parserFeed
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Hands the parser the next record of a session. Call parserNext()
+    *  until it returns false before feeding another record.
+ * PARAMETERS:
+    *  Parser *parser : Parser to feed.
+    *  const RecordView *record : Record from the framer, at most PARSER_MAX_LINE bytes.
+ * RETURNS : n/a
+ */
+void parserFeed(Parser *parser, const RecordView *record) {
+    parser->record = *record;
+    parser->fed    = true;
+}
+
+/*
+ * FUNCTION: parserNext
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Writes out the next result of the record fed in. Most records give
+    *  exactly one; the chunk that completes a batch gives one per frame of
+    *  the batch and then the counted result of the chunk itself.
+ * PARAMETERS:
+    *  Parser *parser : Parser holding a record.
+    *  ParsedRecord *out : Receives the result, may be the item of an outgoing queue.
+ * RETURNS : bool - false once the record is fully parsed.
+ */
+bool parserNext(Parser *parser, ParsedRecord *out) {
+    out->kind     = PARSED_NOTHING;
+    out->text     = PARSED_TEXT_OTHER;
+    out->batch    = PARSED_BATCH_SAME;
+    out->counted  = false;
+    out->rejected = false;
+    out->echo     = false;
+    out->line[0]  = '\0';
+
+    if (parser->replaying) {
+        return parseReplay(parser, out);
+    }
+    if (!parser->fed) {
+        return false;
+    }
+    parser->fed  = false;
+    out->counted = true;
+
+    if (parser->record.type == WIRE_TEXT) {
+        parseText(&parser->record, out);
+    } else if (parser->record.type != WIRE_BATCH) {
+        parseFrame(&parser->record, out);
+    } else if (parseBatchChunk(parser, out)) {
+        out->counted = false;   // The chunk is counted after the frames it completed
+        return parseReplay(parser, out);
+    }
+    return true;
+}
+
+/*
+ * FUNCTION: parseText
+ * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca & Tuan Thanh Nguyen
+ * DESCRIPTION:
+    *  Parses one text line. Commands are recognised here; any other line
+    *  may still be a party's destination, which only the party state can
+    *  tell, so its client data is decoded in case it is needed.
+ * PARAMETERS:
+    *  const RecordView *record : Text line, null-terminated at its length.
+    *  ParsedRecord *out : Receives the result.
+ * RETURNS : n/a
+ */
+static void parseText(const RecordView *record, ParsedRecord *out) {
+    size_t   length = record->length < PARSER_MAX_LINE ? record->length : PARSER_MAX_LINE;
+
+    memcpy(out->line, record->data, length);
+    out->line[length] = '\0';
+    out->echo         = true;
+
+    if (recordEquals(record, "party")) {
+        out->kind = PARSED_PARTY;
+        return;
+    }
+    if (recordEquals(record, "stop")) {
+        out->kind = PARSED_STOP;
+        return;
+    }
+
+    out->kind              = PARSED_TEXT;
+    out->destinationLength = length < MAX_DESTINATION_LEN - 1 ? length : MAX_DESTINATION_LEN - 1;
+    if (recordEquals(record, "client")) {
+        out->text = PARSED_TEXT_PROMPT;
+    } else if (recordEquals(record, "END_PARTY") || recordEquals(record, "end")) {
+        out->text = PARSED_TEXT_END;
+    } else if (memchr(record->data, ',', record->length) != NULL
+               && textDecodeClient(record->data, record->length, &out->client)) {
+        // Client data: "FirstName,LastName,Age,Address"
+        out->text = PARSED_TEXT_CLIENT;
+    }
+}
+
+/*
+ * FUNCTION: parseFrame
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Decodes one binary frame. Its log line is the same text the text
+    *  protocol would have sent, so the log reads the same whichever
+    *  format the client used.
+ * PARAMETERS:
+    *  const RecordView *record : Frame payload and message type, not WIRE_BATCH.
+    *  ParsedRecord *out : Receives the result.
+ * RETURNS : n/a
+ */
+static void parseFrame(const RecordView *record, ParsedRecord *out) {
+    Trip     trip;
+    uint64_t resume = 0;
+    uint32_t flags  = 0;
+
+    switch (record->type) {
+        case WIRE_PARTY:
+            out->kind = PARSED_PARTY;
+            snprintf(out->line, sizeof(out->line), "party");
+            break;
+        case WIRE_STOP:
+            out->kind = PARSED_STOP;
+            snprintf(out->line, sizeof(out->line), "stop");
+            break;
+        case WIRE_END:
+            out->kind = PARSED_END;
+            snprintf(out->line, sizeof(out->line), "END_PARTY");
+            break;
+        case WIRE_DEST:
+            if (!wireDecodeDestination(record->data, record->length, &trip)) {
+                parseReject(out, "Discarded malformed destination frame");
+                return;
+            }
+            out->kind              = PARSED_DESTINATION;
+            out->destinationLength = strlen(trip.destination);
+            snprintf(out->line, sizeof(out->line), "%s", trip.destination);
+            break;
+        case WIRE_CLIENT:
+            if (!wireDecodeClient(record->data, record->length, &out->client)) {
+                parseReject(out, "Discarded malformed client frame");
+                return;
+            }
+            out->kind = PARSED_CLIENT;
+            snprintf(out->line, sizeof(out->line), "%s,%s,%d,%s", out->client.firstName,
+                     out->client.lastName, out->client.age, out->client.address);
+            break;
+        case WIRE_HELLO:
+            // The reader consumes every well-formed HELLO outside a batch
+            parseReject(out, wireDecodeHello(record->data, record->length, &out->pid, &resume, &flags)
+                                 ? "Discarded hello frame inside a batch"
+                                 : "Discarded malformed hello frame");
+            return;
+        case WIRE_QUERY:
+            if (!wireDecodeQuery(record->data, record->length, &out->pid)) {
+                parseReject(out, "Discarded malformed query frame");
+                return;
+            }
+            out->kind = PARSED_QUERY;
+            snprintf(out->line, sizeof(out->line), "query %ld", out->pid);
+            break;
+        case WIRE_METRICS:
+            if (!wireDecodeQuery(record->data, record->length, &out->pid)) {
+                parseReject(out, "Discarded malformed metrics frame");
+                return;
+            }
+            out->kind = PARSED_METRICS;
+            snprintf(out->line, sizeof(out->line), "metrics %ld", out->pid);
+            break;
+        default:
+            snprintf(out->line, sizeof(out->line), "Discarded unknown frame type %d", record->type);
+            out->rejected = true;
+            return;
+    }
+    out->echo = true;
+}
+
+/*
+ * FUNCTION: parseBatchChunk
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Appends one WIRE_BATCH chunk to the batch it belongs to. Chunks from
+    *  different clients may interleave on the FIFO but each chunk is written
+    *  atomically, so a batch is rebuilt by joining its chunks in sequence
+    *  order. Once the last chunk is in, the batch's frames are replayed.
+ * PARAMETERS:
+    *  Parser *parser : Parser holding the chunk.
+    *  ParsedRecord *out : Receives the result of a chunk that completes no batch.
+ * RETURNS : bool - true if the chunk completed its batch and the replay has started.
+ */
+static bool parseBatchChunk(Parser *parser, ParsedRecord *out) {
+    const RecordView *record = &parser->record;
+    WireBatchHeader   header;
+    if (record->length < sizeof(header)) {
+        parseReject(out, "Discarded malformed batch frame");
+        return false;
+    }
+    memcpy(&header, record->data, sizeof(header));
+    const char *fragment       = record->data + sizeof(header);
+    size_t      fragmentLength = record->length - sizeof(header);
+    if (!parser->batches && !(parser->batches = calloc(MAX_PENDING_BATCHES, sizeof(PendingBatch)))) {
+        perror("Memory allocation failed");
+        parseReject(out, "Discarded batch - out of memory");
+        return false;
+    }
+
+    // Find the batch this chunk belongs to, or a free slot for a new one
+    PendingBatch *batch    = NULL;
+    PendingBatch *freeSlot = NULL;
+    for (int i = 0; i < MAX_PENDING_BATCHES && !batch; i++) {
+        if (parser->batches[i].inUse && parser->batches[i].batchId == header.batchId) {
+            batch = &parser->batches[i];
+        } else if (!parser->batches[i].inUse && !freeSlot) {
+            freeSlot = &parser->batches[i];
+        }
+    }
+    if (!batch) {
+        if (!freeSlot) {
+            parseReject(out, "Discarded batch - too many batches in progress");
+            return false;
+        }
+        batch          = freeSlot;
+        batch->inUse   = true;
+        batch->batchId = header.batchId;
+    }
+    if (header.sequence == 0) {   // A new party restarts the batch
+        batch->length       = 0;
+        batch->nextSequence = 0;
+    }
+
+    if (header.sequence != batch->nextSequence
+        || batch->length + fragmentLength > WIRE_MAX_BATCH_SIZE) {
+        parseReject(out, "Discarded batch - missing chunk or batch too large");
+        batch->inUse = false;
+        out->batch   = PARSED_BATCH_DONE;
+        return false;
+    }
+
+    // Grow the reassembly buffer geometrically
+    if (batch->length + fragmentLength > batch->capacity) {
+        size_t capacity = batch->capacity ? batch->capacity : WIRE_MAX_FRAME_SIZE;
+        while (capacity < batch->length + fragmentLength) {
+            capacity *= BUFFER_SIZE_OF_TWO;
+        }
+        char *data = realloc(batch->data, capacity);
+        if (!data) {
+            perror("Memory allocation failed");
+            batch->inUse  = false;
+            out->batch    = PARSED_BATCH_DONE;
+            out->rejected = true;
+            return false;
+        }
+        batch->data     = data;
+        batch->capacity = capacity;
+    }
+    memcpy(batch->data + batch->length, fragment, fragmentLength);
+    batch->length += fragmentLength;
+    batch->nextSequence++;
+
+    // The chunks are only acknowledged together, once the party is replayed
+    if (!(header.flags & WIRE_BATCH_LAST)) {
+        out->batch = PARSED_BATCH_OPEN;
+        return false;
+    }
+    parser->replaying = batch;
+    parser->cursor    = batch->data;
+    return true;
+}
+
+/*
+ * FUNCTION: parseReplay
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Hands out the next frame of a completed batch, exactly as if it had
+    *  arrived alone. Nested batches are skipped and a malformed frame ends
+    *  the replay. After the last frame comes the counted result of the
+    *  chunk that completed the batch.
+ * PARAMETERS:
+    *  Parser *parser : Parser replaying a batch.
+    *  ParsedRecord *out : Receives the result.
+ * RETURNS : bool - always true.
+ */
+static bool parseReplay(Parser *parser, ParsedRecord *out) {
+    PendingBatch *batch = parser->replaying;
+    const char   *end   = batch->data + batch->length;
+    WireHeader    header;
+    RecordView    frame;
+
+    while (parser->cursor < end) {
+        if (!wireNextFrame(&parser->cursor, end, &header, &frame.data)) {
+            parser->cursor = end;
+            parseReject(out, "Discarded malformed frame in batch");
+            return true;
+        }
+        frame.length = header.length;
+        frame.type   = header.type;
+        if (frame.type != WIRE_BATCH) {
+            parseFrame(&frame, out);
+            return true;
+        }
+    }
+
+    batch->inUse      = false;
+    batch->length     = 0;
+    parser->replaying = NULL;
+    out->counted      = true;
+    out->batch        = PARSED_BATCH_DONE;
+    return true;
+}
+
+/*
+ * FUNCTION: parseReject
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Marks a result as a rejected record, logged with the reason but not echoed.
+ * PARAMETERS:
+    *  ParsedRecord *out : Result to mark.
+    *  const char *reason : Log line.
+ * RETURNS : n/a
+ */
+static void parseReject(ParsedRecord *out, const char *reason) {
+    snprintf(out->line, sizeof(out->line), "%s", reason);
+    out->rejected = true;
+}
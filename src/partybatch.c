@@ -0,0 +1,375 @@
+/*
+ * FILE: partybatch.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Columnar party storage and destination interning for the server. Column
+ * arrays and string pools are kept between parties, so once they have
+ * grown to fit the largest party, adding a client is a few stores and
+ * memcpys and partyBatchReset() is O(1).
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "partybatch.h"
+
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME        16777619u
+
+static int      poolAppend(StringPool *pool, const char *string, size_t length, PoolString *stored);
+static uint32_t hashDestination(const char *name, size_t length);
+static int      growDestinationSlots(DestinationTable *table);
+static int      growColumns(PartyBatch *batch);
+
+// #####################################################################################################################
+// Destination Table
+// #####################################################################################################################
+
+/*
+ * FUNCTION: destinationIntern
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Returns the id of a destination, adding it to the table the first time
+    *  it is seen. Equal names always get the same id.
+ * PARAMETERS:
+    *  DestinationTable *table : Table to search and add to.
+    *  const char *name : Destination bytes (need not be null-terminated).
+    *  size_t length : Number of bytes in name.
+ * RETURNS : uint32_t - the destination id, or PARTY_NO_DESTINATION if memory ran out.
+ */
+uint32_t destinationIntern(DestinationTable *table, const char *name, size_t length) {
+    // Keep the load factor at or below one half
+    if ((table->count + 1) * 2 > table->slotCount && growDestinationSlots(table) == ERROR) {
+        return PARTY_NO_DESTINATION;
+    }
+
+    uint32_t hash = hashDestination(name, length);
+    uint32_t mask = table->slotCount - 1;
+    uint32_t slot = hash & mask;
+    while (table->slots[slot] != 0) {
+        uint32_t id = table->slots[slot] - 1;
+        if (table->hashes[id] == hash && table->names[id].length == length
+            && memcmp(table->pool.data + table->names[id].offset, name, length) == SUCCESS) {
+            return id;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (table->count == table->capacity) {
+        uint32_t    capacity = table->capacity ? table->capacity * 2 : DESTINATION_TABLE_SLOTS / 2;
+        PoolString *names    = realloc(table->names, sizeof(*names) * capacity);
+        if (!names) {
+            return PARTY_NO_DESTINATION;
+        }
+        table->names = names;
+        uint32_t *hashes = realloc(table->hashes, sizeof(*hashes) * capacity);
+        if (!hashes) {
+            return PARTY_NO_DESTINATION;
+        }
+        table->hashes   = hashes;
+        table->capacity = capacity;
+    }
+
+    uint32_t id = table->count;
+    if (poolAppend(&table->pool, name, length, &table->names[id]) == ERROR) {
+        return PARTY_NO_DESTINATION;
+    }
+    table->hashes[id]  = hash;
+    table->slots[slot] = id + 1;
+    table->count++;
+    return id;
+}
+
+/*
+ * FUNCTION: destinationName
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Looks up the name of an interned destination.
+ * PARAMETERS:
+    *  const DestinationTable *table : Table the id came from.
+    *  uint32_t id : Destination id.
+ * RETURNS : const char * - null-terminated name, or "" for an unknown id.
+ */
+const char *destinationName(const DestinationTable *table, uint32_t id) {
+    if (id >= table->count) {
+        return "";
+    }
+    return table->pool.data + table->names[id].offset;
+}
+
+/*
+ * FUNCTION: destinationTableFree
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Frees a destination table and leaves it empty. Previous ids become invalid.
+ * PARAMETERS:
+    *  DestinationTable *table : Table to free.
+ * RETURNS : n/a
+ */
+void destinationTableFree(DestinationTable *table) {
+    free(table->slots);
+    free(table->names);
+    free(table->hashes);
+    free(table->pool.data);
+    memset(table, 0, sizeof(*table));
+}
+
+// #####################################################################################################################
+// Party Batch
+// #####################################################################################################################
+
+/*
+ * FUNCTION: partyBatchAdd
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Appends a client to the party, copying its strings into the pool.
+ * PARAMETERS:
+    *  PartyBatch *batch : Party to add to.
+    *  const Client *client : Decoded client; its strings must be null-terminated.
+ * RETURNS : int - SUCCESS, or ERROR if memory ran out (the party is unchanged).
+ */
+int partyBatchAdd(PartyBatch *batch, const Client *client) {
+    if (batch->count == batch->capacity && growColumns(batch) == ERROR) {
+        return ERROR;
+    }
+
+    int    row      = batch->count;
+    size_t poolUsed = batch->strings.used;
+    if (poolAppend(&batch->strings, client->firstName, strnlen(client->firstName, MAX_NAME_LEN),
+                   &batch->firstNames[row]) == ERROR
+        || poolAppend(&batch->strings, client->lastName, strnlen(client->lastName, MAX_NAME_LEN),
+                      &batch->lastNames[row]) == ERROR
+        || poolAppend(&batch->strings, client->address, strnlen(client->address, MAX_ADDRESS_LEN),
+                      &batch->addresses[row]) == ERROR) {
+        batch->strings.used = poolUsed;
+        return ERROR;
+    }
+    batch->ages[row] = client->age;
+    batch->count++;
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: partyBatchString
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Returns a name or address of the party as a C string.
+ * PARAMETERS:
+    *  const PartyBatch *batch : Party the string belongs to.
+    *  PoolString string : Entry of firstNames, lastNames or addresses.
+ * RETURNS : const char * - null-terminated string, valid until the party is reset.
+ */
+const char *partyBatchString(const PartyBatch *batch, PoolString string) {
+    return batch->strings.data + string.offset;
+}
+
+/*
+ * FUNCTION: partyBatchClient
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Copies one row of the party back into a Client record.
+ * PARAMETERS:
+    *  const PartyBatch *batch : Party to read.
+    *  int row : Client index, 0..count - 1.
+    *  Client *client : Receives the client.
+ * RETURNS : n/a
+ */
+void partyBatchClient(const PartyBatch *batch, int row, Client *client) {
+    const PoolString fields[]  = { batch->firstNames[row], batch->lastNames[row], batch->addresses[row] };
+    char *const      targets[] = { client->firstName, client->lastName, client->address };
+    const size_t     sizes[]   = { MAX_NAME_LEN, MAX_NAME_LEN, MAX_ADDRESS_LEN };
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        size_t length = fields[i].length < sizes[i] ? fields[i].length : sizes[i] - 1;
+        memcpy(targets[i], batch->strings.data + fields[i].offset, length);
+        targets[i][length] = '\0';
+    }
+    client->age = batch->ages[row];
+}
+
+/*
+ * FUNCTION: partyBatchAgeStats
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Computes the youngest, oldest and mean age of the party in one pass
+    *  over the ages column. The loop has no early exits or data dependent
+    *  branches so the compiler can vectorize it.
+ * PARAMETERS:
+    *  const PartyBatch *batch : Party to summarize.
+ * RETURNS : AgeStats - all zero for an empty party.
+ */
+AgeStats partyBatchAgeStats(const PartyBatch *batch) {
+    AgeStats stats = {0};
+    if (batch->count == 0) {
+        return stats;
+    }
+
+    const int *restrict ages = batch->ages;
+    int       min = ages[0];
+    int       max = ages[0];
+    long long sum = 0;
+    for (int i = 0; i < batch->count; i++) {
+        min  = ages[i] < min ? ages[i] : min;
+        max  = ages[i] > max ? ages[i] : max;
+        sum += ages[i];
+    }
+
+    stats.min  = min;
+    stats.max  = max;
+    stats.mean = (double)sum / batch->count;
+    return stats;
+}
+
+/*
+ * FUNCTION: partyBatchReset
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Empties the party for reuse, keeping its columns and pool.
+ * PARAMETERS:
+    *  PartyBatch *batch : Party to reset.
+ * RETURNS : n/a
+ */
+void partyBatchReset(PartyBatch *batch) {
+    batch->destinationId = PARTY_NO_DESTINATION;
+    batch->count         = 0;
+    batch->strings.used  = 0;
+}
+
+/*
+ * FUNCTION: partyBatchFree
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Frees the columns and pool of a party and leaves it empty.
+ * PARAMETERS:
+    *  PartyBatch *batch : Party to free.
+ * RETURNS : n/a
+ */
+void partyBatchFree(PartyBatch *batch) {
+    free(batch->ages);
+    free(batch->firstNames);
+    free(batch->lastNames);
+    free(batch->addresses);
+    free(batch->strings.data);
+    memset(batch, 0, sizeof(*batch));
+    batch->destinationId = PARTY_NO_DESTINATION;
+}
+
+// #####################################################################################################################
+// Helpers
+// #####################################################################################################################
+
+/*
+ * FUNCTION: poolAppend
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Copies a string and a terminating '\0' to the end of a pool, doubling it if needed.
+ * PARAMETERS:
+    *  StringPool *pool : Pool to append to.
+    *  const char *string : Bytes to copy.
+    *  size_t length : Number of bytes.
+    *  PoolString *stored : Receives where the string was stored.
+ * RETURNS : int - SUCCESS, or ERROR if memory ran out or the pool would pass 4 GiB.
+ */
+static int poolAppend(StringPool *pool, const char *string, size_t length, PoolString *stored) {
+    size_t needed = pool->used + length + 1;
+    if (needed > UINT32_MAX) {
+        return ERROR;   // Offsets are 32-bit
+    }
+    if (needed > pool->capacity) {
+        size_t capacity = pool->capacity ? pool->capacity : STRING_POOL_INITIAL_SIZE;
+        while (capacity < needed) {
+            capacity *= 2;
+        }
+        char *data = realloc(pool->data, capacity);
+        if (!data) {
+            return ERROR;
+        }
+        pool->data     = data;
+        pool->capacity = capacity;
+    }
+
+    memcpy(pool->data + pool->used, string, length);
+    pool->data[pool->used + length] = '\0';
+    stored->offset = (uint32_t)pool->used;
+    stored->length = (uint32_t)length;
+    pool->used     = needed;
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: hashDestination
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: 32-bit FNV-1a hash of a destination name.
+ * PARAMETERS:
+    *  const char *name : Bytes to hash.
+    *  size_t length : Number of bytes.
+ * RETURNS : uint32_t - the hash.
+ */
+static uint32_t hashDestination(const char *name, size_t length) {
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/*
+ * FUNCTION: growDestinationSlots
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Doubles the hash slots and reinserts every id using its stored hash.
+ * PARAMETERS:
+    *  DestinationTable *table : Table to grow.
+ * RETURNS : int - SUCCESS, or ERROR if memory ran out (the table is unchanged).
+ */
+static int growDestinationSlots(DestinationTable *table) {
+    uint32_t slotCount = table->slotCount ? table->slotCount * 2 : DESTINATION_TABLE_SLOTS;
+    if (slotCount == 0) {
+        return ERROR;
+    }
+    uint32_t *slots = calloc(slotCount, sizeof(*slots));
+    if (!slots) {
+        return ERROR;
+    }
+
+    uint32_t mask = slotCount - 1;
+    for (uint32_t id = 0; id < table->count; id++) {
+        uint32_t slot = table->hashes[id] & mask;
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = id + 1;
+    }
+
+    free(table->slots);
+    table->slots     = slots;
+    table->slotCount = slotCount;
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: growColumns
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Doubles the capacity of every column of a party.
+ * PARAMETERS:
+    *  PartyBatch *batch : Party to grow.
+ * RETURNS : int - SUCCESS, or ERROR if memory ran out (columns that grew are kept).
+ */
+static int growColumns(PartyBatch *batch) {
+    if (batch->capacity > INT32_MAX / 2) {
+        return ERROR;
+    }
+    int    capacity = batch->capacity ? batch->capacity * 2 : PARTY_INITIAL_CLIENTS;
+    size_t rows     = (size_t)capacity;
+
+    int *ages = realloc(batch->ages, sizeof(*ages) * rows);
+    if (!ages) {
+        return ERROR;
+    }
+    batch->ages = ages;
+
+    PoolString **columns[] = { &batch->firstNames, &batch->lastNames, &batch->addresses };
+    for (size_t i = 0; i < sizeof(columns) / sizeof(columns[0]); i++) {
+        PoolString *column = realloc(*columns[i], sizeof(PoolString) * rows);
+        if (!column) {
+            return ERROR;
+        }
+        *columns[i] = column;
+    }
+
+    batch->capacity = capacity;
+    return SUCCESS;
+}
@@ -0,0 +1,124 @@
+/*
+ * FILE: pattern.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Registry of precompiled input patterns. patternCompile() returns the same
+ * handle for the same pattern text, so regcomp runs once per pattern for
+ * the life of the program instead of once per validated input.
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pattern.h"
+#include "shared.h"
+
+// Patterns compiled so far (the client is single threaded)
+static Pattern patterns[MAX_PATTERNS];
+static size_t  patternCount = 0;
+
+static bool patternIsLiteral(const char *source, char *literal, size_t *literalLength);
+
+/*
+ * FUNCTION: patternCompile
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Returns the registry handle for a pattern, compiling it with
+    *  REG_EXTENDED the first time it is seen. Anchored patterns without
+    *  metacharacters are stored as literals and not compiled at all.
+ * PARAMETERS:
+    *  const char *source : Extended regular expression.
+ * RETURNS : const Pattern * - the handle, or NULL if the pattern does not
+ *           compile, is too long, or the registry is full.
+ */
+const Pattern *patternCompile(const char *source) {
+    if (!source || strlen(source) >= MAX_PATTERN_LEN) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < patternCount; i++) {
+        if (strcmp(patterns[i].source, source) == SUCCESS) {
+            return &patterns[i];
+        }
+    }
+    if (patternCount == MAX_PATTERNS) {
+        return NULL;
+    }
+
+    Pattern *pattern = &patterns[patternCount];
+    memset(pattern, 0, sizeof(*pattern));
+    snprintf(pattern->source, sizeof(pattern->source), "%s", source);
+
+    pattern->isLiteral = patternIsLiteral(source, pattern->literal, &pattern->literalLength);
+    if (!pattern->isLiteral && regcomp(&pattern->regex, source, REG_EXTENDED | REG_NOSUB) != SUCCESS) {
+        return NULL;   // Regex could not be compiled.
+    }
+
+    patternCount++;
+    return pattern;
+}
+
+/*
+ * FUNCTION: patternMatches
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Matches a null-terminated string of known length against a compiled pattern.
+ * PARAMETERS:
+    *  const Pattern *pattern : Handle from patternCompile().
+    *  const char *string : Null-terminated string to test.
+    *  size_t length : strlen(string).
+ * RETURNS : bool - true if the string matches.
+ */
+bool patternMatches(const Pattern *pattern, const char *string, size_t length) {
+    if (pattern->isLiteral) {
+        return length == pattern->literalLength
+               && memcmp(string, pattern->literal, length) == SUCCESS;
+    }
+    return regexec(&pattern->regex, string, 0, NULL, 0) == SUCCESS;
+}
+
+/*
+ * FUNCTION: patternRegistryFree
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Frees every compiled pattern. Handles must not be used afterwards.
+ * PARAMETERS: n/a
+ * RETURNS : n/a
+ */
+void patternRegistryFree(void) {
+    for (size_t i = 0; i < patternCount; i++) {
+        if (!patterns[i].isLiteral) {
+            regfree(&patterns[i].regex);
+        }
+    }
+    patternCount = 0;
+}
+
+/*
+ * FUNCTION: patternIsLiteral
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Detects patterns of the form "^text$" where text has no extended regex
+    *  metacharacters, so the pattern matches exactly one string.
+ * PARAMETERS:
+    *  const char *source : Pattern text.
+    *  char *literal : Receives text (MAX_PATTERN_LEN bytes).
+    *  size_t *literalLength : Receives strlen(text).
+ * RETURNS : bool - true if the pattern is a literal.
+ */
+static bool patternIsLiteral(const char *source, char *literal, size_t *literalLength) {
+    size_t length = strlen(source);
+    if (length < BUFFER_SIZE_OF_TWO || source[0] != '^' || source[length - 1] != '$') {
+        return false;
+    }
+
+    size_t textLength = length - BUFFER_SIZE_OF_TWO;
+    if (textLength == 0 || strcspn(source + 1, ".[]()*+?{}|^$\\") < textLength) {
+        return false;
+    }
+
+    memcpy(literal, source + 1, textLength);
+    literal[textLength] = '\0';
+    *literalLength      = textLength;
+    return true;
+}
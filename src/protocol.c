@@ -0,0 +1,640 @@
+/*
+ * FILE: protocol.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * protocol.c serializes Client and Trip data into binary wire frames and
+ * parses binary payloads and text records back into those structs. It is
+ * linked into both the client and the server.
+*/
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "protocol.h"
+#include "shared.h"
+
+static size_t wireWriteHeader(char *out, WireMessageType type, size_t payloadLength);
+static size_t wireEncodePid(char *out, size_t outSize, WireMessageType type, long pid);
+static bool   wireDecodePid(const char *payload, size_t length, long *pid);
+static bool   wireReadField(const char **cursor, const char *end, size_t fieldLength,
+                            char *destination, size_t destinationSize);
+
+/*
+ * FUNCTION: wireWriteHeader
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Writes a WireHeader at the start of out. out must hold WIRE_HEADER_SIZE bytes.
+ * PARAMETERS:
+    *  char *out : Frame buffer.
+    *  WireMessageType type : Message type of the frame.
+    *  size_t payloadLength : Payload bytes that follow the header.
+ * RETURNS : size_t - WIRE_HEADER_SIZE.
+ */
+static size_t wireWriteHeader(char *out, WireMessageType type, size_t payloadLength) {
+    WireHeader header = {
+        .magic    = WIRE_MAGIC,
+        .version  = WIRE_VERSION,
+        .type     = (uint8_t)type,
+        .reserved = 0,
+        .length   = (uint32_t)payloadLength,
+    };
+    memcpy(out, &header, WIRE_HEADER_SIZE);
+    return WIRE_HEADER_SIZE;
+}
+
+/*
+ * FUNCTION: wireEncodeControl
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Encodes a frame without payload (WIRE_PARTY, WIRE_END or WIRE_STOP).
+ * PARAMETERS:
+    *  char *out : Buffer to write the frame into.
+    *  size_t outSize : Size of out in bytes.
+    *  WireMessageType type : Message type to encode.
+ * RETURNS : size_t - frame size, or 0 if out is too small.
+ */
+size_t wireEncodeControl(char *out, size_t outSize, WireMessageType type) {
+    if (!out || outSize < WIRE_HEADER_SIZE) {
+        return 0;
+    }
+    return wireWriteHeader(out, type, 0);
+}
+
+/*
+ * FUNCTION: wireEncodeDestination
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Encodes the destination of a Trip as a WIRE_DEST frame.
+ * PARAMETERS:
+    *  char *out : Buffer to write the frame into.
+    *  size_t outSize : Size of out in bytes.
+    *  const Trip *trip : Trip holding the destination.
+ * RETURNS : size_t - frame size, or 0 if out is too small.
+ */
+size_t wireEncodeDestination(char *out, size_t outSize, const Trip *trip) {
+    if (!out || !trip) {
+        return 0;
+    }
+
+    size_t   destinationLength = strnlen(trip->destination, MAX_DESTINATION_LEN - 1);
+    uint16_t fieldLength       = (uint16_t)destinationLength;
+    size_t   payloadLength     = sizeof(fieldLength) + destinationLength;
+    if (outSize < WIRE_HEADER_SIZE + payloadLength) {
+        return 0;
+    }
+
+    char *cursor = out + wireWriteHeader(out, WIRE_DEST, payloadLength);
+    memcpy(cursor, &fieldLength, sizeof(fieldLength));
+    memcpy(cursor + sizeof(fieldLength), trip->destination, destinationLength);
+    return WIRE_HEADER_SIZE + payloadLength;
+}
+
+/*
+ * FUNCTION: wireEncodeClient
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Encodes a Client as a WIRE_CLIENT frame. Names and address are written
+    *  as length-prefixed fields and the age as a native integer, so no
+    *  formatting or allocation is needed.
+ * PARAMETERS:
+    *  char *out : Buffer to write the frame into.
+    *  size_t outSize : Size of out in bytes.
+    *  const Client *client : Client to encode.
+ * RETURNS : size_t - frame size, or 0 if out is too small.
+ */
+size_t wireEncodeClient(char *out, size_t outSize, const Client *client) {
+    if (!out || !client) {
+        return 0;
+    }
+
+    uint8_t  firstNameLength = (uint8_t)strnlen(client->firstName, MAX_NAME_LEN - 1);
+    uint8_t  lastNameLength  = (uint8_t)strnlen(client->lastName, MAX_NAME_LEN - 1);
+    uint16_t addressLength   = (uint16_t)strnlen(client->address, MAX_ADDRESS_LEN - 1);
+    int32_t  age             = (int32_t)client->age;
+    size_t   payloadLength   = sizeof(firstNameLength) + firstNameLength
+                             + sizeof(lastNameLength) + lastNameLength + sizeof(age)
+                             + sizeof(addressLength) + addressLength;
+    if (outSize < WIRE_HEADER_SIZE + payloadLength) {
+        return 0;
+    }
+
+    char *cursor = out + wireWriteHeader(out, WIRE_CLIENT, payloadLength);
+    *cursor++ = (char)firstNameLength;
+    memcpy(cursor, client->firstName, firstNameLength);
+    cursor += firstNameLength;
+    *cursor++ = (char)lastNameLength;
+    memcpy(cursor, client->lastName, lastNameLength);
+    cursor += lastNameLength;
+    memcpy(cursor, &age, sizeof(age));
+    cursor += sizeof(age);
+    memcpy(cursor, &addressLength, sizeof(addressLength));
+    cursor += sizeof(addressLength);
+    memcpy(cursor, client->address, addressLength);
+    return WIRE_HEADER_SIZE + payloadLength;
+}
+
+/*
+ * FUNCTION: wireTripSizeBound
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Returns a buffer size large enough for wireEncodeTrip() on this trip.
+ * PARAMETERS:
+    *  const Trip *trip : Trip that will be encoded.
+ * RETURNS : size_t - upper bound of the encoded size in bytes.
+ */
+size_t wireTripSizeBound(const Trip *trip) {
+    size_t clientCount = (trip && trip->numberOfClients > 0) ? (size_t)trip->numberOfClients : 0;
+    return BUFFER_SIZE_OF_THREE * WIRE_HEADER_SIZE + sizeof(uint16_t) + MAX_DESTINATION_LEN
+         + clientCount * WIRE_MAX_CLIENT_FRAME;
+}
+
+/*
+ * FUNCTION: wireEncodeTrip
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Encodes a whole party as consecutive PARTY, DEST, one CLIENT per entry
+    *  in trip->clients and END frames. This is the content that is split into
+    *  WIRE_BATCH chunks.
+ * PARAMETERS:
+    *  char *out : Buffer to write the frames into.
+    *  size_t outSize : Size of out, see wireTripSizeBound().
+    *  const Trip *trip : Trip to encode.
+ * RETURNS : size_t - total size of the frames, or 0 if out is too small.
+ */
+size_t wireEncodeTrip(char *out, size_t outSize, const Trip *trip) {
+    if (!out || !trip) {
+        return 0;
+    }
+
+    size_t used  = 0;
+    size_t frame = wireEncodeControl(out, outSize, WIRE_PARTY);
+    if (frame == 0) {
+        return 0;
+    }
+    used += frame;
+
+    if ((frame = wireEncodeDestination(out + used, outSize - used, trip)) == 0) {
+        return 0;
+    }
+    used += frame;
+
+    for (int i = 0; i < trip->numberOfClients; i++) {
+        if ((frame = wireEncodeClient(out + used, outSize - used, &trip->clients[i])) == 0) {
+            return 0;
+        }
+        used += frame;
+    }
+
+    if ((frame = wireEncodeControl(out + used, outSize - used, WIRE_END)) == 0) {
+        return 0;
+    }
+    return used + frame;
+}
+
+/*
+ * FUNCTION: wireEncodeHello
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Encodes a WIRE_HELLO frame registering a client session.
+ * PARAMETERS:
+    *  char *out : Buffer to write the frame into.
+    *  size_t outSize : Size of out in bytes.
+    *  long pid : Process id of the client, names its session FIFO.
+    *  uint64_t resume : Records acknowledged on the session being resumed, WIRE_NEW_SESSION if new.
+    *  uint32_t flags : WIRE_HELLO_SHM for a shared memory session, otherwise 0.
+ * RETURNS : size_t - frame size, or 0 if out is too small.
+ */
+size_t wireEncodeHello(char *out, size_t outSize, long pid, uint64_t resume, uint32_t flags) {
+    size_t length = wireEncodePid(out, outSize, WIRE_HELLO, pid);
+    if (length == 0 || (resume == WIRE_NEW_SESSION && flags == 0)) {
+        return length;   // A new FIFO session keeps the short payload
+    }
+    size_t extra = sizeof(resume) + (flags != 0 ? sizeof(flags) : 0);
+    if (outSize < length + extra) {
+        return 0;
+    }
+    wireWriteHeader(out, WIRE_HELLO, length - WIRE_HEADER_SIZE + extra);
+    memcpy(out + length, &resume, sizeof(resume));
+    if (flags != 0) {
+        memcpy(out + length + sizeof(resume), &flags, sizeof(flags));
+    }
+    return length + extra;
+}
+
+/*
+ * FUNCTION: wireEncodeQuery
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Encodes a WIRE_QUERY frame asking for a destination statistics snapshot.
+ * PARAMETERS:
+    *  char *out : Buffer to write the frame into.
+    *  size_t outSize : Size of out in bytes.
+    *  long pid : Process id of the client, names its reply FIFO.
+ * RETURNS : size_t - frame size, or 0 if out is too small.
+ */
+size_t wireEncodeQuery(char *out, size_t outSize, long pid) {
+    return wireEncodePid(out, outSize, WIRE_QUERY, pid);
+}
+
+/*
+ * FUNCTION: wireEncodeMetrics
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Encodes a WIRE_METRICS frame asking for the server's runtime metrics.
+ * PARAMETERS:
+    *  char *out : Buffer to write the frame into.
+    *  size_t outSize : Size of out in bytes.
+    *  long pid : Process id of the client, names its reply FIFO.
+ * RETURNS : size_t - frame size, or 0 if out is too small.
+ */
+size_t wireEncodeMetrics(char *out, size_t outSize, long pid) {
+    return wireEncodePid(out, outSize, WIRE_METRICS, pid);
+}
+
+/*
+ * FUNCTION: wireEncodeAck
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Encodes a WIRE_ACK frame acknowledging the records of a session.
+ * PARAMETERS:
+    *  char *out : Buffer to write the frame into.
+    *  size_t outSize : Size of out in bytes.
+    *  const WireAck *ack : Cumulative counts to send.
+ * RETURNS : size_t - frame size, or 0 if out is too small.
+ */
+size_t wireEncodeAck(char *out, size_t outSize, const WireAck *ack) {
+    if (!out || !ack || outSize < WIRE_HEADER_SIZE + sizeof(*ack)) {
+        return 0;
+    }
+    wireWriteHeader(out, WIRE_ACK, sizeof(*ack));
+    memcpy(out + WIRE_HEADER_SIZE, ack, sizeof(*ack));
+    return WIRE_HEADER_SIZE + sizeof(*ack);
+}
+
+/*
+ * FUNCTION: wireDecodeHello
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Parses a WIRE_HELLO payload, with or without the resume count and flags.
+ * PARAMETERS:
+    *  const char *payload : Payload bytes following the header.
+    *  size_t length : Payload length from the header.
+    *  long *pid : Set to the client pid.
+    *  uint64_t *resume : Set to the resume count, WIRE_NEW_SESSION for a new session.
+    *  uint32_t *flags : Set to the WIRE_HELLO_* flags, 0 if none were sent.
+ * RETURNS : bool - true if the payload was well formed.
+ */
+bool wireDecodeHello(const char *payload, size_t length, long *pid, uint64_t *resume,
+                     uint32_t *flags) {
+    if (!resume || !flags) {
+        return false;
+    }
+    *resume = WIRE_NEW_SESSION;
+    *flags  = 0;
+    if (length == sizeof(uint32_t) + sizeof(*resume) + sizeof(*flags)) {
+        memcpy(flags, payload + sizeof(uint32_t) + sizeof(*resume), sizeof(*flags));
+        length -= sizeof(*flags);
+    }
+    if (length == sizeof(uint32_t) + sizeof(*resume)) {
+        memcpy(resume, payload + sizeof(uint32_t), sizeof(*resume));
+        length = sizeof(uint32_t);
+    }
+    return wireDecodePid(payload, length, pid);
+}
+
+/*
+ * FUNCTION: wireDecodeQuery
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Parses a WIRE_QUERY or WIRE_METRICS payload.
+ * PARAMETERS:
+    *  const char *payload : Payload bytes following the header.
+    *  size_t length : Payload length from the header.
+    *  long *pid : Set to the pid of the client waiting for the reply.
+ * RETURNS : bool - true if the payload was well formed.
+ */
+bool wireDecodeQuery(const char *payload, size_t length, long *pid) {
+    return wireDecodePid(payload, length, pid);
+}
+
+/*
+ * FUNCTION: wireDecodeAck
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Parses a WIRE_ACK payload.
+ * PARAMETERS:
+    *  const char *payload : Payload bytes following the header.
+    *  size_t length : Payload length from the header.
+    *  WireAck *ack : Receives the counts.
+ * RETURNS : bool - true if the payload was well formed.
+ */
+bool wireDecodeAck(const char *payload, size_t length, WireAck *ack) {
+    if (!payload || !ack || length != sizeof(*ack)) {
+        return false;
+    }
+    memcpy(ack, payload, sizeof(*ack));
+    return ack->rejected <= ack->records;
+}
+
+/*
+ * FUNCTION: wireEncodePid
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Encodes a frame whose payload is a client pid (WIRE_HELLO, WIRE_QUERY).
+ * PARAMETERS:
+    *  char *out : Buffer to write the frame into.
+    *  size_t outSize : Size of out in bytes.
+    *  WireMessageType type : Frame type.
+    *  long pid : Process id of the client.
+ * RETURNS : size_t - frame size, or 0 if out is too small.
+ */
+static size_t wireEncodePid(char *out, size_t outSize, WireMessageType type, long pid) {
+    uint32_t sessionPid = (uint32_t)pid;
+    if (!out || outSize < WIRE_HEADER_SIZE + sizeof(sessionPid)) {
+        return 0;
+    }
+    wireWriteHeader(out, type, sizeof(sessionPid));
+    memcpy(out + WIRE_HEADER_SIZE, &sessionPid, sizeof(sessionPid));
+    return WIRE_HEADER_SIZE + sizeof(sessionPid);
+}
+
+/*
+ * FUNCTION: wireDecodePid
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Parses a payload holding a client pid.
+ * PARAMETERS:
+    *  const char *payload : Payload bytes following the header.
+    *  size_t length : Payload length from the header.
+    *  long *pid : Set to the client pid.
+ * RETURNS : bool - true if the payload was well formed.
+ */
+static bool wireDecodePid(const char *payload, size_t length, long *pid) {
+    uint32_t sessionPid;
+    if (!payload || !pid || length != sizeof(sessionPid)) {
+        return false;
+    }
+    memcpy(&sessionPid, payload, sizeof(sessionPid));
+    *pid = (long)sessionPid;
+    return *pid > 0;
+}
+
+/*
+ * FUNCTION: wireNextFrame
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Reads the next frame from a buffer of consecutive frames (such as a
+    *  reassembled batch) and advances the cursor past it.
+ * PARAMETERS:
+    *  const char **cursor : Read position, advanced on success.
+    *  const char *end : One past the last byte of the buffer.
+    *  WireHeader *header : Set to the header of the frame.
+    *  const char **payload : Set to the first payload byte.
+ * RETURNS : bool - true if a complete, valid frame was read.
+ */
+bool wireNextFrame(const char **cursor, const char *end, WireHeader *header,
+                   const char **payload) {
+    if ((size_t)(end - *cursor) < WIRE_HEADER_SIZE) {
+        return false;
+    }
+    memcpy(header, *cursor, WIRE_HEADER_SIZE);
+    if (header->magic != WIRE_MAGIC || header->version != WIRE_VERSION
+        || header->length > (size_t)(end - *cursor) - WIRE_HEADER_SIZE) {
+        return false;
+    }
+
+    *payload = *cursor + WIRE_HEADER_SIZE;
+    *cursor  = *payload + header->length;
+    return true;
+}
+
+/*
+ * FUNCTION: wireReadField
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Copies fieldLength bytes at *cursor into a null-terminated buffer and
+    *  advances the cursor. Fails if the field runs past the payload or does
+    *  not fit the destination.
+ * PARAMETERS:
+    *  const char **cursor : Read position inside the payload.
+    *  const char *end : One past the last payload byte.
+    *  size_t fieldLength : Bytes in the field.
+    *  char *destination : Buffer to copy the field into.
+    *  size_t destinationSize : Size of destination including '\0'.
+ * RETURNS : bool - true if the field was copied.
+ */
+static bool wireReadField(const char **cursor, const char *end, size_t fieldLength,
+                          char *destination, size_t destinationSize) {
+    if (fieldLength >= destinationSize || (size_t)(end - *cursor) < fieldLength) {
+        return false;
+    }
+    memcpy(destination, *cursor, fieldLength);
+    destination[fieldLength] = '\0';
+    *cursor += fieldLength;
+    return true;
+}
+
+/*
+ * FUNCTION: wireDecodeDestination
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Parses a WIRE_DEST payload into trip->destination.
+ * PARAMETERS:
+    *  const char *payload : Payload bytes following the header.
+    *  size_t length : Payload length from the header.
+    *  Trip *trip : Trip to store the destination in.
+ * RETURNS : bool - true if the payload was well formed.
+ */
+bool wireDecodeDestination(const char *payload, size_t length, Trip *trip) {
+    const char *cursor = payload;
+    const char *end    = payload + length;
+    uint16_t    fieldLength;
+
+    if (!payload || !trip || length < sizeof(fieldLength)) {
+        return false;
+    }
+    memcpy(&fieldLength, cursor, sizeof(fieldLength));
+    cursor += sizeof(fieldLength);
+
+    return wireReadField(&cursor, end, fieldLength, trip->destination, MAX_DESTINATION_LEN)
+        && cursor == end;
+}
+
+/*
+ * FUNCTION: wireDecodeClient
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Parses a WIRE_CLIENT payload into a Client struct.
+ * PARAMETERS:
+    *  const char *payload : Payload bytes following the header.
+    *  size_t length : Payload length from the header.
+    *  Client *client : Client to fill in.
+ * RETURNS : bool - true if the payload was well formed.
+ */
+bool wireDecodeClient(const char *payload, size_t length, Client *client) {
+    const char *cursor = payload;
+    const char *end    = payload + length;
+    int32_t     age;
+    uint16_t    addressLength;
+
+    if (!payload || !client || length < BUFFER_SIZE_OF_ONE) {
+        return false;
+    }
+
+    size_t fieldLength = (uint8_t)*cursor++;
+    if (!wireReadField(&cursor, end, fieldLength, client->firstName, MAX_NAME_LEN)
+        || cursor >= end) {
+        return false;
+    }
+
+    fieldLength = (uint8_t)*cursor++;
+    if (!wireReadField(&cursor, end, fieldLength, client->lastName, MAX_NAME_LEN)
+        || (size_t)(end - cursor) < sizeof(age) + sizeof(addressLength)) {
+        return false;
+    }
+
+    memcpy(&age, cursor, sizeof(age));
+    cursor += sizeof(age);
+    client->age = (int)age;
+
+    memcpy(&addressLength, cursor, sizeof(addressLength));
+    cursor += sizeof(addressLength);
+    return wireReadField(&cursor, end, addressLength, client->address, MAX_ADDRESS_LEN)
+        && cursor == end;
+}
+
+/*
+ * FUNCTION: textDecodeClient
+ * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca & Tuan Thanh Nguyen
+ * DESCRIPTION:
+    *  Parses a text client record "FirstName,LastName,Age,Address" into a
+    *  Client struct. The address may itself contain commas. Over-long fields
+    *  are truncated to fit the struct.
+ * PARAMETERS:
+    *  const char *record : Null-terminated record without the newline.
+    *  size_t length : Length of the record.
+    *  Client *client : Client to fill in.
+ * RETURNS : bool - true if all four fields were present.
+ */
+bool textDecodeClient(const char *record, size_t length, Client *client) {
+    if (!record || !client) {
+        return false;
+    }
+
+    char  ageStr[MAX_AGE_STR_LEN] = {0};
+    char  temp[MAX_BUFFER_SIZE];
+    char *savePtr     = NULL;   // strtok_r: parser threads decode records concurrently
+    int   fieldsFound = 0;
+    memset(client, 0, sizeof(*client));
+
+    size_t copyLength = length < sizeof(temp) - 1 ? length : sizeof(temp) - 1;
+    memcpy(temp, record, copyLength);
+    temp[copyLength] = '\0';
+
+    char *token = strtok_r(temp, ",", &savePtr);
+    if (token) {
+        strncpy(client->firstName, token, sizeof(client->firstName)-1);
+        fieldsFound++;
+        token = strtok_r(NULL, ",", &savePtr);
+    }
+    if (token) {
+        strncpy(client->lastName, token, sizeof(client->lastName)-1);
+        fieldsFound++;
+        token = strtok_r(NULL, ",", &savePtr);
+    }
+    if (token) {
+        strncpy(ageStr, token, sizeof(ageStr)-1);
+        client->age = atoi(ageStr);
+        fieldsFound++;
+        token = strtok_r(NULL, "", &savePtr);
+    }
+    if (token) {
+        strncpy(client->address, token, sizeof(client->address)-1);
+        fieldsFound++;
+    }
+    return fieldsFound == BUFFER_SIZE_OF_FOUR;
+}
+
+/*
+ * FUNCTION: textDecodeHello
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Parses a text session registration "session <pid> [resume] [shm]".
+ * PARAMETERS:
+    *  const char *record : Null-terminated record without the newline.
+    *  size_t length : Length of the record.
+    *  long *pid : Set to the client pid.
+    *  uint64_t *resume : Set to the resume count, WIRE_NEW_SESSION for a new session.
+    *  uint32_t *flags : Set to WIRE_HELLO_SHM if the record ends in "shm", otherwise 0.
+ * RETURNS : bool - true if the record is a valid registration.
+ */
+bool textDecodeHello(const char *record, size_t length, long *pid, uint64_t *resume,
+                     uint32_t *flags) {
+    static const char prefix[]   = "session ";
+    static const char shmField[] = " shm";
+    if (!record || !pid || !resume || !flags || length <= sizeof(prefix) - 1
+        || memcmp(record, prefix, sizeof(prefix) - 1) != SUCCESS) {
+        return false;
+    }
+
+    char *numEndPtr = NULL;
+    *pid    = strtol(record + sizeof(prefix) - 1, &numEndPtr, 10);
+    *resume = WIRE_NEW_SESSION;
+    *flags  = 0;
+    if (*numEndPtr == ' ' && isdigit((unsigned char)numEndPtr[1])) {
+        const char *resumeStart = numEndPtr + 1;
+        *resume = strtoull(resumeStart, &numEndPtr, 10);
+        if (*resume == WIRE_NEW_SESSION) {
+            return false;
+        }
+    }
+    if (strcmp(numEndPtr, shmField) == SUCCESS) {
+        *flags     = WIRE_HELLO_SHM;
+        numEndPtr += sizeof(shmField) - 1;
+    }
+    return *numEndPtr == '\0' && *pid > 0;
+}
+
+/*
+ * FUNCTION: sessionFifoPath
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Builds the path of the private FIFO of a client session.
+ * PARAMETERS:
+    *  char *out : Buffer for the path.
+    *  size_t outSize : Size of out, MAX_FIFO_PATH_LEN is enough.
+    *  long pid : Process id of the client.
+ * RETURNS : int - SUCCESS, or ERROR if the path did not fit.
+ */
+int sessionFifoPath(char *out, size_t outSize, long pid) {
+    int length = snprintf(out, outSize, SESSION_FIFO_FORMAT, pid);
+    return (length < 0 || (size_t)length >= outSize) ? ERROR : SUCCESS;
+}
+
+/*
+ * FUNCTION: replyFifoPath
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Builds the path of the FIFO a client reads server replies from.
+ * PARAMETERS:
+    *  char *out : Buffer for the path.
+    *  size_t outSize : Size of out.
+    *  long pid : Client pid.
+ * RETURNS : int - SUCCESS, or ERROR if the path does not fit.
+ */
+int replyFifoPath(char *out, size_t outSize, long pid) {
+    int length = snprintf(out, outSize, REPLY_FIFO_FORMAT, pid);
+    return (length < 0 || (size_t)length >= outSize) ? ERROR : SUCCESS;
+}
+
+/*
+ * FUNCTION: wireTypeName
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Returns a printable name for a message type.
+ * PARAMETERS:
+    *  int type : WireMessageType value.
+ * RETURNS : const char * - static name string.
+ */
+const char *wireTypeName(int type) {
+    switch (type) {
+        case WIRE_TEXT:   return "TEXT";
+        case WIRE_PARTY:  return "PARTY";
+        case WIRE_DEST:   return "DEST";
+        case WIRE_CLIENT: return "CLIENT";
+        case WIRE_END:    return "END";
+        case WIRE_STOP:   return "STOP";
+        case WIRE_BATCH:  return "BATCH";
+        case WIRE_HELLO:  return "HELLO";
+        case WIRE_QUERY:  return "QUERY";
+        case WIRE_ACK:    return "ACK";
+        case WIRE_METRICS: return "METRICS";
+        default:          return "UNKNOWN";
+    }
+}
@@ -1,246 +1,2869 @@
-/*
- * FILE: server.c
- * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca, Tuan Thanh Nguyen, George S.
- * PROJECT: SENG2031 - Assignment 1
- * DESCRIPTION:
- * The server program receives trip and client data from the client via a FIFO,
- * processes the data, and logs the activities.
-*/
-
-#include <fcntl.h>
-#include <stdbool.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <sys/stat.h>
-#include <time.h>
-#include <unistd.h>
-#include <errno.h>
-#include <signal.h>
-
-#include "shared.h"
-
-void processMessages(const char *fifoname);
-void writeToLog(FILE *logFile, const char *message);
-void timeout_handler(int sig);
-void reset_timeout(void);
-
-int main(void) {
-    printf("Travel Agency Server - Waiting for client data...\n");
-    
-    // Set up timeout handler for inactivity
-    signal(SIGALRM, timeout_handler);
-    alarm(TIMEOUT_DURATION); // 2 minutes = 120 seconds
-    
-    // Create FIFO if it doesn't exist
-    if (mkfifo(FIFO_PATH, PERM_OWNER_RW_ALL_R) == -1) {
-        // FIFO might already exist, which is okay
-        if (errno != EEXIST) {
-            perror("Error creating FIFO");
-            return -1;
-        }
-    }
-    
-    // Process messages from clients
-    processMessages(FIFO_PATH);
-    
-    return 0;
-}
-
-/*
- * FUNCTION: processMessages
- * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca & Tuan Thanh Nguyen
- * DESCRIPTION:
-    *  Processes messages from the FIFO, handling party and client data,
-    *  and logging activities to a log file.
- * PARAMETERS:
-    *  const char *fifoname : Path to the FIFO to read messages from.
- * RETURNS : n/a
- */
-void processMessages(const char *fifoname) {
-    FILE *logFile = fopen("travel_agency.log", "a");
-    if (!logFile) {
-        perror("Error opening log file");
-        return;
-    }
-    
-    int fd;
-    char buffer[MAX_BUFFER_SIZE];
-    char destination[MAX_DESTINATION_LEN] = {0};
-    int clientCount = 0;
-    bool inParty = false;
-    bool serverRunning = true;
-    
-    writeToLog(logFile, "Server started");
-    
-    while (serverRunning) {
-        // Open FIFO for reading
-        /*
-        O_RDONLY is a flag that opens the FIFO in read-only mode.
-        If the FIFO does not exist or cannot be opened, open() returns -1 and sets errno.
-        source: https://pubs.opengroup.org/onlinepubs/7908799/xsh/open.html
-        */
-        fd = open(fifoname, O_RDONLY);
-        if (fd == -1) {
-            perror("Error opening FIFO for reading");
-            break;
-        }
-        printf("Client connected.\n");
-        
-        // Read message from FIFO
-        ssize_t bytesRead = read(fd, buffer, sizeof(buffer) - 1);
-        if (bytesRead > 0) {
-            // Reset timeout on activity
-            reset_timeout();
-            
-            buffer[bytesRead] = '\0';
-            
-            // Remove trailing newline if present
-            size_t len = strlen(buffer);
-            if (len > 0 && buffer[len-1] == '\n') {
-                buffer[len-1] = '\0';
-            }
-            
-            printf("Received: %s\n", buffer);
-            writeToLog(logFile, buffer);
-            
-            // Process the message based on content
-            if (strcmp(buffer, "party") == SUCCESS) {
-                inParty = true;
-                clientCount = 0;
-                memset(destination, 0, sizeof(destination));
-                printf("New party started\n");
-            }
-            else if (strcmp(buffer, "stop") == SUCCESS) {
-                printf("Stop command received. Shutting down server.\n");
-                writeToLog(logFile, "Server received stop command");
-                serverRunning = false;
-            }
-            else if (inParty && strlen(destination) == SUCCESS) {
-                // First message after "party" should be destination
-                strncpy(destination, buffer, sizeof(destination) - 1);
-                printf("Party destination: %s\n", destination);
-            }
-            else if (strcmp(buffer, "client") == SUCCESS) {
-                printf("New client being added...\n");
-            }
-            else if (strcmp(buffer, "END_PARTY") == SUCCESS || strcmp(buffer, "end") == SUCCESS) {
-                if (inParty) {
-                    printf("=== PARTY SUMMARY ===\n");
-                    printf("Destination: %s\n", destination);
-                    printf("Number of clients: %d\n", clientCount);
-                    printf("====================\n\n");
-                    
-                    char summary[SUMMARY_SIZE]; // Tuan Thanh Nguyen
-                    snprintf(summary, sizeof(summary), "Party completed - Destination: %s, Clients: %d", 
-                            destination, clientCount);
-                    writeToLog(logFile, summary);
-                }
-                inParty = false;
-            }
-            else if (inParty && strchr(buffer, ',') != NULL) {
-                // This looks like client data (contains commas)
-                clientCount++;
-                // Parse client data: "FirstName,LastName,Age,Address"
-                char firstName[MAX_NAME_LEN] = {0};
-                char lastName[MAX_NAME_LEN] = {0};
-                char ageStr[MAX_AGE_STR_LEN] = {0};
-                char address[MAX_ADDRESS_LEN] = {0};
-                char temp[MAX_BUFFER_SIZE];
-                strncpy(temp, buffer, sizeof(temp)-1);
-                temp[sizeof(temp)-1] = '\0';
-                char *token = strtok(temp, ",");
-                if (token) {
-                    strncpy(firstName, token, sizeof(firstName)-1);
-                    firstName[sizeof(firstName)-1] = '\0';
-                    token = strtok(NULL, ",");
-                }
-                if (token) {
-                    strncpy(lastName, token, sizeof(lastName)-1);
-                    lastName[sizeof(lastName)-1] = '\0';
-                    token = strtok(NULL, ",");
-                }
-                if (token) {
-                    strncpy(ageStr, token, sizeof(ageStr)-1);
-                    ageStr[sizeof(ageStr)-1] = '\0';
-                    token = strtok(NULL, "");
-                }
-                if (token) {
-                    strncpy(address, token, sizeof(address)-1);
-                    address[sizeof(address)-1] = '\0';
-                }
-                printf("\n-----------------------------\n");
-                printf("Client %d\n", clientCount);
-                printf("Name    : %s %s\n", firstName, lastName);
-                printf("Age     : %s\n", ageStr);
-                printf("Address : %s\n", address);
-                printf("-----------------------------\n\n");
-            }
-        }
-        
-        close(fd);
-    }
-    
-    writeToLog(logFile, "Server stopped");
-    fclose(logFile);
-}
-
-/*
-
- * FUNCTION: writeToLog
- * PROGRAMMER: Cy Iver Torrefranca & Tuan Thanh Nguyen
- * DESCRIPTION: Writes a message to the log file with a timestamp.
- * PARAMETERS:
-    *  FILE *logFile : Pointer to the opened log file.
-    *  const char *message : Message to log.
- * RETURNS : n/a
-
- */
-void writeToLog(FILE *logFile, const char *message) {
-    if (logFile) {
-        time_t now;
-        time(&now);
-        char *timeStr = ctime(&now);
-        // Remove newline from time string
-        if (timeStr) {
-            timeStr[strlen(timeStr) - 1] = '\0';
-        }
-        fprintf(logFile, "[%s] %s\n", timeStr ? timeStr : "Unknown time", message);
-        fflush(logFile);
-    }
-}
-
-/*
-
- * FUNCTION: timeout_handler
- * PROGRAMMER: Cy Iver Torrefranca
- * DESCRIPTION: Signal handler for SIGALRM. Terminates the server after timeout.
- * PARAMETERS: 
-    * int sig - Signal number (SIGALRM)
- * RETURNS: n/a (exits program)
- */
-void timeout_handler(int sig) {
-    (void)sig; // Suppress unused parameter warning
-    printf("\nServer timeout: No activity for 2 minutes. Terminating server...\n");
-    
-    // Log the timeout event
-    FILE *logFile = fopen("travel_agency.log", "a");
-    if (logFile) {
-        writeToLog(logFile, "Server terminated due to inactivity timeout (2 minutes)");
-        fclose(logFile);
-    }
-    
-    exit(TIMEOUT_SUCCESSFUL);
-}
-
-/*
- * FUNCTION: reset_timeout
- * PROGRAMMER: Cy Iver Torrefranca
- * DESCRIPTION: Resets the alarm timer to 2 minutes from current time.
- * PARAMETERS: n/a
- * RETURNS: n/a
- */
-void reset_timeout(void) {
-    alarm(CANCEL_TIMEOUT);   // Cancel current alarm
-    alarm(TIMEOUT_DURATION); // Reset to 2 minutes (120 seconds)
-}
+/*
+ * FILE: server.c
+ * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca, Tuan Thanh Nguyen, George S.
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * The server program receives trip and client data from the client via a FIFO,
+ * processes the data, and logs the activities.
+ *
+ * The server is a pipeline. The main thread reads and frames every session
+ * in one epoll loop and queues each record on its session. Parser threads
+ * give the sessions with records waiting turns: a session goes back to the
+ * parser that ran it last, and a parser with nothing to do steals sessions
+ * from the busiest one (see taskdeque.h). Only one parser runs a session at
+ * a time, so its records stay in order while those of different sessions
+ * are parsed in parallel. A single aggregator thread
+ * applies the parsed records to the party state, journals them and sends
+ * the acknowledgements, and the logger's writer thread writes the log. The
+ * stages are joined by bounded lock-free queues (see stagequeue.h).
+*/
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/file.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+
+#include "aggregate.h"
+#include "console.h"
+#include "framer.h"
+#include "journal.h"
+#include "logger.h"
+#include "metrics.h"
+#include "parser.h"
+#include "partybatch.h"
+#include "protocol.h"
+#include "shared.h"
+#include "shmring.h"
+#include "snapshot.h"
+#include "stagequeue.h"
+#include "taskdeque.h"
+#include "transport.h"
+
+// Party state of one session, owned by the aggregator thread; parties[i]
+// belongs to sessions[i]
+typedef struct PartyState {
+    bool       inUse;
+    bool       connection;     // Acknowledged on the session's socket
+    bool       inParty;
+    bool       inBatch;        // A WIRE_BATCH of this session is still being reassembled
+    bool       ackQueued;      // In ackQueue for the end of this aggregator pass
+    int        replyFd;        // Client's reply FIFO, -1 if records are not acknowledged
+    long       pid;            // Session owner, tags the party's journal records
+    PartyBatch batch;          // Destination and clients received so far
+    uint64_t   records;        // Records read from the session
+    uint64_t   complete;       // Records whose changes are all applied (none in an open batch)
+    uint64_t   rejected;       // Records or batched frames discarded
+    uint64_t   acknowledged;   // Records covered by the last WIRE_ACK sent
+    uint64_t   journaled;      // Records covered by the last JOURNAL_PROGRESS record
+} PartyState;
+
+// One client connection with its own stream, owned by the reader (main)
+// thread. Session 0 is the shared FIFO: it receives HELLO registrations and
+// any client that still writes its party straight to the shared FIFO. A
+// socket connection is a session too; its pid stays 0 until the HELLO it
+// starts with names it.
+typedef struct Session {
+    bool       inUse;
+    bool       connection;     // Accepted socket, acknowledged on the same socket
+    bool       ringBacklogged; // In ringBacklog, records are waiting in its ring
+    int        fd;
+    long       pid;            // Client pid, 0 for the shared FIFO
+    ShmRing    ring;           // Client's record ring, fd only carries doorbells (WIRE_HELLO_SHM)
+    LineFramer framer;
+} Session;
+
+#define MAX_SESSIONS     4096   // Mostly idle sessions cost no framer buffer
+#define MAX_EPOLL_EVENTS 64
+#define MAX_LOG_SEGMENT_MB 1024
+#define SERVER_LOCK_PATH   "travel_agency.lock"   // Held while a server owns the directory's state
+
+// Connected sessions and their parties
+static Session    sessions[MAX_SESSIONS];
+static PartyState parties[MAX_SESSIONS];
+
+// epoll instance multiplexing every session, the timer and the signals
+static int epollFd = -1;
+
+// epoll tags for the non-session event sources
+static int timerSource;
+static int signalSource;
+static int pipelineSource;
+
+// Socket the server accepts sessions on (--socket, --tcp); epoll tags it by address
+typedef struct Listener {
+    int              fd;
+    TransportAddress address;
+} Listener;
+
+#define MAX_LISTENERS 2
+
+static Listener listeners[MAX_LISTENERS];
+static int      listenerCount;
+
+// What travels down the pipeline for a session
+typedef enum StageEventKind {
+    STAGE_OPEN,        // The session has its client: take over the reply descriptor, resume the party
+    STAGE_RECORD,      // A record read from the session
+    STAGE_DISCARDED,   // The reader dropped count oversized or corrupt records, or misplaced HELLOs
+    STAGE_QUERY,       // A connection asked for the statistics snapshot
+    STAGE_METRICS,     // A connection asked for the runtime metrics
+    STAGE_CLOSE        // The session is gone
+} StageEventKind;
+
+typedef struct StageHeader {
+    StageEventKind kind;
+    int            slot;         // Index in sessions and parties
+    bool           connection;   // STAGE_OPEN: over a socket
+    bool           ring;         // STAGE_OPEN: over shared memory
+    int            fd;           // STAGE_OPEN: reply descriptor or -1; STAGE_QUERY, STAGE_METRICS: connection
+    long           pid;          // STAGE_OPEN, STAGE_QUERY, STAGE_METRICS
+    uint64_t       resume;       // STAGE_OPEN: records the client saw acknowledged, or WIRE_NEW_SESSION
+    unsigned long  count;        // STAGE_DISCARDED
+    uint64_t       readTime;     // STAGE_RECORD: metricsNow() when the reader read it
+} StageHeader;
+
+// Reader to parser item
+typedef struct StageEvent {
+    StageHeader header;
+    int         type;     // STAGE_RECORD: RecordView type
+    size_t      length;   // STAGE_RECORD: bytes in data
+    char        data[PARSER_MAX_LINE + 1];
+} StageEvent;
+
+// Parser to aggregator item
+typedef struct StageResult {
+    StageHeader  header;
+    ParsedRecord parsed;   // STAGE_RECORD
+} StageResult;
+
+// Aggregator to reader item: a snapshot for the reader to send
+typedef struct StageReply {
+    long   pid;
+    int    fd;       // Connection the query came on, -1 for the client's reply FIFO
+    char  *data;
+    size_t length;
+} StageReply;
+
+// Parsing of one session, the unit of work the parser threads share; tasks[i]
+// belongs to sessions[i]. Only the parser giving it a turn touches parser and mark.
+typedef struct SessionTask {
+    StageQueue  inbox;       // StageEvent * from the reader, in order
+    atomic_bool scheduled;   // Waiting in a deque or having its turn
+    atomic_int  worker;      // Parser that ran it last; the reader queues it there again
+    size_t      mark;        // stageQueueMark() of that parser's output after the turn
+    Parser      parser;
+} SessionTask;
+
+// Counters of one parser thread, written by it alone
+typedef struct WorkerStats {
+    atomic_uint_fast64_t records;      // Events parsed
+    atomic_uint_fast64_t turns;        // Sessions run
+    atomic_uint_fast64_t steals;       // Turns taken from another parser's deque
+    atomic_uint_fast64_t depthTotal;   // Deque depth summed over the turns
+    atomic_uint_fast64_t depthMax;
+    atomic_uint_fast64_t idleNs;       // Time spent asleep
+} WorkerStats;
+
+// Parser thread. It gives the sessions in its deque turns of up to
+// PIPELINE_TURN_ITEMS events and steals sessions from the deepest other
+// deque when its own is empty.
+typedef struct Worker {
+    pthread_t   thread;
+    StageSignal signal;     // Sleeps here while there is nothing to run or steal
+    StageQueue  injected;   // int: slots of sessions the reader queued here
+    TaskDeque   deque;      // Slots of sessions waiting for a turn
+    StageQueue  output;     // StageResult to the aggregator
+    StageQueue  recycled;   // StageEvent * handed back to the reader
+    alignas(CACHE_LINE_SIZE) WorkerStats stats;
+    MetricsShard metrics;
+} Worker;
+
+#define MAX_WORKERS          16
+#define PIPELINE_QUEUE_ITEMS 256    // Items per queue and events per parser, a power of two
+#define PIPELINE_INBOX_ITEMS 64     // Events waiting per session, a power of two
+#define PIPELINE_PASS_ITEMS  1024   // Items the aggregator applies per journal commit at most
+#define PIPELINE_TURN_ITEMS  64     // Items taken from one session or parser before moving to the next
+#define PIPELINE_REPLIES     16     // Snapshots waiting for the reader, a power of two
+
+static Worker          workers[MAX_WORKERS];
+static int             workerCount;
+static SessionTask     tasks[MAX_SESSIONS];
+static StageEvent     *eventPool;              // workerCount * PIPELINE_QUEUE_ITEMS events
+static StageEvent    **freeEvents;             // Reader only: events ready to be filled
+static int             freeEventCount;
+static StageEvent     *reservedEvent;          // Reader only: filled since reserveEvent()
+static StageSignal     readerSignal;           // The reader sleeps here while every event is in use
+static atomic_bool     workersStopping;        // Nothing more is read: parsers exit once no session has work
+static atomic_bool     aggregatorStopping;     // Every parser has exited
+static struct timespec pipelineStarted;
+static pthread_t       aggregatorThread;
+static StageSignal     aggregatorSignal;   // The aggregator sleeps here while every parser output is empty
+static StageQueue      replyQueue;
+static int             pipelineFd = -1;     // eventfd: the aggregator wakes the reader for replies or a stop
+static atomic_bool     stopRequested;       // Set by the aggregator when a client sends "stop"
+static bool            pipelineRunning;     // Reader only: the stages are up
+
+// Metrics of the reader and aggregator threads; each parser has its own in Worker
+static MetricsShard readerMetrics;
+static MetricsShard aggregatorMetrics;
+static uint64_t     readTime;   // Reader only: metricsNow() of the read being handled
+
+// What the aggregator prints (--output), batched per pass
+static ConsoleMode consoleMode = CONSOLE_PRETTY;
+static Console     console;   // Aggregator only, main thread once the pipeline has stopped
+
+// Every destination seen, interned so parties refer to them by id
+static DestinationTable destinations;
+
+// Running statistics per destination id, returned by WIRE_QUERY
+static AggregateIndex destinationStats;
+
+// Write-ahead journal of party changes; fd -1 when --no-journal is given
+static Journal journal = { .fd = -1 };
+static bool    journalEnabled = true;
+
+// Session restored at startup, resumed if its client registers again
+typedef struct RecoveredSession {
+    bool       inUse;
+    bool       inParty;
+    long       pid;
+    uint64_t   records;   // Records the session had acknowledged
+    PartyBatch batch;
+} RecoveredSession;
+
+static RecoveredSession recoveredSessions[MAX_SESSIONS];
+
+// Parties that read records in this aggregator pass and are acknowledged
+// once the pass is committed. A closed party may leave a stale entry and
+// its slot be reused in the same pass, hence the extra room.
+static PartyState *ackQueue[MAX_SESSIONS + PIPELINE_PASS_ITEMS];
+static int         ackQueueLength;
+
+// Shared memory sessions left with records in their ring after their share
+// of a pass. No doorbell comes for those, so the next pass services them
+// without waiting for epoll. Closing a session takes it off the list.
+static Session *ringBacklog[MAX_SESSIONS];
+static int      ringBacklogLength;
+
+// Log storage chosen on the command line
+static LogBackend logBackend     = LOG_BACKEND_APPEND;
+static size_t     logSegmentSize = LOG_SEGMENT_DEFAULT_SIZE;
+
+// Query snapshot still being written to a client's reply FIFO or connection
+typedef struct PendingReply {
+    bool   inUse;
+    bool   halfClose;   // Sent on a socket connection, which stays open: shut down its write side
+    int    fd;
+    char  *data;
+    size_t length;
+    size_t sent;
+} PendingReply;
+
+#define MAX_PENDING_REPLIES 16
+
+// Replies waiting for their reply FIFO to drain; epoll tags them by address
+static PendingReply pendingReplies[MAX_PENDING_REPLIES];
+
+void processMessages(const char *fifoname);
+Session *openSession(Logger *logger, int fd, long pid);
+int  openListeners(void);
+void acceptConnections(Logger *logger, Listener *listener);
+bool nameConnection(Logger *logger, Session *session);
+void registerSession(Logger *logger, long pid, uint64_t resume, uint32_t flags);
+bool serviceSession(Logger *logger, Session *session);
+bool serviceRingSession(Logger *logger, Session *session);
+bool serviceRingBacklog(Logger *logger);
+void handleSessionRecords(Logger *logger, Session *session);
+void closeSession(Logger *logger, Session *session);
+int  createInactivityTimer(void);
+bool inactivityTimerExpired(int timerFd, const struct timespec *lastActivity);
+int  createShutdownSignalFd(void);
+void raiseDescriptorLimit(void);
+bool lockStateDirectory(void);
+int  defaultWorkerCount(void);
+int  startPipeline(Logger *logger);
+void stopPipeline(Logger *logger);
+void stopWorkers(void);
+void logWorkerStats(Logger *logger);
+StageEvent *reserveEvent(const Session *session, StageEventKind kind);
+void publishEvent(const Session *session);
+bool eventsRecycled(void *context);
+void *runWorker(void *context);
+bool workerReady(void *context);
+void queueTask(Worker *worker, int slot);
+bool stealTask(Worker *thief, int *slot);
+void runTask(Worker *worker, int slot);
+void parseEvent(Worker *worker, SessionTask *task, const StageEvent *event);
+void countStat(atomic_uint_fast64_t *counter, uint64_t amount);
+uint64_t elapsedNanos(const struct timespec *since);
+void *runAggregator(void *context);
+bool aggregatorReady(void *context);
+void handleResult(Logger *logger, const StageResult *result);
+void handleParsedRecord(Logger *logger, PartyState *state, const ParsedRecord *parsed);
+void handleTextLine(Logger *logger, PartyState *state, const ParsedRecord *parsed);
+const char *recordName(const ParsedRecord *parsed);
+void openParty(Logger *logger, PartyState *state, const StageHeader *header);
+void resumeParty(Logger *logger, PartyState *state, uint64_t resume);
+void closeParty(Logger *logger, PartyState *state);
+void answerQuery(Logger *logger, long pid, int connectionFd, bool metrics);
+char *formatMetrics(Logger *logger, size_t *length);
+void wakeReader(void);
+void receiveReplies(Logger *logger);
+void sendSnapshot(Logger *logger, long pid, int connectionFd, char *data, size_t length);
+void recoverState(Logger *logger);
+void applyJournalRecord(void *context, const JournalRecordHeader *header, const char *payload);
+PartyBatch *claimRecoveredSession(void *context, long pid, uint64_t records, bool inParty);
+RecoveredSession *findRecoveredSession(long pid, bool create);
+void releaseRecoveredSession(RecoveredSession *recovered);
+void journalRecord(JournalRecordType type, long pid, const void *payload, size_t length);
+int  commitJournal(Logger *logger);
+void writeSnapshot(Logger *logger);
+void queueAcknowledgement(PartyState *state);
+void sendAcknowledgements(void);
+bool flushReply(PendingReply *reply);
+void closeReply(PendingReply *reply);
+void startParty(PartyState *state);
+void setPartyDestination(PartyState *state, const char *destination, size_t length);
+void addPartyClient(PartyState *state, const Client *client);
+void endParty(Logger *logger, PartyState *state);
+void stopServer(Logger *logger);
+void writeToLog(Logger *logger, const char *message);
+
+int main(int argc, char *argv[]) {
+    workerCount = defaultWorkerCount();
+    
+    // Command line options
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mmap-log") == SUCCESS) {
+            logBackend = LOG_BACKEND_MMAP;   // Segmented, memory-mapped log
+        } else if (strcmp(argv[i], "--no-journal") == SUCCESS) {
+            journalEnabled = false;          // Party state is not kept across restarts
+        } else if (strcmp(argv[i], "--socket") == SUCCESS && i + 1 < argc
+                   && listenerCount < MAX_LISTENERS) {
+            // Accept sessions on a unix socket as well as the FIFOs
+            TransportAddress *address = &listeners[listenerCount++].address;
+            address->kind = TRANSPORT_UNIX;
+            address->path = argv[++i];
+        } else if (strcmp(argv[i], "--tcp") == SUCCESS && i + 1 < argc
+                   && listenerCount < MAX_LISTENERS) {
+            // Accept sessions on a loopback TCP port shared with other servers
+            TransportAddress *address = &listeners[listenerCount++].address;
+            address->kind = TRANSPORT_TCP;
+            if (transportParsePort(argv[++i], &address->port) == ERROR) {
+                printf("Error: --tcp must be a port between 1 and %u\n", UINT16_MAX);
+                return ERROR;
+            }
+        } else if (strcmp(argv[i], "--segment-mb") == SUCCESS && i + 1 < argc) {
+            char *numEndPtr = NULL;
+            long  megabytes = strtol(argv[++i], &numEndPtr, 10);
+            if (*numEndPtr != '\0' || megabytes <= 0 || megabytes > MAX_LOG_SEGMENT_MB) {
+                printf("Error: --segment-mb must be between 1 and %d\n", MAX_LOG_SEGMENT_MB);
+                return ERROR;
+            }
+            logSegmentSize = (size_t)megabytes * 1024 * 1024;
+        } else if (strcmp(argv[i], "--workers") == SUCCESS && i + 1 < argc) {
+            char *numEndPtr = NULL;
+            long  count     = strtol(argv[++i], &numEndPtr, 10);
+            if (*numEndPtr != '\0' || count <= 0 || count > MAX_WORKERS) {
+                printf("Error: --workers must be between 1 and %d\n", MAX_WORKERS);
+                return ERROR;
+            }
+            workerCount = (int)count;
+        } else if (strcmp(argv[i], "--output") == SUCCESS && i + 1 < argc) {
+            if (!consoleParseMode(argv[++i], &consoleMode)) {
+                printf("Error: --output must be quiet, compact or pretty\n");
+                return ERROR;
+            }
+        } else {
+            printf("Usage: %s [--mmap-log [--segment-mb N]] [--no-journal] [--socket PATH] [--tcp PORT]"
+                   " [--workers N] [--output quiet|compact|pretty]\n", argv[0]);
+            return ERROR;
+        }
+    }
+
+    // The journal, snapshot, log and FIFOs all live in the current directory
+    if (!lockStateDirectory()) {
+        return ERROR;
+    }
+    
+    printf("Travel Agency Server - Waiting for client data...\n");
+    consoleInit(&console, stdout);
+    
+    // Allow thousands of session FIFOs to be open at once
+    raiseDescriptorLimit();
+    
+    // A client that stops reading its reply FIFO must not kill the server
+    signal(SIGPIPE, SIG_IGN);
+    
+    // Create FIFO if it doesn't exist
+    if (mkfifo(FIFO_PATH, PERM_OWNER_RW_ALL_R) == -1) {
+        // FIFO might already exist, which is okay
+        if (errno != EEXIST) {
+            perror("Error creating FIFO");
+            return -1;
+        }
+    }
+    
+    // Process messages from clients
+    processMessages(FIFO_PATH);
+    
+    return 0;
+}
+
+/*
+ * FUNCTION: processMessages
+ * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca & Tuan Thanh Nguyen
+ * DESCRIPTION:
+    *  Processes messages from the FIFO, handling party and client data,
+    *  and logging activities to a log file.
+    *
+    *  The shared FIFO is opened once and read as a stream. The server also
+    *  holds a dummy write descriptor so read() never reports EOF between
+    *  clients. Clients register a private session FIFO with a HELLO message
+    *  and send their parties over it, so concurrent clients never share a
+    *  stream. Every session has its own LineFramer and party state.
+    *
+    *  One non-blocking epoll loop multiplexes all session FIFOs, a timerfd
+    *  for the inactivity timeout, a signalfd for SIGINT/SIGTERM and an
+    *  eventfd the aggregator raises for query replies and "stop", so the
+    *  server shuts down cleanly in every case. The records it reads go down
+    *  the pipeline; the pipeline is drained before the state is saved.
+ * PARAMETERS:
+    *  const char *fifoname : Path to the FIFO to read messages from.
+ * RETURNS : n/a
+ */
+void processMessages(const char *fifoname) {
+    Logger  logState;
+    Logger *logger = &logState;
+    if (loggerStart(logger, LOG_FILE_PATH, logBackend, logSegmentSize) == ERROR) {
+        return;
+    }
+    
+    writeToLog(logger, "Server started");
+    recoverState(logger);
+    
+    int timerFd  = -1;
+    int signalFd = -1;
+    int dummyFd  = -1;
+    
+    // Open FIFO for reading
+    /*
+    O_RDONLY is a flag that opens the FIFO in read-only mode.
+    O_NONBLOCK lets the open succeed before any client has connected, which
+    allows the server to open its own dummy writer straight after.
+    source: https://pubs.opengroup.org/onlinepubs/7908799/xsh/open.html
+    */
+    int fd = open(fifoname, O_RDONLY | O_NONBLOCK);
+    if (fd == -1) {
+        perror("Error opening FIFO for reading");
+        loggerStop(logger);
+        return;
+    }
+    
+    // Dummy writer: keeps the FIFO open so clients closing it never cause EOF
+    if ((dummyFd = open(fifoname, O_WRONLY)) == -1) {
+        perror("Error opening FIFO dummy writer");
+        close(fd);
+        loggerStop(logger);
+        return;
+    }
+    
+    Session           *shared        = NULL;
+    struct epoll_event timerEvent    = { .events = EPOLLIN, .data.ptr = &timerSource };
+    struct epoll_event signalEvent   = { .events = EPOLLIN, .data.ptr = &signalSource };
+    struct epoll_event pipelineEvent = { .events = EPOLLIN, .data.ptr = &pipelineSource };
+    if ((epollFd = epoll_create1(EPOLL_CLOEXEC)) == -1
+        || (timerFd = createInactivityTimer()) == -1
+        || (signalFd = createShutdownSignalFd()) == -1
+        || (pipelineFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1
+        || epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &timerEvent) == -1
+        || epoll_ctl(epollFd, EPOLL_CTL_ADD, signalFd, &signalEvent) == -1
+        || epoll_ctl(epollFd, EPOLL_CTL_ADD, pipelineFd, &pipelineEvent) == -1
+        || openListeners() == ERROR
+        || startPipeline(logger) == ERROR
+        || !(shared = openSession(logger, fd, 0))) {
+        perror("Error setting up the event loop");
+        close(fd);
+    } else {
+        // The shared FIFO always continues
+        StageEvent *event = reserveEvent(shared, STAGE_OPEN);
+        event->header.fd     = -1;
+        event->header.resume = 0;
+        publishEvent(shared);
+        printf("Listening for clients on %s (%d parser threads)\n", fifoname, workerCount);
+        for (int i = 0; i < listenerCount; i++) {
+            char address[MAX_BUFFER_SIZE];
+            transportDescribe(&listeners[i].address, address, sizeof(address));
+            printf("Listening for clients on %s\n", address);
+        }
+    }
+    
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+    struct timespec    lastActivity;
+    bool               serverRunning = shared != NULL;
+    clock_gettime(CLOCK_MONOTONIC, &lastActivity);
+    
+    while (serverRunning) {
+        int ready = epoll_wait(epollFd, events, MAX_EPOLL_EVENTS, ringBacklogLength > 0 ? 0 : -1);
+        if (ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Error waiting for events");
+            break;
+        }
+        
+        for (int i = 0; i < ready && serverRunning; i++) {
+            if (events[i].data.ptr == &timerSource) {
+                if (inactivityTimerExpired(timerFd, &lastActivity)) {
+                    printf("\nServer timeout: No activity for 2 minutes. Terminating server...\n");
+                    writeToLog(logger, "Server terminated due to inactivity timeout (2 minutes)");
+                    serverRunning = false;
+                }
+                continue;
+            }
+            if (events[i].data.ptr == &signalSource) {
+                struct signalfd_siginfo info;
+                if (read(signalFd, &info, sizeof(info)) == (ssize_t)sizeof(info)) {
+                    char message[SUMMARY_SIZE];
+                    snprintf(message, sizeof(message), "Server received signal %u, shutting down",
+                             info.ssi_signo);
+                    printf("\n%s\n", message);
+                    writeToLog(logger, message);
+                    serverRunning = false;
+                }
+                continue;
+            }
+            if (events[i].data.ptr == &pipelineSource) {
+                receiveReplies(logger);
+                serverRunning = !atomic_load(&stopRequested);
+                continue;
+            }
+            
+            // A reply FIFO has room for more of its snapshot
+            uintptr_t source = (uintptr_t)events[i].data.ptr;
+            if (source >= (uintptr_t)pendingReplies
+                && source < (uintptr_t)(pendingReplies + MAX_PENDING_REPLIES)) {
+                PendingReply *reply = events[i].data.ptr;
+                if (flushReply(reply)) {
+                    closeReply(reply);
+                }
+                continue;
+            }
+            
+            // Any session activity restarts the inactivity timeout
+            clock_gettime(CLOCK_MONOTONIC, &lastActivity);
+            
+            // A listening socket has connections waiting
+            if (source >= (uintptr_t)listeners && source < (uintptr_t)(listeners + MAX_LISTENERS)) {
+                acceptConnections(logger, events[i].data.ptr);
+                continue;
+            }
+            
+            Session *session = events[i].data.ptr;
+            if (!serviceSession(logger, session)) {
+                closeSession(logger, session);
+            }
+        }
+        if (serverRunning && ringBacklogLength > 0) {
+            serverRunning = serviceRingBacklog(logger);
+        }
+    }
+    
+    // Let the aggregator apply, commit and acknowledge everything read so
+    // far, then save the open sessions so a restart picks them up and close
+    // the journal so closing them here is not recorded
+    stopPipeline(logger);
+    writeSnapshot(logger);
+    journalClose(&journal);
+    
+    for (int i = MAX_SESSIONS - 1; i >= 0; i--) {
+        if (sessions[i].inUse) {
+            closeSession(logger, &sessions[i]);
+        }
+    }
+    consoleFlush(&console);
+    if (signalFd != -1) {
+        close(signalFd);
+    }
+    if (timerFd != -1) {
+        close(timerFd);
+    }
+    if (pipelineFd != -1) {
+        close(pipelineFd);
+    }
+    if (epollFd != -1) {
+        close(epollFd);
+    }
+    close(dummyFd);
+    for (int i = 0; i < listenerCount; i++) {
+        if (listeners[i].fd != -1) {
+            close(listeners[i].fd);
+            if (listeners[i].address.kind == TRANSPORT_UNIX) {
+                unlink(listeners[i].address.path);
+            }
+        }
+    }
+    for (int i = 0; i < MAX_PENDING_REPLIES; i++) {
+        closeReply(&pendingReplies[i]);
+    }
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        releaseRecoveredSession(&recoveredSessions[i]);
+    }
+    aggregateFree(&destinationStats);
+    destinationTableFree(&destinations);
+    
+    LoggerStats stats = loggerGetStats(logger);
+    char        message[SUMMARY_SIZE];
+    snprintf(message, sizeof(message),
+             "Logger: %lu messages in %lu batches, %lu dropped, max queue depth %zu, %lu segment rotations",
+             stats.logged, stats.batches,
+             stats.dropped, stats.maxQueueDepth, stats.rotations);
+    writeToLog(logger, message);
+    if (journalEnabled) {
+        snprintf(message, sizeof(message), "Journal: %lu records in %lu commits",
+                 journal.records, journal.commits);
+        writeToLog(logger, message);
+    }
+    writeToLog(logger, "Server stopped");
+    loggerStop(logger);
+}
+
+/*
+ * FUNCTION: openSession
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Adds a session for an open FIFO read descriptor and registers it with
+    *  the event loop. Its party is opened by the STAGE_OPEN the caller
+    *  sends once the session's client is known.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  int fd : Read end of the session FIFO, switched to non-blocking.
+    *  long pid : Client pid, 0 for the shared FIFO.
+ * RETURNS : Session * - the new session, or NULL if it could not be added.
+ */
+Session *openSession(Logger *logger, int fd, long pid) {
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        Session *session = &sessions[i];
+        if (session->inUse) {
+            continue;
+        }
+        
+        memset(session, 0, sizeof(*session));
+        if (framerInit(&session->framer, FRAMER_DEFAULT_CAPACITY) == ERROR) {
+            return NULL;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = session };
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            perror("Error adding session to the event loop");
+            return NULL;
+        }
+        session->inUse = true;
+        session->fd    = fd;
+        session->pid   = pid;
+        return session;
+    }
+    
+    writeToLog(logger, "Rejected session - too many sessions");
+    return NULL;
+}
+
+/*
+ * FUNCTION: openListeners
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Opens the sockets given with --socket and --tcp and adds them to the event loop.
+ * PARAMETERS: n/a
+ * RETURNS : int - SUCCESS, or ERROR with errno set if one could not be opened.
+ */
+int openListeners(void) {
+    for (int i = 0; i < listenerCount; i++) {
+        listeners[i].fd = -1;
+    }
+    for (int i = 0; i < listenerCount; i++) {
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = &listeners[i] };
+        if ((listeners[i].fd = transportListen(&listeners[i].address)) == -1
+            || epoll_ctl(epollFd, EPOLL_CTL_ADD, listeners[i].fd, &event) == -1) {
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: acceptConnections
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Accepts every pending connection of a listening socket as a session.
+    *  The session is named by the HELLO its client sends first (see
+    *  nameConnection()).
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  Listener *listener : Socket that epoll reported as readable.
+ * RETURNS : n/a
+ */
+void acceptConnections(Logger *logger, Listener *listener) {
+    int fd;
+    while ((fd = transportAccept(listener->fd)) != -1) {
+        Session *session = openSession(logger, fd, 0);
+        if (!session) {
+            close(fd);   // The client sees the connection close
+            continue;
+        }
+        session->connection = true;
+    }
+    if (errno != EAGAIN && errno != ECONNABORTED) {
+        perror("Error accepting a connection");
+    }
+}
+
+/*
+ * FUNCTION: registerSession
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Handles a HELLO message by opening the reply FIFO and the private FIFO
+    *  of the client and adding them as a new session. The reply FIFO is
+    *  opened first: the client may wait for acknowledgements as soon as its
+    *  session FIFO is open. A shared memory client's ring is mapped before
+    *  that too, since the client starts filling it right away.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  long pid : Client pid from the HELLO message.
+    *  uint64_t resume : Records acknowledged before the client lost its session, or WIRE_NEW_SESSION.
+    *  uint32_t flags : WIRE_HELLO_* flags from the HELLO message.
+ * RETURNS : n/a
+ */
+void registerSession(Logger *logger, long pid, uint64_t resume, uint32_t flags) {
+    char    path[MAX_FIFO_PATH_LEN];
+    char    message[SUMMARY_SIZE];
+    ShmRing ring = {0};
+    
+    if ((flags & WIRE_HELLO_SHM) && shmRingAttach(&ring, pid) == ERROR) {
+        snprintf(message, sizeof(message), "Could not map the record ring of client %ld", pid);
+        writeToLog(logger, message);
+        return;
+    }
+    
+    // ENXIO: the client is not reading a reply FIFO, its records go unacknowledged
+    int replyFd = -1;
+    if (replyFifoPath(path, sizeof(path), pid) == SUCCESS) {
+        replyFd = open(path, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    }
+    
+    if (sessionFifoPath(path, sizeof(path), pid) == ERROR) {
+        if (replyFd != -1) {
+            close(replyFd);
+        }
+        shmRingClose(&ring);
+        return;
+    }
+    
+    // Non-blocking so a client that died before connecting can't stall us
+    int fd = open(path, O_RDONLY | O_NONBLOCK);
+    Session *session = fd == -1 ? NULL : openSession(logger, fd, pid);
+    if (!session) {
+        snprintf(message, sizeof(message), "Could not open session FIFO %s", path);
+        writeToLog(logger, message);
+        if (fd != -1) {
+            close(fd);
+        }
+        if (replyFd != -1) {
+            close(replyFd);
+        }
+        shmRingClose(&ring);
+        return;
+    }
+    session->ring = ring;
+    
+    // The aggregator takes over the reply FIFO and resumes the party
+    StageEvent *event = reserveEvent(session, STAGE_OPEN);
+    event->header.ring   = ring.shared != NULL;
+    event->header.fd     = replyFd;
+    event->header.resume = resume;
+    publishEvent(session);
+}
+
+/*
+ * FUNCTION: serviceSession
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Reads the next chunk of a session stream and handles every complete
+    *  record in it. The framer keeps the incomplete tail for the next read.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  Session *session : Session that poll() reported as readable.
+ * RETURNS : bool - false once the client has closed the session.
+ */
+bool serviceSession(Logger *logger, Session *session) {
+    if (session->ring.shared) {
+        return serviceRingSession(logger, session);
+    }
+    
+    ssize_t bytesRead = framerFill(&session->framer, session->fd);
+    if (bytesRead == -1) {
+        if (errno == EAGAIN || errno == EINTR) {
+            return true;
+        }
+        perror("Error reading from FIFO");
+        return false;
+    }
+    if (bytesRead == 0) {
+        return false;   // Writer closed its end
+    }
+    readTime = metricsNow();
+    metricsCount(&readerMetrics, METRICS_BYTES, (uint64_t)bytesRead);
+    
+    if (session->connection && session->pid == 0 && !nameConnection(logger, session)) {
+        return false;
+    }
+    handleSessionRecords(logger, session);
+    return true;
+}
+
+/*
+ * FUNCTION: nameConnection
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Handles the record a socket connection starts with. A HELLO names
+    *  the session after its client and resumes it like a registration on
+    *  the shared FIFO, with the acknowledgements going back on the
+    *  connection. A WIRE_QUERY or WIRE_METRICS is answered on a duplicate
+    *  of the connection, which is then half closed; the session itself is
+    *  closed at once, so nothing sent after the query is read or credited
+    *  to a party. Anything else ends the connection.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  Session *session : Unnamed connection with newly buffered bytes.
+ * RETURNS : bool - false if the connection must be closed (after a query, or without a HELLO).
+ */
+bool nameConnection(Logger *logger, Session *session) {
+    RecordView record;
+    long       pid    = 0;
+    uint64_t   resume = 0;
+    uint32_t   flags  = 0;
+    
+    if (!framerNext(&session->framer, &record)) {
+        return true;   // The first record is not complete yet
+    }
+    if ((record.type == WIRE_QUERY || record.type == WIRE_METRICS)
+        && wireDecodeQuery(record.data, record.length, &pid)) {
+        int replyFd = fcntl(session->fd, F_DUPFD_CLOEXEC, 0);
+        if (replyFd != -1) {
+            StageEvent *event = reserveEvent(session, record.type == WIRE_QUERY ? STAGE_QUERY : STAGE_METRICS);
+            event->header.fd  = replyFd;
+            event->header.pid = pid;
+            publishEvent(session);
+        }
+        return false;   // The answer goes out on replyFd; the rest of the input is discarded
+    }
+    
+    bool hello = record.type == WIRE_TEXT
+                 ? textDecodeHello(record.data, record.length, &pid, &resume, &flags)
+                 : record.type == WIRE_HELLO && wireDecodeHello(record.data, record.length, &pid, &resume, &flags);
+    if (!hello || pid <= 0 || (flags & WIRE_HELLO_SHM)) {
+        writeToLog(logger, "Closed a connection that did not start with a HELLO");
+        return false;
+    }
+    
+    // A descriptor of their own lets the acknowledgements stop without closing the session
+    int replyFd  = fcntl(session->fd, F_DUPFD_CLOEXEC, 0);
+    session->pid = pid;
+    
+    StageEvent *event = reserveEvent(session, STAGE_OPEN);
+    event->header.connection = true;
+    event->header.fd         = replyFd;
+    event->header.resume     = resume;
+    publishEvent(session);
+    return true;
+}
+
+/*
+ * FUNCTION: serviceRingSession
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Services a session whose records arrive through shared memory. The
+    *  doorbells on the session FIFO are discarded and up to a ring's worth
+    *  of records is handed on, so one busy client cannot hold up the
+    *  others while it keeps filling the ring. The client is then asked for a
+    *  doorbell; if records arrived meanwhile the session goes on the ring
+    *  backlog for the next pass instead, so none is ever missed.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  Session *session : Session that poll() reported as readable.
+ * RETURNS : bool - false once the client has closed the session.
+ */
+bool serviceRingSession(Logger *logger, Session *session) {
+    // The client rings once per sleep, so one read takes every doorbell
+    char    doorbells[MAX_BUFFER_SIZE];
+    ssize_t bytesRead;
+    do {
+        bytesRead = read(session->fd, doorbells, sizeof(doorbells));
+    } while (bytesRead == -1 && errno == EINTR);
+    if (bytesRead == -1 && errno != EAGAIN) {
+        perror("Error reading from FIFO");
+    }
+    bool stillOpen = bytesRead > 0 || (bytesRead == -1 && errno == EAGAIN);   // Ring is drained first
+    
+    size_t      length;
+    const char *record;
+    readTime = metricsNow();
+    for (int handled = 0; !atomic_load(&stopRequested) && (handled < SHM_RING_SLOTS || !stillOpen)
+                          && (record = shmRingPeek(&session->ring, &length)) != NULL; handled++) {
+        if (framerPush(&session->framer, record, length) == ERROR) {
+            perror("Error buffering session record");
+            return false;
+        }
+        shmRingRelease(&session->ring);
+        metricsCount(&readerMetrics, METRICS_BYTES, length);
+        handleSessionRecords(logger, session);
+    }
+    
+    if (stillOpen && !atomic_load(&stopRequested) && !session->ringBacklogged
+        && !shmRingSleep(&session->ring)) {
+        session->ringBacklogged          = true;
+        ringBacklog[ringBacklogLength++] = session;
+    }
+    return stillOpen;
+}
+
+/*
+ * FUNCTION: serviceRingBacklog
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Services once every shared memory session that was on the ring
+    *  backlog at the start of the call. Sessions that still have records
+    *  afterwards are back on the backlog for the next pass.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+ * RETURNS : bool - false if a client has stopped the server.
+ */
+bool serviceRingBacklog(Logger *logger) {
+    for (int pending = ringBacklogLength; pending > 0 && ringBacklogLength > 0; pending--) {
+        Session *session = ringBacklog[0];
+        ringBacklog[0]          = ringBacklog[--ringBacklogLength];
+        session->ringBacklogged = false;
+        
+        bool stillOpen = serviceRingSession(logger, session);
+        if (atomic_load(&stopRequested)) {
+            return false;
+        }
+        if (!stillOpen) {
+            closeSession(logger, session);
+        }
+    }
+    return true;
+}
+
+/*
+ * FUNCTION: handleSessionRecords
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Queues every complete record buffered in a session's framer for the
+    *  parser threads. A HELLO on the shared FIFO registers its client's
+    *  session right away, so the new session's records can be read in this
+    *  very pass, and goes no further. A HELLO on any other session would
+    *  let one client register another's pid, so it is rejected. Records
+    *  the framer dropped, rejected HELLOs, and text lines too long for the
+    *  pipeline are passed on as a count: they still number among the
+    *  records the client is acknowledged for.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  Session *session : Session with newly buffered bytes.
+ * RETURNS : n/a
+ */
+void handleSessionRecords(Logger *logger, Session *session) {
+    unsigned long discarded = session->framer.discarded;
+    unsigned long rejected  = 0;   // HELLOs outside the shared FIFO
+    bool          shared    = !session->connection && session->pid == 0;
+    RecordView    record;
+    long          pid    = 0;
+    uint64_t      resume = 0;
+    uint32_t      flags  = 0;
+    while (framerNext(&session->framer, &record)) {
+        if (record.length > PARSER_MAX_LINE) {
+            session->framer.discarded++;   // Only a text line can be this long
+            continue;
+        }
+        if (record.type == WIRE_TEXT
+            ? textDecodeHello(record.data, record.length, &pid, &resume, &flags)
+            : record.type == WIRE_HELLO && wireDecodeHello(record.data, record.length, &pid, &resume, &flags)) {
+            if (shared) {
+                registerSession(logger, pid, resume, flags);
+            } else {
+                rejected++;
+            }
+            continue;
+        }
+        
+        StageEvent *event = reserveEvent(session, STAGE_RECORD);
+        event->header.readTime = readTime;
+        event->type            = record.type;
+        event->length          = record.length;
+        memcpy(event->data, record.data, record.length);
+        event->data[record.length] = '\0';
+        publishEvent(session);
+        metricsCount(&readerMetrics, METRICS_MESSAGES, 1);
+    }
+    
+    if (session->framer.discarded != discarded || rejected > 0) {
+        StageEvent *event = reserveEvent(session, STAGE_DISCARDED);
+        event->header.count = session->framer.discarded - discarded + rejected;
+        metricsCount(&readerMetrics, METRICS_PARSE_ERRORS, event->header.count);
+        publishEvent(session);
+    }
+}
+
+/*
+ * FUNCTION: closeSession
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Closes a session's stream. Its party is closed by the aggregator,
+    *  after every record read before it, or right here once the pipeline
+    *  has stopped.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  Session *session : Session to close.
+ * RETURNS : n/a
+ */
+void closeSession(Logger *logger, Session *session) {
+    char message[SUMMARY_SIZE];
+    
+    if (session->framer.discarded > 0) {
+        snprintf(message, sizeof(message), "Discarded %lu oversized messages",
+                 session->framer.discarded);
+        writeToLog(logger, message);
+    }
+    if (!session->connection || session->pid > 0) {   // An unnamed connection has no party
+        if (pipelineRunning) {
+            reserveEvent(session, STAGE_CLOSE);
+            publishEvent(session);
+        } else {
+            closeParty(logger, &parties[session - sessions]);
+        }
+    }
+    
+    // The client owns (and removes) its FIFO; it may already be reusing the
+    // path for its next party, so the server never unlinks it
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, session->fd, NULL);
+    close(session->fd);
+    for (int i = 0; session->ringBacklogged && i < ringBacklogLength; i++) {
+        if (ringBacklog[i] == session) {
+            ringBacklog[i]          = ringBacklog[--ringBacklogLength];
+            session->ringBacklogged = false;
+        }
+    }
+    shmRingClose(&session->ring);   // The client removes the segment
+    framerFree(&session->framer);
+    memset(session, 0, sizeof(*session));
+}
+
+/*
+ * FUNCTION: createInactivityTimer
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Creates a timerfd that first expires TIMEOUT_DURATION seconds from now.
+ * PARAMETERS: n/a
+ * RETURNS : int - the timer descriptor, or -1 on failure.
+ */
+int createInactivityTimer(void) {
+    int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerFd == -1) {
+        return -1;
+    }
+    
+    struct itimerspec timeout = { .it_value = { .tv_sec = TIMEOUT_DURATION } };
+    if (timerfd_settime(timerFd, 0, &timeout, NULL) == -1) {
+        close(timerFd);
+        return -1;
+    }
+    return timerFd;
+}
+
+/*
+ * FUNCTION: inactivityTimerExpired
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Handles an expiry of the inactivity timer. Activity only records a
+    *  timestamp (no syscall per read), so when the timer fires it is
+    *  re-armed for the rest of the timeout if there was activity since.
+ * PARAMETERS:
+    *  int timerFd : Inactivity timer descriptor.
+    *  const struct timespec *lastActivity : Time of the last session activity.
+ * RETURNS : bool - true if the server was idle for TIMEOUT_DURATION seconds.
+ */
+bool inactivityTimerExpired(int timerFd, const struct timespec *lastActivity) {
+    uint64_t        expirations;
+    struct timespec now;
+    
+    if (read(timerFd, &expirations, sizeof(expirations)) != (ssize_t)sizeof(expirations)) {
+        return false;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    time_t idleSeconds = now.tv_sec - lastActivity->tv_sec;
+    if (idleSeconds >= TIMEOUT_DURATION) {
+        return true;
+    }
+    
+    // Expire again TIMEOUT_DURATION seconds after the last activity
+    struct itimerspec timeout = { .it_value = { .tv_sec = TIMEOUT_DURATION - idleSeconds } };
+    timerfd_settime(timerFd, 0, &timeout, NULL);
+    return false;
+}
+
+/*
+ * FUNCTION: createShutdownSignalFd
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Blocks SIGINT, SIGTERM and SIGHUP and returns a signalfd that reports
+    *  them, so the event loop can shut down cleanly instead of being killed.
+ * PARAMETERS: n/a
+ * RETURNS : int - the signal descriptor, or -1 on failure.
+ */
+int createShutdownSignalFd(void) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGHUP);
+    
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1) {
+        return -1;
+    }
+    return signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+}
+
+/*
+ * FUNCTION: raiseDescriptorLimit
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Raises the open file limit to its hard maximum (one descriptor per session).
+ * PARAMETERS: n/a
+ * RETURNS : n/a
+ */
+void raiseDescriptorLimit(void) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == SUCCESS && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+/*
+ * FUNCTION: lockStateDirectory
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Takes an exclusive lock on SERVER_LOCK_PATH for the life of the
+    *  process. A second server started in the same directory, for example
+    *  to share a --tcp port through SO_REUSEPORT, would replay and append
+    *  to the same journal, overwrite the same snapshot and log, and read
+    *  HELLOs off the same shared FIFO, so it is refused instead; servers
+    *  that share a port each run in a directory of their own. The kernel
+    *  drops the lock when the process exits, even after a crash, so a
+    *  restarted server never finds a stale one.
+ * PARAMETERS: n/a
+ * RETURNS : bool - true if this process now owns the directory's state.
+ */
+bool lockStateDirectory(void) {
+    int fd = open(SERVER_LOCK_PATH, O_RDWR | O_CREAT | O_CLOEXEC, PERM_OWNER_RW_ALL_R);
+    if (fd == -1) {
+        perror("Error opening " SERVER_LOCK_PATH);
+        return false;
+    }
+    if (flock(fd, LOCK_EX | LOCK_NB) == -1) {
+        if (errno == EWOULDBLOCK) {
+            printf("Error: Another server is already running in this directory; "
+                   "start each server in a directory of its own\n");
+        } else {
+            perror("Error locking " SERVER_LOCK_PATH);
+        }
+        close(fd);
+        return false;
+    }
+    return true;   // fd stays open, and the lock held, until the process exits
+}
+
+/*
+ * FUNCTION: defaultWorkerCount
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Picks the number of parser threads: the CPUs not taken by the reader and the aggregator.
+ * PARAMETERS: n/a
+ * RETURNS : int - between 1 and MAX_WORKERS.
+ */
+int defaultWorkerCount(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN) - 2;
+    if (count < 1) {
+        return 1;
+    }
+    return count > MAX_WORKERS ? MAX_WORKERS : (int)count;
+}
+
+/*
+ * FUNCTION: startPipeline
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Creates the pipeline queues and the event pool and starts
+    *  workerCount parser threads and the aggregator thread. Sessions start
+    *  out spread over the parsers by slot. The threads block every signal
+    *  so SIGINT and SIGTERM keep reaching the main thread's signalfd.
+ * PARAMETERS:
+    *  Logger *logger : Logger the aggregator writes to.
+ * RETURNS : int - SUCCESS, or ERROR if the pipeline could not be started.
+ */
+int startPipeline(Logger *logger) {
+    int events = workerCount * PIPELINE_QUEUE_ITEMS;
+    if (stageSignalInit(&aggregatorSignal) == ERROR
+        || stageSignalInit(&readerSignal) == ERROR
+        || stageQueueInit(&replyQueue, PIPELINE_REPLIES, sizeof(StageReply), NULL) == ERROR
+        || !(eventPool = malloc((size_t)events * sizeof(StageEvent)))
+        || !(freeEvents = malloc((size_t)events * sizeof(StageEvent *)))) {
+        perror("Error creating the pipeline queues");
+        return ERROR;
+    }
+    for (freeEventCount = 0; freeEventCount < events; freeEventCount++) {
+        freeEvents[freeEventCount] = &eventPool[events - 1 - freeEventCount];
+    }
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        parserInit(&tasks[i].parser);
+        atomic_init(&tasks[i].scheduled, false);
+        atomic_init(&tasks[i].worker, i % workerCount);
+        if (stageQueueInit(&tasks[i].inbox, PIPELINE_INBOX_ITEMS, sizeof(StageEvent *), NULL) == ERROR) {
+            perror("Error creating the pipeline queues");
+            return ERROR;
+        }
+    }
+    for (int i = 0; i < workerCount; i++) {
+        Worker *worker = &workers[i];
+        if (stageSignalInit(&worker->signal) == ERROR
+            || stageQueueInit(&worker->injected, MAX_SESSIONS, sizeof(int), &worker->signal) == ERROR
+            || taskDequeInit(&worker->deque, MAX_SESSIONS) == ERROR
+            || stageQueueInit(&worker->output, PIPELINE_QUEUE_ITEMS, sizeof(StageResult),
+                              &aggregatorSignal) == ERROR
+            || stageQueueInit(&worker->recycled, MAX_WORKERS * PIPELINE_QUEUE_ITEMS, sizeof(StageEvent *),
+                              &readerSignal) == ERROR) {
+            perror("Error creating the pipeline queues");
+            return ERROR;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &pipelineStarted);
+    
+    sigset_t allSignals;
+    sigset_t previous;
+    sigfillset(&allSignals);
+    pthread_sigmask(SIG_SETMASK, &allSignals, &previous);
+    int created = SUCCESS;
+    int started = 0;
+    while (started < workerCount
+           && (created = pthread_create(&workers[started].thread, NULL, runWorker, &workers[started])) == SUCCESS) {
+        started++;
+    }
+    if (created == SUCCESS) {
+        created = pthread_create(&aggregatorThread, NULL, runAggregator, logger);
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    
+    if (created != SUCCESS) {
+        errno = created;
+        perror("Error starting the pipeline threads");
+        workerCount = started;   // Only these need stopping; nothing was queued for them
+        stopWorkers();
+        return ERROR;
+    }
+    pipelineRunning = true;
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: stopPipeline
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Stops the pipeline once everything already read has gone through it:
+    *  the parsers exit once every session's events are parsed, then the
+    *  aggregator commits and acknowledges its last pass before it exits.
+    *  Logs the parsers' counters. Replies the reader no longer sends are
+    *  dropped.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+ * RETURNS : n/a
+ */
+void stopPipeline(Logger *logger) {
+    if (pipelineRunning) {
+        stopWorkers();
+        atomic_store(&aggregatorStopping, true);
+        stageSignalWake(&aggregatorSignal);
+        pthread_join(aggregatorThread, NULL);
+        pipelineRunning = false;
+        logWorkerStats(logger);
+    }
+    
+    StageReply *reply;
+    while (replyQueue.items && (reply = stageQueuePeek(&replyQueue)) != NULL) {
+        if (reply->fd != -1) {
+            close(reply->fd);
+        }
+        free(reply->data);
+        stageQueueRelease(&replyQueue);
+    }
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        if (tasks[i].inbox.items) {
+            stageQueueFree(&tasks[i].inbox);
+            parserFree(&tasks[i].parser);
+        }
+    }
+    for (int i = 0; i < MAX_WORKERS; i++) {
+        if (workers[i].recycled.items) {
+            stageQueueFree(&workers[i].injected);
+            taskDequeFree(&workers[i].deque);
+            stageQueueFree(&workers[i].output);
+            stageQueueFree(&workers[i].recycled);
+            stageSignalDestroy(&workers[i].signal);
+        }
+    }
+    if (replyQueue.items) {
+        stageQueueFree(&replyQueue);
+        stageSignalDestroy(&readerSignal);
+        stageSignalDestroy(&aggregatorSignal);
+    }
+    free(eventPool);
+    free(freeEvents);
+    eventPool  = NULL;
+    freeEvents = NULL;
+}
+
+/*
+ * FUNCTION: stopWorkers
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Tells the parser threads nothing more is coming and waits until they have parsed everything.
+ * PARAMETERS: n/a
+ * RETURNS : n/a
+ */
+void stopWorkers(void) {
+    atomic_store(&workersStopping, true);
+    for (int i = 0; i < workerCount; i++) {
+        stageSignalWake(&workers[i].signal);
+    }
+    for (int i = 0; i < workerCount; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+}
+
+/*
+ * FUNCTION: logWorkerStats
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Logs what each parser thread did: events parsed, turns given to
+    *  sessions, turns stolen from other parsers, how deep its deque was at
+    *  the start of a turn, and the share of the pipeline's lifetime it was
+    *  awake.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+ * RETURNS : n/a
+ */
+void logWorkerStats(Logger *logger) {
+    uint64_t lifetime = elapsedNanos(&pipelineStarted);
+    for (int i = 0; i < workerCount; i++) {
+        WorkerStats *stats  = &workers[i].stats;
+        uint64_t     turns  = atomic_load(&stats->turns);
+        uint64_t     idle   = atomic_load(&stats->idleNs);
+        double       busy   = lifetime > idle ? 100.0 * (double)(lifetime - idle) / (double)lifetime : 0.0;
+        double       depth  = turns > 0 ? (double)atomic_load(&stats->depthTotal) / (double)turns : 0.0;
+        char         message[SUMMARY_SIZE];
+        snprintf(message, sizeof(message),
+                 "Parser %d: %llu records in %llu turns, %llu stolen, queue depth %.1f average %llu max, %.1f%% busy",
+                 i, (unsigned long long)atomic_load(&stats->records), (unsigned long long)turns,
+                 (unsigned long long)atomic_load(&stats->steals), depth,
+                 (unsigned long long)atomic_load(&stats->depthMax), busy);
+        writeToLog(logger, message);
+    }
+}
+
+/*
+ * FUNCTION: reserveEvent
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Takes an event from the pool for a session, waiting while every
+    *  event is still being parsed. Fill it in and hand it over with
+    *  publishEvent().
+ * PARAMETERS:
+    *  const Session *session : Session the event is about.
+    *  StageEventKind kind : Kind of event.
+ * RETURNS : StageEvent * - the event, its header cleared.
+ */
+StageEvent *reserveEvent(const Session *session, StageEventKind kind) {
+    while (!reservedEvent && freeEventCount == 0) {
+        for (int i = 0; i < workerCount; i++) {
+            StageEvent **recycled;
+            while ((recycled = stageQueuePeek(&workers[i].recycled)) != NULL) {
+                freeEvents[freeEventCount++] = *recycled;
+                stageQueueRelease(&workers[i].recycled);
+            }
+        }
+        if (freeEventCount == 0) {
+            stageSignalWait(&readerSignal, eventsRecycled, NULL);
+        }
+    }
+    if (!reservedEvent) {
+        reservedEvent = freeEvents[--freeEventCount];
+    }
+    
+    StageEvent *event = reservedEvent;
+    memset(&event->header, 0, sizeof(event->header));
+    event->header.kind = kind;
+    event->header.slot = (int)(session - sessions);
+    event->header.fd   = -1;
+    event->header.pid  = session->pid;
+    return event;
+}
+
+/*
+ * FUNCTION: publishEvent
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Queues the event from reserveEvent() behind the session's earlier
+    *  ones, waiting while its inbox is full. A session that was idle is
+    *  queued on the parser that ran it last, whose cache still holds its
+    *  parser state.
+ * PARAMETERS:
+    *  const Session *session : Session the event is about.
+ * RETURNS : n/a
+ */
+void publishEvent(const Session *session) {
+    int          slot  = (int)(session - sessions);
+    SessionTask *task  = &tasks[slot];
+    StageEvent **queued = stageQueueReserve(&task->inbox, true);
+    *queued       = reservedEvent;
+    reservedEvent = NULL;
+    stageQueuePublish(&task->inbox);
+    
+    if (!atomic_exchange(&task->scheduled, true)) {
+        Worker *worker = &workers[atomic_load_explicit(&task->worker, memory_order_relaxed)];
+        int    *item   = stageQueueReserve(&worker->injected, true);
+        *item = slot;
+        stageQueuePublish(&worker->injected);
+    }
+}
+
+/*
+ * FUNCTION: eventsRecycled
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: StageReady for the reader: true once a parser has handed an event back.
+ * PARAMETERS:
+    *  void *context : Unused.
+ * RETURNS : bool - true if a recycled queue is not empty.
+ */
+bool eventsRecycled(void *context) {
+    (void)context;
+    for (int i = 0; i < workerCount; i++) {
+        if (stageQueueReadable(&workers[i].recycled)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * FUNCTION: runWorker
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Parser thread. Moves the sessions the reader queued here into its
+    *  deque and gives them turns in order. With its deque empty it steals
+    *  a session from another parser, and with nothing to steal either it
+    *  sleeps until the reader queues a session here or another parser has
+    *  sessions waiting.
+ * PARAMETERS:
+    *  void *context : The thread's Worker.
+ * RETURNS : void * - NULL once the pipeline stops and no session has work left.
+ */
+void *runWorker(void *context) {
+    Worker *worker = context;
+    for (;;) {
+        bool stopping = atomic_load(&workersStopping);
+        int *injected;
+        int  slot;
+        while ((injected = stageQueuePeek(&worker->injected)) != NULL) {
+            queueTask(worker, *injected);
+            stageQueueRelease(&worker->injected);
+        }
+        
+        if (taskDequeTake(&worker->deque, &slot)) {
+            runTask(worker, slot);
+        } else if (stealTask(worker, &slot)) {
+            countStat(&worker->stats.steals, 1);
+            runTask(worker, slot);
+        } else if (stopping) {
+            return NULL;
+        } else {
+            struct timespec asleep;
+            clock_gettime(CLOCK_MONOTONIC, &asleep);
+            stageSignalWait(&worker->signal, workerReady, worker);
+            countStat(&worker->stats.idleNs, elapsedNanos(&asleep));
+        }
+    }
+}
+
+/*
+ * FUNCTION: workerReady
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: StageReady for a parser: true once it has a session to run or steal, or is told to stop.
+ * PARAMETERS:
+    *  void *context : The parser's Worker.
+ * RETURNS : bool - true if the parser has something to do.
+ */
+bool workerReady(void *context) {
+    Worker *worker = context;
+    if (atomic_load(&workersStopping) || stageQueueReadable(&worker->injected)) {
+        return true;
+    }
+    for (int i = 0; i < workerCount; i++) {
+        if (taskDequeDepth(&workers[i].deque) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * FUNCTION: queueTask
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Adds a session to the bottom of a parser's deque. Once more than the
+    *  next turn is waiting there, a sleeping parser is woken to steal.
+ * PARAMETERS:
+    *  Worker *worker : Calling parser.
+    *  int slot : Session to queue.
+ * RETURNS : n/a
+ */
+void queueTask(Worker *worker, int slot) {
+    taskDequePush(&worker->deque, slot);   // Never full: a session waits in one deque at a time
+    size_t depth = taskDequeDepth(&worker->deque);
+    if (depth > atomic_load_explicit(&worker->stats.depthMax, memory_order_relaxed)) {
+        atomic_store_explicit(&worker->stats.depthMax, depth, memory_order_relaxed);
+    }
+    
+    for (int i = 0; depth > 1 && i < workerCount; i++) {
+        if (&workers[i] != worker && atomic_load(&workers[i].signal.sleeping)) {
+            stageSignalWake(&workers[i].signal);
+            break;
+        }
+    }
+}
+
+/*
+ * FUNCTION: stealTask
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Takes the longest-waiting session of the parser with the deepest deque.
+ * PARAMETERS:
+    *  Worker *thief : Calling parser.
+    *  int *slot : Receives the session.
+ * RETURNS : bool - true if a session was stolen, false if no other parser had one waiting.
+ */
+bool stealTask(Worker *thief, int *slot) {
+    for (int attempt = 0; attempt < workerCount; attempt++) {
+        Worker *victim  = NULL;
+        size_t  deepest = 0;
+        for (int i = 0; i < workerCount; i++) {
+            size_t depth = &workers[i] != thief ? taskDequeDepth(&workers[i].deque) : 0;
+            if (depth > deepest) {
+                victim  = &workers[i];
+                deepest = depth;
+            }
+        }
+        if (!victim) {
+            return false;
+        }
+        if (taskDequeTake(&victim->deque, slot)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * FUNCTION: runTask
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Gives a session a turn: parses up to PIPELINE_TURN_ITEMS of its
+    *  events and hands them back to the reader. A session taken over from
+    *  another parser first waits until the aggregator has applied what
+    *  that parser passed on for it, so its records stay in order. The
+    *  session goes back in the deque while it has events left; otherwise
+    *  it is idle until the reader queues it again.
+ * PARAMETERS:
+    *  Worker *worker : Calling parser.
+    *  int slot : Session to run.
+ * RETURNS : n/a
+ */
+void runTask(Worker *worker, int slot) {
+    SessionTask *task = &tasks[slot];
+    int          self = (int)(worker - workers);
+    int          last = atomic_load_explicit(&task->worker, memory_order_relaxed);
+    if (last != self) {
+        while (!stageQueueConsumed(&workers[last].output, task->mark)) {
+            sched_yield();
+        }
+        atomic_store_explicit(&task->worker, self, memory_order_relaxed);
+    }
+    countStat(&worker->stats.turns, 1);
+    countStat(&worker->stats.depthTotal, taskDequeDepth(&worker->deque));
+    
+    StageEvent **queued;
+    int          taken = 0;
+    for (; taken < PIPELINE_TURN_ITEMS && (queued = stageQueuePeek(&task->inbox)) != NULL; taken++) {
+        StageEvent *event = *queued;
+        stageQueueRelease(&task->inbox);
+        parseEvent(worker, task, event);
+        
+        StageEvent **recycled = stageQueueReserve(&worker->recycled, true);
+        *recycled = event;
+        stageQueuePublish(&worker->recycled);
+    }
+    countStat(&worker->stats.records, (uint64_t)taken);
+    task->mark = stageQueueMark(&worker->output);
+    
+    // The reader only queues the session again after it saw it unscheduled,
+    // so look at the inbox once more after giving the session up
+    if (!stageQueueReadable(&task->inbox)) {
+        atomic_store(&task->scheduled, false);
+        if (!stageQueueReadable(&task->inbox) || atomic_exchange(&task->scheduled, true)) {
+            return;
+        }
+    }
+    queueTask(worker, slot);
+}
+
+/*
+ * FUNCTION: parseEvent
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Parses one event of a session, writing the results straight into the
+    *  parser's output queue; other events are passed on as they are. A
+    *  closed session's parser is reset for the slot's next session.
+ * PARAMETERS:
+    *  Worker *worker : Calling parser.
+    *  SessionTask *task : Session the event belongs to.
+    *  const StageEvent *event : Event to parse.
+ * RETURNS : n/a
+ */
+void parseEvent(Worker *worker, SessionTask *task, const StageEvent *event) {
+    StageResult *result = stageQueueReserve(&worker->output, true);
+    if (event->header.kind == STAGE_RECORD) {
+        RecordView record = { .data = event->data, .length = event->length, .type = event->type };
+        parserFeed(&task->parser, &record);
+        while (parserNext(&task->parser, &result->parsed)) {
+            if (result->parsed.rejected) {
+                metricsCount(&worker->metrics, METRICS_PARSE_ERRORS, 1);
+            }
+            result->header = event->header;
+            stageQueuePublish(&worker->output);
+            result = stageQueueReserve(&worker->output, true);
+        }
+    } else {
+        result->header = event->header;
+        stageQueuePublish(&worker->output);
+        if (event->header.kind == STAGE_CLOSE) {
+            parserFree(&task->parser);
+        }
+    }
+}
+
+/*
+ * FUNCTION: countStat
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Adds to a counter only the calling thread writes, without a locked instruction.
+ * PARAMETERS:
+    *  atomic_uint_fast64_t *counter : Counter to add to.
+    *  uint64_t amount : Amount to add.
+ * RETURNS : n/a
+ */
+void countStat(atomic_uint_fast64_t *counter, uint64_t amount) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + amount,
+                          memory_order_relaxed);
+}
+
+/*
+ * FUNCTION: elapsedNanos
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Measures the time since a CLOCK_MONOTONIC reading.
+ * PARAMETERS:
+    *  const struct timespec *since : Earlier reading.
+ * RETURNS : uint64_t - nanoseconds since then.
+ */
+uint64_t elapsedNanos(const struct timespec *since) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - since->tv_sec) * 1000000000u + (uint64_t)now.tv_nsec - (uint64_t)since->tv_nsec;
+}
+
+/*
+ * FUNCTION: runAggregator
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Aggregator thread, the only one touching the party state, the
+    *  statistics and the journal. It takes the parsers' results in turns,
+    *  so no parser starves the others, and commits the journal and sends
+    *  the acknowledgements once every queue is empty or
+    *  PIPELINE_PASS_ITEMS results were applied. Under load one fdatasync
+    *  thus covers many records.
+    *
+    *  A pass never ends inside a record. The frames of a WIRE_BATCH are
+    *  applied one by one before the counted result of the chunk that
+    *  completed it, and its progress only moves past the batch with that
+    *  result; a commit in between would make half a party durable, which
+    *  the client then sends again in full after a restart. The results of
+    *  one record are contiguous in its parser's queue, and the parser is
+    *  still writing them, so the pass waits for the rest of any record it
+    *  has started before committing.
+ * PARAMETERS:
+    *  void *context : Logger to write to.
+ * RETURNS : void * - NULL once the parsers have exited and their results are applied.
+ */
+void *runAggregator(void *context) {
+    Logger  *logger = context;
+    uint64_t readTimes[PIPELINE_PASS_ITEMS + MAX_WORKERS];   // Of the records applied in the pass
+    bool     inRecord[MAX_WORKERS] = {false};                 // The last result taken did not end its record
+    for (;;) {
+        bool stopping = atomic_load(&aggregatorStopping);
+        int  applied  = 0;
+        int  timed    = 0;
+        bool drained  = false;
+        while (!drained && applied < PIPELINE_PASS_ITEMS) {
+            drained = true;
+            for (int i = 0; i < workerCount; i++) {
+                StageResult *result;
+                for (int taken = 0; taken < PIPELINE_TURN_ITEMS && applied < PIPELINE_PASS_ITEMS
+                                    && (result = stageQueuePeek(&workers[i].output)) != NULL; taken++) {
+                    handleResult(logger, result);
+                    inRecord[i] = result->header.kind == STAGE_RECORD && !result->parsed.counted;
+                    if (result->header.kind == STAGE_RECORD && result->parsed.counted) {
+                        readTimes[timed++] = result->header.readTime;
+                    }
+                    stageQueueRelease(&workers[i].output);
+                    drained = false;
+                    applied++;
+                }
+            }
+        }
+        
+        // Finish every record the pass started, so no batch is committed in part
+        for (int i = 0; i < workerCount; i++) {
+            while (inRecord[i]) {
+                StageResult *result = stageQueuePeek(&workers[i].output);
+                if (!result) {
+                    sched_yield();   // The parser is still writing the record's results
+                    continue;
+                }
+                handleResult(logger, result);
+                inRecord[i] = !result->parsed.counted;
+                if (result->parsed.counted) {
+                    readTimes[timed++] = result->header.readTime;
+                }
+                stageQueueRelease(&workers[i].output);
+                drained = false;
+            }
+        }
+        
+        // Group commit: one fdatasync covers every record of the pass, and
+        // only then are the records acknowledged
+        if (commitJournal(logger) == SUCCESS) {
+            sendAcknowledgements();
+        }
+        consoleFlush(&console);
+        if (timed > 0) {
+            uint64_t now = metricsNow();
+            for (int i = 0; i < timed; i++) {
+                metricsRecordLatency(&aggregatorMetrics, now - readTimes[i]);
+            }
+        }
+        if (drained) {
+            if (stopping) {
+                return NULL;
+            }
+            stageSignalWait(&aggregatorSignal, aggregatorReady, NULL);
+        }
+    }
+}
+
+/*
+ * FUNCTION: aggregatorReady
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: StageReady for the aggregator: true once any parser has passed something on or the parsers have exited.
+ * PARAMETERS:
+    *  void *context : Unused.
+ * RETURNS : bool - true if the aggregator has something to do.
+ */
+bool aggregatorReady(void *context) {
+    (void)context;
+    if (atomic_load(&aggregatorStopping)) {
+        return true;
+    }
+    for (int i = 0; i < workerCount; i++) {
+        if (stageQueueReadable(&workers[i].output)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * FUNCTION: handleResult
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Applies one item from a parser to the party state. Once a client has
+    *  stopped the server, records are no longer applied; sessions still
+    *  open and close so their descriptors and parties are accounted for.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  const StageResult *result : Item to apply.
+ * RETURNS : n/a
+ */
+void handleResult(Logger *logger, const StageResult *result) {
+    const StageHeader *header  = &result->header;
+    PartyState        *state   = &parties[header->slot];
+    bool               stopped = atomic_load_explicit(&stopRequested, memory_order_relaxed);
+    
+    switch (header->kind) {
+        case STAGE_OPEN:
+            openParty(logger, state, header);
+            break;
+        case STAGE_RECORD:
+            if (!stopped && state->inUse) {
+                handleParsedRecord(logger, state, &result->parsed);
+            }
+            break;
+        case STAGE_DISCARDED:
+            // Records the framer dropped still count, keeping the client's numbering
+            if (!stopped && state->inUse) {
+                state->records  += header->count;
+                state->rejected += header->count;
+                if (!state->inBatch) {
+                    state->complete = state->records;
+                }
+                queueAcknowledgement(state);
+            }
+            break;
+        case STAGE_QUERY:
+        case STAGE_METRICS:
+            if (!stopped) {
+                answerQuery(logger, header->pid, header->fd, header->kind == STAGE_METRICS);
+            } else {
+                close(header->fd);
+            }
+            break;
+        case STAGE_CLOSE:
+            if (state->inUse) {
+                closeParty(logger, state);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * FUNCTION: handleParsedRecord
+ * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca & Tuan Thanh Nguyen
+ * DESCRIPTION:
+    *  Handles one parsed record of a session: echoes and logs it, updates
+    *  the party state, and counts the record for its acknowledgement. The
+    *  echo is "Received: ..." for --output pretty and a pid=... record=...
+    *  line for compact.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  PartyState *state : Party state of the session.
+    *  const ParsedRecord *parsed : Record from the session's parser.
+ * RETURNS : n/a
+ */
+void handleParsedRecord(Logger *logger, PartyState *state, const ParsedRecord *parsed) {
+    if (parsed->line[0] != '\0') {
+        if (consoleMode == CONSOLE_PRETTY && parsed->echo) {
+            consoleFormat(&console, "Received: %s\n", parsed->line);
+        } else if (consoleMode == CONSOLE_COMPACT) {
+            consoleFormat(&console, "pid=%ld record=%s line=", state->pid, recordName(parsed));
+            consoleQuote(&console, parsed->line);
+            consoleFormat(&console, "\n");
+        }
+        writeToLog(logger, parsed->line);
+    }
+    if (parsed->rejected) {
+        state->rejected++;
+    }
+    
+    switch (parsed->kind) {
+        case PARSED_PARTY:
+            startParty(state);
+            break;
+        case PARSED_STOP:
+            stopServer(logger);
+            break;
+        case PARSED_END:
+            endParty(logger, state);
+            break;
+        case PARSED_DESTINATION:
+            if (state->inParty) {
+                setPartyDestination(state, parsed->line, parsed->destinationLength);
+            } else {
+                state->rejected++;
+            }
+            break;
+        case PARSED_CLIENT:
+            if (state->inParty) {
+                addPartyClient(state, &parsed->client);
+            } else {
+                state->rejected++;
+            }
+            break;
+        case PARSED_QUERY:
+        case PARSED_METRICS:
+            answerQuery(logger, parsed->pid, -1, parsed->kind == PARSED_METRICS);
+            break;
+        case PARSED_TEXT:
+            handleTextLine(logger, state, parsed);
+            break;
+        default:
+            break;
+    }
+    
+    // Frames of a batch are counted with the chunk that completed it
+    if (parsed->counted) {
+        state->records++;
+        if (parsed->batch != PARSED_BATCH_SAME) {
+            state->inBatch = parsed->batch == PARSED_BATCH_OPEN;
+        }
+        if (!state->inBatch) {
+            state->complete = state->records;
+        }
+        queueAcknowledgement(state);
+    }
+}
+
+/*
+ * FUNCTION: handleTextLine
+ * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca & Tuan Thanh Nguyen
+ * DESCRIPTION: Applies a text line that is not a command, according to where the party is.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  PartyState *state : Party state of the session.
+    *  const ParsedRecord *parsed : PARSED_TEXT record.
+ * RETURNS : n/a
+ */
+void handleTextLine(Logger *logger, PartyState *state, const ParsedRecord *parsed) {
+    if (state->inParty && state->batch.destinationId == PARTY_NO_DESTINATION) {
+        // First message after "party" should be destination
+        setPartyDestination(state, parsed->line, parsed->destinationLength);
+    }
+    else if (parsed->text == PARSED_TEXT_PROMPT) {
+        if (consoleMode == CONSOLE_PRETTY) {
+            consoleFormat(&console, "New client being added...\n");
+        }
+    }
+    else if (parsed->text == PARSED_TEXT_END) {
+        endParty(logger, state);
+    }
+    else if (state->inParty && parsed->text == PARSED_TEXT_CLIENT) {
+        addPartyClient(state, &parsed->client);
+    }
+    else {
+        state->rejected++;   // Not part of any party, or client data that does not validate
+    }
+}
+
+/*
+ * FUNCTION: recordName
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Names what a parsed record is, for the record= field of --output compact.
+ * PARAMETERS:
+    *  const ParsedRecord *parsed : Record from a session's parser.
+ * RETURNS : const char * - static name.
+ */
+const char *recordName(const ParsedRecord *parsed) {
+    if (parsed->rejected) {
+        return "rejected";
+    }
+    switch (parsed->kind) {
+        case PARSED_PARTY:       return "party";
+        case PARSED_DESTINATION: return "destination";
+        case PARSED_CLIENT:      return "client";
+        case PARSED_END:         return "end";
+        case PARSED_STOP:        return "stop";
+        case PARSED_QUERY:       return "query";
+        case PARSED_METRICS:     return "metrics";
+        case PARSED_TEXT:
+            switch (parsed->text) {
+                case PARSED_TEXT_PROMPT: return "prompt";
+                case PARSED_TEXT_END:    return "end";
+                case PARSED_TEXT_CLIENT: return "client";
+                default:                 return "text";
+            }
+        default:
+            return "other";
+    }
+}
+
+/*
+ * FUNCTION: openParty
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Starts the party state of a session whose client is known and announces the client.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  PartyState *state : Free party state of the session's slot.
+    *  const StageHeader *header : STAGE_OPEN event.
+ * RETURNS : n/a
+ */
+void openParty(Logger *logger, PartyState *state, const StageHeader *header) {
+    char message[SUMMARY_SIZE];
+    
+    if (header->pid > 0) {
+        if (consoleMode == CONSOLE_PRETTY) {
+            consoleFormat(&console, "Client %ld connected.\n", header->pid);
+        } else if (consoleMode == CONSOLE_COMPACT) {
+            consoleFormat(&console, "pid=%ld event=connected\n", header->pid);
+        }
+        snprintf(message, sizeof(message), "Client session %ld opened%s%s", header->pid,
+                 header->connection ? " over a socket" : header->ring ? " over shared memory" : "",
+                 header->fd == -1 ? " without acknowledgements" : "");
+        writeToLog(logger, message);
+    }
+    memset(state, 0, sizeof(*state));
+    state->inUse      = true;
+    state->connection = header->connection;
+    state->replyFd    = header->fd;
+    state->pid        = header->pid;
+    partyBatchReset(&state->batch);
+    resumeParty(logger, state, header->resume);
+}
+
+/*
+ * FUNCTION: resumeParty
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Continues a session its client lost in a server restart, or discards
+    *  the recovered state of the pid if the client starts over. A resumed
+    *  session takes back its party and record count, and is acknowledged
+    *  straight away so the client knows which records to send again.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  PartyState *state : Newly opened party state.
+    *  uint64_t resume : Records the client saw acknowledged, or WIRE_NEW_SESSION.
+ * RETURNS : n/a
+ */
+void resumeParty(Logger *logger, PartyState *state, uint64_t resume) {
+    char              message[SUMMARY_SIZE];
+    RecoveredSession *recovered = findRecoveredSession(state->pid, false);
+    
+    // A client starting over drops whatever its pid left behind
+    if (resume == WIRE_NEW_SESSION) {
+        if (recovered) {
+            journalRecord(JOURNAL_CLOSE, state->pid, NULL, 0);
+            releaseRecoveredSession(recovered);
+        }
+        return;
+    }
+    
+    // Without a journal the client's count is all there is to go on
+    uint64_t records = resume;
+    if (recovered) {
+        records = recovered->records > resume ? recovered->records : resume;
+        if (recovered->inParty) {
+            partyBatchFree(&state->batch);
+            state->batch   = recovered->batch;
+            state->inParty = true;
+            memset(&recovered->batch, 0, sizeof(recovered->batch));
+        }
+        releaseRecoveredSession(recovered);
+    }
+    state->records      = records;
+    state->complete     = records;
+    state->journaled    = records;
+    state->acknowledged = WIRE_NEW_SESSION;   // Answer the resume even if nothing was kept
+    queueAcknowledgement(state);
+    
+    if (state->inParty) {
+        snprintf(message, sizeof(message),
+                 "Resumed session %ld after %lu records - Destination: %s, Clients: %d",
+                 state->pid, (unsigned long)records,
+                 destinationName(&destinations, state->batch.destinationId),
+                 state->batch.count);
+    } else {
+        snprintf(message, sizeof(message), "Resumed session %ld after %lu records",
+                 state->pid, (unsigned long)records);
+    }
+    if (state->pid > 0 || state->inParty) {
+        if (consoleMode == CONSOLE_PRETTY) {
+            consoleFormat(&console, "%s\n", message);
+        } else if (consoleMode == CONSOLE_COMPACT) {
+            consoleFormat(&console, "pid=%ld event=resumed records=%lu clients=%d\n", state->pid,
+                          (unsigned long)records, state->inParty ? state->batch.count : 0);
+        }
+        writeToLog(logger, message);
+    }
+}
+
+/*
+ * FUNCTION: closeParty
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Closes the party state of a session whose stream is gone and logs a
+    *  party that was left unfinished. Closing the reply descriptor tells
+    *  the client no more acknowledgements come.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  PartyState *state : Party state to close.
+ * RETURNS : n/a
+ */
+void closeParty(Logger *logger, PartyState *state) {
+    char message[SUMMARY_SIZE];
+    
+    journalRecord(JOURNAL_CLOSE, state->pid, NULL, 0);
+    if (state->inParty) {
+        snprintf(message, sizeof(message), "Party abandoned - Destination: %s, Clients: %d",
+                 destinationName(&destinations, state->batch.destinationId), state->batch.count);
+        writeToLog(logger, message);
+    }
+    if (state->pid > 0) {
+        if (consoleMode == CONSOLE_PRETTY) {
+            consoleFormat(&console, "Client %ld disconnected.\n", state->pid);
+        } else if (consoleMode == CONSOLE_COMPACT) {
+            consoleFormat(&console, "pid=%ld event=disconnected\n", state->pid);
+        }
+        snprintf(message, sizeof(message), "Client session %ld closed", state->pid);
+        writeToLog(logger, message);
+    }
+    if (state->replyFd != -1) {
+        close(state->replyFd);   // The client reads EOF
+    }
+    partyBatchFree(&state->batch);
+    memset(state, 0, sizeof(*state));
+}
+
+/*
+ * FUNCTION: answerQuery
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Answers a WIRE_QUERY with a snapshot of the destination statistics,
+    *  or a WIRE_METRICS with the runtime metrics. The reader thread sends
+    *  it, so a slow client never stalls the aggregator; if PIPELINE_REPLIES
+    *  snapshots are already waiting for the reader the query is rejected.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  long pid : Client waiting on its reply FIFO.
+    *  int connectionFd : Descriptor of the query's connection, taken over; -1 for the FIFO.
+    *  bool metrics : Answer with formatMetrics() instead of the destination statistics.
+ * RETURNS : n/a
+ */
+void answerQuery(Logger *logger, long pid, int connectionFd, bool metrics) {
+    size_t      length;
+    char       *data  = metrics ? formatMetrics(logger, &length)
+                                : aggregateSnapshot(&destinationStats, &destinations, &length);
+    StageReply *reply = data ? stageQueueReserve(&replyQueue, false) : NULL;
+    if (!reply) {
+        writeToLog(logger, data ? "Rejected query - too many pending replies"
+                                : "Could not build the statistics snapshot");
+        free(data);
+        if (connectionFd != -1) {
+            close(connectionFd);
+        }
+        return;
+    }
+    reply->pid    = pid;
+    reply->fd     = connectionFd;
+    reply->data   = data;
+    reply->length = length;
+    stageQueuePublish(&replyQueue);
+    wakeReader();
+}
+
+/*
+ * FUNCTION: formatMetrics
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Formats the metrics of every pipeline thread, plus gauges of the
+    *  server's backlog, for a WIRE_METRICS reply. Runs on the aggregator,
+    *  which owns the party state counted here; the shards and queue
+    *  depths are atomics any thread may read.
+ * PARAMETERS:
+    *  Logger *logger : Logger whose queue depth is reported.
+    *  size_t *length : Receives the text length.
+ * RETURNS : char * - malloc'd Prometheus text for the caller to free, or NULL if memory ran out.
+ */
+char *formatMetrics(Logger *logger, size_t *length) {
+    MetricsShard *shards[MAX_WORKERS + 2] = { &readerMetrics, &aggregatorMetrics };
+    int           shardCount              = 2;
+    size_t        waiting                 = 0;
+    for (int i = 0; i < workerCount; i++) {
+        shards[shardCount++] = &workers[i].metrics;
+        waiting += taskDequeDepth(&workers[i].deque);
+    }
+    int sessionsOpen = 0;
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        sessionsOpen += parties[i].inUse && parties[i].pid != 0;   // Not the shared FIFO
+    }
+    LoggerStats logStats = loggerGetStats(logger);
+    
+    const MetricsGauge gauges[] = {
+        {"sessions_open", "Client sessions with a party state, not counting the shared FIFO.", (double)sessionsOpen, false},
+        {"parser_threads", "Parser threads in the pipeline.", (double)workerCount, false},
+        {"parser_backlog_sessions", "Sessions waiting for a parser thread.", (double)waiting, false},
+        {"log_queue_depth", "Log messages waiting for the writer thread.", (double)logStats.queueDepth, false},
+        {"log_messages_dropped_total", "Log messages dropped on a full queue.", (double)logStats.dropped, true},
+        {"uptime_seconds", "Time since the pipeline started.", (double)elapsedNanos(&pipelineStarted) / 1e9, false},
+    };
+    return metricsFormat(shards, shardCount, gauges, (int)(sizeof(gauges) / sizeof(gauges[0])), length);
+}
+
+/*
+ * FUNCTION: wakeReader
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Raises the pipeline eventfd so the reader's epoll loop picks up replies or a stop.
+ * PARAMETERS: n/a
+ * RETURNS : n/a
+ */
+void wakeReader(void) {
+    uint64_t wakeup = 1;
+    if (write(pipelineFd, &wakeup, sizeof(wakeup)) == -1 && errno != EAGAIN) {
+        perror("Error waking the event loop");
+    }
+}
+
+/*
+ * FUNCTION: receiveReplies
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Starts sending every snapshot the aggregator has built since the last wakeup.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+ * RETURNS : n/a
+ */
+void receiveReplies(Logger *logger) {
+    uint64_t wakeups;
+    if (read(pipelineFd, &wakeups, sizeof(wakeups)) == -1 && errno != EAGAIN) {
+        perror("Error reading the pipeline eventfd");
+    }
+    
+    StageReply *reply;
+    while ((reply = stageQueuePeek(&replyQueue)) != NULL) {
+        sendSnapshot(logger, reply->pid, reply->fd, reply->data, reply->length);
+        stageQueueRelease(&replyQueue);
+    }
+}
+
+/*
+ * FUNCTION: sendSnapshot
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Sends a statistics snapshot built by the aggregator to the client's
+    *  reply FIFO, or back on the socket connection the query came on. The
+    *  FIFO is opened and written without blocking; whatever does not fit
+    *  is finished from the event loop when the client has read some of it,
+    *  so a slow reader never stalls ingestion.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  long pid : Client waiting on its reply FIFO.
+    *  int connectionFd : Non-blocking descriptor of the query's connection, taken over; -1 for the FIFO.
+    *  char *data : Snapshot from aggregateSnapshot(), taken over.
+    *  size_t length : Snapshot bytes.
+ * RETURNS : n/a
+ */
+void sendSnapshot(Logger *logger, long pid, int connectionFd, char *data, size_t length) {
+    char path[MAX_FIFO_PATH_LEN];
+    char message[SUMMARY_SIZE];
+    
+    PendingReply *reply = NULL;
+    for (int i = 0; i < MAX_PENDING_REPLIES && !reply; i++) {
+        if (!pendingReplies[i].inUse) {
+            reply = &pendingReplies[i];
+        }
+    }
+    if (!reply) {
+        writeToLog(logger, "Rejected query - too many pending replies");
+        if (connectionFd != -1) {
+            close(connectionFd);
+        }
+        free(data);
+        return;
+    }
+    
+    // ENXIO here means the client is not reading its reply FIFO (yet or any more)
+    reply->fd        = connectionFd;
+    reply->halfClose = connectionFd != -1;
+    if (connectionFd == -1
+        && (replyFifoPath(path, sizeof(path), pid) == ERROR
+            || (reply->fd = open(path, O_WRONLY | O_NONBLOCK | O_CLOEXEC)) == -1)) {
+        snprintf(message, sizeof(message), "Could not open reply FIFO for client %ld", pid);
+        writeToLog(logger, message);
+        free(data);
+        return;
+    }
+    reply->inUse  = true;
+    reply->data   = data;
+    reply->length = length;
+    reply->sent   = 0;
+    
+    if (flushReply(reply)) {
+        closeReply(reply);
+        return;
+    }
+    struct epoll_event event = { .events = EPOLLOUT, .data.ptr = reply };
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, reply->fd, &event) == -1) {
+        writeToLog(logger, "Could not wait for a reply FIFO to drain");
+        closeReply(reply);
+    }
+}
+
+/*
+ * FUNCTION: flushReply
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Writes as much of a pending reply as its FIFO accepts without blocking.
+ * PARAMETERS:
+    *  PendingReply *reply : Reply to continue.
+ * RETURNS : bool - true once the reply is finished or the client went away, false if it must wait.
+ */
+bool flushReply(PendingReply *reply) {
+    while (reply->sent < reply->length) {
+        ssize_t written = write(reply->fd, reply->data + reply->sent, reply->length - reply->sent);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno != EAGAIN;   // EPIPE: the client stopped reading
+        }
+        reply->sent += (size_t)written;
+    }
+    return true;
+}
+
+/*
+ * FUNCTION: closeReply
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Closes a reply FIFO or connection (the client then reads EOF) and frees its snapshot.
+ * PARAMETERS:
+    *  PendingReply *reply : Reply to close; unused entries are ignored.
+ * RETURNS : n/a
+ */
+void closeReply(PendingReply *reply) {
+    if (!reply->inUse) {
+        return;
+    }
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, reply->fd, NULL);
+    if (reply->halfClose) {
+        shutdown(reply->fd, SHUT_WR);   // The session keeps the connection open
+    }
+    close(reply->fd);
+    free(reply->data);
+    memset(reply, 0, sizeof(*reply));
+}
+
+/*
+ * FUNCTION: recoverState
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Restores the destinations, their statistics and the sessions that were
+    *  open when the server last stopped: maps the latest snapshot, replays
+    *  the journal records committed after it, then opens the journal for new
+    *  records. Sessions of clients that have since exited are closed. Does
+    *  nothing with --no-journal.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+ * RETURNS : n/a
+ */
+void recoverState(Logger *logger) {
+    char            message[SUMMARY_SIZE];
+    struct timespec start;
+    struct timespec end;
+    uint64_t        sequence = 0;
+    
+    if (!journalEnabled) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    if (snapshotLoad(SNAPSHOT_PATH, &sequence, &destinations, &destinationStats,
+                     claimRecoveredSession, NULL) == ERROR) {
+        // Start from nothing rather than from half a snapshot
+        writeToLog(logger, "Snapshot is unreadable, recovering from the journal alone");
+        for (int i = 0; i < MAX_SESSIONS; i++) {
+            releaseRecoveredSession(&recoveredSessions[i]);
+        }
+        aggregateFree(&destinationStats);
+        destinationTableFree(&destinations);
+        sequence = 0;
+    }
+    
+    uint64_t lastSequence = sequence;
+    long     replayed     = journalReplay(JOURNAL_PATH, sequence, applyJournalRecord, NULL, &lastSequence);
+    if (replayed == ERROR) {
+        writeToLog(logger, "Journal is unreadable, its records were not replayed");
+        replayed = 0;
+    }
+    if (journalOpen(&journal, JOURNAL_PATH, lastSequence + 1) == ERROR) {
+        perror("Error opening the journal, party state will not survive a restart");
+        writeToLog(logger, "Journal could not be opened");
+        return;
+    }
+    journal.sinceSnapshot = (unsigned long)replayed;
+    
+    int openSessions = 0;
+    int inParty      = 0;
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        RecoveredSession *recovered = &recoveredSessions[i];
+        if (recovered->inUse && recovered->pid > 0 && kill((pid_t)recovered->pid, 0) == -1
+            && errno == ESRCH) {
+            journalRecord(JOURNAL_CLOSE, recovered->pid, NULL, 0);   // Nobody left to resume it
+            releaseRecoveredSession(recovered);
+        }
+        openSessions += recovered->inUse ? 1 : 0;
+        inParty      += recovered->inParty ? 1 : 0;
+    }
+    commitJournal(logger);
+    
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    snprintf(message, sizeof(message),
+             "Recovered %u destinations and %d open sessions (%d in a party), "
+             "%ld journal records replayed in %.1f ms",
+             destinations.count, openSessions, inParty, replayed,
+             (double)(end.tv_sec - start.tv_sec) * 1e3 + (double)(end.tv_nsec - start.tv_nsec) / 1e6);
+    printf("%s\n", message);
+    writeToLog(logger, message);
+}
+
+/*
+ * FUNCTION: applyJournalRecord
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Replays one journal record into the recovered state. Sessions are
+    *  rebuilt per pid; a completed party only updates the statistics.
+ * PARAMETERS:
+    *  void *context : Unused.
+    *  const JournalRecordHeader *header : Record header.
+    *  const char *payload : Record payload.
+ * RETURNS : n/a
+ */
+void applyJournalRecord(void *context, const JournalRecordHeader *header, const char *payload) {
+    (void)context;
+    RecoveredSession *recovered = findRecoveredSession((long)header->pid, header->type != JOURNAL_CLOSE);
+    if (!recovered) {
+        return;
+    }
+    
+    switch (header->type) {
+        case JOURNAL_PARTY:
+            recovered->inParty = true;
+            partyBatchReset(&recovered->batch);
+            break;
+        case JOURNAL_DEST:
+            if (recovered->inParty) {
+                recovered->batch.destinationId = destinationIntern(&destinations, payload, header->length);
+            }
+            break;
+        case JOURNAL_CLIENT: {
+            const char *cursor = payload;
+            const char *framePayload;
+            WireHeader  frame;
+            Client      client;
+            if (recovered->inParty
+                && wireNextFrame(&cursor, payload + header->length, &frame, &framePayload)
+                && frame.type == WIRE_CLIENT && wireDecodeClient(framePayload, frame.length, &client)
+                && partyBatchAdd(&recovered->batch, &client) == SUCCESS) {
+                aggregateAddClient(&destinationStats, recovered->batch.destinationId, client.age,
+                                   (time_t)header->time);
+            }
+            break;
+        }
+        case JOURNAL_END:
+            if (recovered->inParty) {
+                aggregateAddParty(&destinationStats, recovered->batch.destinationId, (time_t)header->time);
+                recovered->inParty = false;
+                partyBatchReset(&recovered->batch);
+            }
+            break;
+        case JOURNAL_PROGRESS:
+            if (header->length == sizeof(recovered->records)) {
+                memcpy(&recovered->records, payload, sizeof(recovered->records));
+            }
+            break;
+        case JOURNAL_CLOSE:
+            releaseRecoveredSession(recovered);
+            break;
+    }
+}
+
+/*
+ * FUNCTION: claimRecoveredSession
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: SnapshotClaim for snapshotLoad(): restores a session and returns the batch for its party.
+ * PARAMETERS:
+    *  void *context : Unused.
+    *  long pid : Client of the session.
+    *  uint64_t records : Records the session had acknowledged.
+    *  bool inParty : Whether a party was in progress.
+ * RETURNS : PartyBatch * - an empty batch, or NULL if every recovery slot is taken.
+ */
+PartyBatch *claimRecoveredSession(void *context, long pid, uint64_t records, bool inParty) {
+    (void)context;
+    RecoveredSession *recovered = findRecoveredSession(pid, true);
+    if (!recovered) {
+        return NULL;
+    }
+    recovered->records = records;
+    recovered->inParty = inParty;
+    partyBatchReset(&recovered->batch);
+    return &recovered->batch;
+}
+
+/*
+ * FUNCTION: findRecoveredSession
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Looks up the recovered session of a pid, optionally taking a free slot for it.
+ * PARAMETERS:
+    *  long pid : Client of the session.
+    *  bool create : Take a free slot if the pid has none.
+ * RETURNS : RecoveredSession * - the session, or NULL if there is none (or no free slot).
+ */
+RecoveredSession *findRecoveredSession(long pid, bool create) {
+    RecoveredSession *freeSlot = NULL;
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        if (recoveredSessions[i].inUse && recoveredSessions[i].pid == pid) {
+            return &recoveredSessions[i];
+        }
+        if (!recoveredSessions[i].inUse && !freeSlot) {
+            freeSlot = &recoveredSessions[i];
+        }
+    }
+    if (!create || !freeSlot) {
+        return NULL;
+    }
+    freeSlot->inUse = true;
+    freeSlot->pid   = pid;
+    partyBatchReset(&freeSlot->batch);
+    return freeSlot;
+}
+
+/*
+ * FUNCTION: releaseRecoveredSession
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Frees a recovered session's slot and party storage.
+ * PARAMETERS:
+    *  RecoveredSession *recovered : Slot to release; unused slots are ignored.
+ * RETURNS : n/a
+ */
+void releaseRecoveredSession(RecoveredSession *recovered) {
+    if (recovered->inUse) {
+        partyBatchFree(&recovered->batch);
+        memset(recovered, 0, sizeof(*recovered));
+    }
+}
+
+/*
+ * FUNCTION: journalRecord
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Appends a session change to the journal; it becomes durable at the next commitJournal().
+ * PARAMETERS:
+    *  JournalRecordType type : Kind of change.
+    *  long pid : Session the change belongs to.
+    *  const void *payload : Record payload, NULL when length is 0.
+    *  size_t length : Payload bytes.
+ * RETURNS : n/a
+ */
+void journalRecord(JournalRecordType type, long pid, const void *payload, size_t length) {
+    if (journalAppend(&journal, type, pid, payload, length) == ERROR) {
+        perror("Error writing to the journal");
+    }
+}
+
+/*
+ * FUNCTION: commitJournal
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Records how far each session of the last aggregator pass got, makes
+    *  the pass durable with one fdatasync, and writes a snapshot once
+    *  JOURNAL_SNAPSHOT_RECORDS records have built up so the journal to
+    *  replay stays short.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+ * RETURNS : int - SUCCESS, or ERROR if the records could not be made durable.
+ */
+int commitJournal(Logger *logger) {
+    for (int i = 0; i < ackQueueLength; i++) {
+        PartyState *state = ackQueue[i];
+        if (state->inUse && state->pid > 0 && state->complete != state->journaled) {
+            journalRecord(JOURNAL_PROGRESS, state->pid, &state->complete, sizeof(state->complete));
+            state->journaled = state->complete;
+        }
+    }
+    
+    if (journalCommit(&journal) == ERROR) {
+        perror("Error syncing the journal");
+        writeToLog(logger, "Journal commit failed, records are not acknowledged");
+        return ERROR;
+    }
+    if (journal.sinceSnapshot >= JOURNAL_SNAPSHOT_RECORDS) {
+        writeSnapshot(logger);
+    }
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: writeSnapshot
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Saves the current state (destinations, statistics, every open client
+    *  session and every recovered one still waiting to be resumed) and
+    *  empties the journal it covers.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+ * RETURNS : n/a
+ */
+void writeSnapshot(Logger *logger) {
+    static SnapshotSession saved[MAX_SESSIONS * 2];
+    size_t                 savedCount = 0;
+    
+    if (journal.fd == -1 || journalCommit(&journal) == ERROR) {
+        return;
+    }
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        const PartyState *state = &parties[i];
+        if (state->inUse && (state->pid > 0 || state->inParty)) {
+            saved[savedCount++] = (SnapshotSession){
+                state->pid, state->journaled, state->inParty ? &state->batch : NULL
+            };
+        }
+        const RecoveredSession *recovered = &recoveredSessions[i];
+        if (recovered->inUse) {
+            saved[savedCount++] = (SnapshotSession){
+                recovered->pid, recovered->records, recovered->inParty ? &recovered->batch : NULL
+            };
+        }
+    }
+    
+    if (snapshotWrite(SNAPSHOT_PATH, journal.nextSequence - 1, &destinations, &destinationStats,
+                      saved, savedCount) == ERROR
+        || journalTruncate(&journal) == ERROR) {
+        perror("Error writing the state snapshot");
+        writeToLog(logger, "Snapshot failed, the journal is kept");
+    }
+}
+
+/*
+ * FUNCTION: queueAcknowledgement
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Marks a party to be acknowledged when the current aggregator pass is committed.
+ * PARAMETERS:
+    *  PartyState *state : Party of a session that read records.
+ * RETURNS : n/a
+ */
+void queueAcknowledgement(PartyState *state) {
+    if (!state->ackQueued && ackQueueLength < (int)(sizeof(ackQueue) / sizeof(ackQueue[0]))) {
+        state->ackQueued           = true;
+        ackQueue[ackQueueLength++] = state;
+    }
+}
+
+/*
+ * FUNCTION: sendAcknowledgements
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Writes a WIRE_ACK to the reply FIFO of every session that read records
+    *  in the committed pass. The write never blocks: a client reads its
+    *  acknowledgements before it has ACK_WINDOW_SIZE records in flight, so
+    *  far fewer than a pipe's worth are ever waiting. A client that went
+    *  away only loses its reply FIFO.
+ * PARAMETERS: n/a
+ * RETURNS : n/a
+ */
+void sendAcknowledgements(void) {
+    for (int i = 0; i < ackQueueLength; i++) {
+        PartyState *state = ackQueue[i];
+        if (!state->inUse || !state->ackQueued) {
+            continue;   // Closed (or reused and already handled) in this pass
+        }
+        state->ackQueued = false;
+        if (state->replyFd == -1 || state->complete == state->acknowledged) {
+            continue;
+        }
+        
+        char    frame[WIRE_HEADER_SIZE + sizeof(WireAck)];
+        WireAck ack    = { .records = state->complete, .rejected = state->rejected };
+        size_t  length = wireEncodeAck(frame, sizeof(frame), &ack);
+        ssize_t written;
+        do {
+            written = write(state->replyFd, frame, length);
+        } while (written == -1 && errno == EINTR);
+        
+        if (written == (ssize_t)length) {
+            state->acknowledged = ack.records;
+        } else if (written != -1 || errno != EAGAIN) {
+            // EPIPE: the client stopped reading. A socket may also take part
+            // of the frame, after which the acknowledgement stream is broken.
+            if (state->connection) {
+                shutdown(state->replyFd, SHUT_WR);
+            }
+            close(state->replyFd);
+            state->replyFd = -1;
+        }
+    }
+    ackQueueLength = 0;
+}
+
+/*
+ * FUNCTION: startParty
+ * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca & Tuan Thanh Nguyen
+ * DESCRIPTION: Starts a new party, clearing the previous destination and client count.
+ * PARAMETERS:
+    *  PartyState *state : Party state to reset.
+ * RETURNS : n/a
+ */
+void startParty(PartyState *state) {
+    state->inParty = true;
+    partyBatchReset(&state->batch);
+    journalRecord(JOURNAL_PARTY, state->pid, NULL, 0);
+    if (consoleMode == CONSOLE_PRETTY) {
+        consoleFormat(&console, "New party started\n");
+    }
+}
+
+/*
+ * FUNCTION: setPartyDestination
+ * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca & Tuan Thanh Nguyen
+ * DESCRIPTION: Stores the destination of the current party, truncating if needed.
+ * PARAMETERS:
+    *  PartyState *state : Party state to update.
+    *  const char *destination : Destination bytes (need not be null-terminated).
+    *  size_t length : Number of destination bytes.
+ * RETURNS : n/a
+ */
+void setPartyDestination(PartyState *state, const char *destination, size_t length) {
+    if (length > MAX_DESTINATION_LEN - 1) {
+        length = MAX_DESTINATION_LEN - 1;
+    }
+    state->batch.destinationId = destinationIntern(&destinations, destination, length);
+    if (state->batch.destinationId == PARTY_NO_DESTINATION) {
+        fprintf(stderr, "Out of memory storing the destination of a party\n");
+        return;
+    }
+    journalRecord(JOURNAL_DEST, state->pid, destination, length);
+    if (consoleMode == CONSOLE_PRETTY) {
+        consoleFormat(&console, "Party destination: %s\n",
+                      destinationName(&destinations, state->batch.destinationId));
+    }
+}
+
+/*
+ * FUNCTION: addPartyClient
+ * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca & Tuan Thanh Nguyen
+ * DESCRIPTION: Adds a client to the current party and displays its details.
+ * PARAMETERS:
+    *  PartyState *state : Party state to update.
+    *  const Client *client : Parsed client record.
+ * RETURNS : n/a
+ */
+void addPartyClient(PartyState *state, const Client *client) {
+    if (partyBatchAdd(&state->batch, client) == ERROR) {
+        fprintf(stderr, "Out of memory storing a client of the party to %s\n",
+                destinationName(&destinations, state->batch.destinationId));
+        return;
+    }
+    aggregateAddClient(&destinationStats, state->batch.destinationId, client->age, time(NULL));
+    metricsCount(&aggregatorMetrics, METRICS_CLIENTS, 1);
+    
+    char   frame[WIRE_MAX_CLIENT_FRAME];
+    size_t frameLength = wireEncodeClient(frame, sizeof(frame), client);
+    journalRecord(JOURNAL_CLIENT, state->pid, frame, frameLength);
+    if (consoleMode == CONSOLE_PRETTY) {
+        consoleFormat(&console, "\n-----------------------------\n"
+                      "Client %d\n"
+                      "Name    : %s %s\n"
+                      "Age     : %d\n"
+                      "Address : %s\n"
+                      "-----------------------------\n\n",
+                      state->batch.count, client->firstName, client->lastName, client->age,
+                      client->address);
+    }
+}
+
+/*
+ * FUNCTION: endParty
+ * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca & Tuan Thanh Nguyen
+ * DESCRIPTION: Prints and logs the summary of the current party and closes it.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  PartyState *state : Party state to close.
+ * RETURNS : n/a
+ */
+void endParty(Logger *logger, PartyState *state) {
+    if (state->inParty) {
+        const char *destination = destinationName(&destinations, state->batch.destinationId);
+        AgeStats    ages        = partyBatchAgeStats(&state->batch);
+        if (consoleMode == CONSOLE_PRETTY) {
+            consoleFormat(&console, "=== PARTY SUMMARY ===\nDestination: %s\nNumber of clients: %d\n",
+                          destination, state->batch.count);
+            if (state->batch.count > 0) {
+                consoleFormat(&console, "Ages: %d-%d, average %.1f\n", ages.min, ages.max, ages.mean);
+            }
+            consoleFormat(&console, "====================\n\n");
+        } else if (consoleMode == CONSOLE_COMPACT) {
+            consoleFormat(&console, "pid=%ld event=party_end destination=", state->pid);
+            consoleQuote(&console, destination);
+            consoleFormat(&console, " clients=%d\n", state->batch.count);
+        }
+        
+        char summary[SUMMARY_SIZE]; // Tuan Thanh Nguyen
+        snprintf(summary, sizeof(summary), "Party completed - Destination: %s, Clients: %d", 
+                destination, state->batch.count);
+        writeToLog(logger, summary);
+        aggregateAddParty(&destinationStats, state->batch.destinationId, time(NULL));
+        metricsCount(&aggregatorMetrics, METRICS_PARTIES, 1);
+        journalRecord(JOURNAL_END, state->pid, NULL, 0);
+    }
+    state->inParty = false;
+    partyBatchReset(&state->batch);
+}
+
+/*
+ * FUNCTION: stopServer
+ * PROGRAMMER: Tyler Gee, Cy Iver Torrefranca & Tuan Thanh Nguyen
+ * DESCRIPTION: Handles the stop command by telling the reader to end the message loop.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+ * RETURNS : n/a
+ */
+void stopServer(Logger *logger) {
+    consoleFormat(&console, "Stop command received. Shutting down server.\n");
+    writeToLog(logger, "Server received stop command");
+    atomic_store(&stopRequested, true);
+    wakeReader();
+}
+
+/*
+
+ * FUNCTION: writeToLog
+ * PROGRAMMER: Cy Iver Torrefranca & Tuan Thanh Nguyen
+ * DESCRIPTION:
+    *  Writes a message to the log file with a timestamp. The message is
+    *  queued for the logger's writer thread, which adds the timestamp and
+    *  appends it to the file in batches, so this never waits on disk I/O.
+ * PARAMETERS:
+    *  Logger *logger : Logger to write to.
+    *  const char *message : Message to log.
+ * RETURNS : n/a
+
+ */
+void writeToLog(Logger *logger, const char *message) {
+    if (logger) {
+        loggerLog(logger, message);
+    }
+}
@@ -0,0 +1,323 @@
+/*
+ * FILE: shmring.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Shared memory record ring between one client (producer) and the server
+ * (consumer). The client copies a record into the slot at head and
+ * publishes it by advancing head; the server reads the slot at tail and
+ * frees it by advancing tail. Each side only writes its own index, so no
+ * locks are needed. Sleeping is negotiated through a flag per side: a side
+ * sets its flag before its final check of the other index, and the other
+ * side checks the flag after moving its index, so one of them always sees
+ * the other (both use sequentially consistent operations).
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "shared.h"
+#include "shmring.h"
+
+#define SHM_RING_MAX_NAME 64
+#define NANOS_PER_MS      1000000L
+#define NANOS_PER_SECOND  1000000000L
+
+_Static_assert((SHM_RING_SLOTS & (SHM_RING_SLOTS - 1)) == 0, "ring slots must be a power of two");
+
+static int  shmRingName(char *out, size_t outSize, long pid);
+static bool shmRingWaitForSlot(ShmRingShared *shared, unsigned head, int timeoutMs);
+
+/*
+ * FUNCTION: shmRingCreate
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Creates and maps an empty ring for the session of pid. A segment left
+    *  behind by an earlier process with the same pid is replaced.
+ * PARAMETERS:
+    *  ShmRing *ring : Ring to set up, owned by the caller.
+    *  long pid : Client pid, names the segment.
+ * RETURNS : int - SUCCESS, or ERROR if the segment could not be created.
+ */
+int shmRingCreate(ShmRing *ring, long pid) {
+    char name[SHM_RING_MAX_NAME];
+    memset(ring, 0, sizeof(*ring));
+    if (shmRingName(name, sizeof(name), pid) == ERROR) {
+        return ERROR;
+    }
+
+    shm_unlink(name);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, PERM_OWNER_RW);
+    if (fd == -1) {
+        return ERROR;
+    }
+    ShmRingShared *shared = MAP_FAILED;
+    if (ftruncate(fd, sizeof(ShmRingShared)) == SUCCESS) {
+        shared = mmap(NULL, sizeof(ShmRingShared), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (shared == MAP_FAILED) {
+        shm_unlink(name);
+        return ERROR;
+    }
+
+    shared->slotCount = SHM_RING_SLOTS;
+    shared->slotSize  = SHM_RING_SLOT_SIZE;
+    atomic_store(&shared->head, 0);
+    atomic_store(&shared->tail, 0);
+    atomic_store(&shared->consumerSleeping, 1);   // The server waits in epoll until the first doorbell
+    atomic_store(&shared->producerSleeping, 0);
+    shared->magic = SHM_RING_MAGIC;   // Written last, the server checks it
+    ring->shared  = shared;
+    ring->owner   = true;
+    ring->pid     = pid;
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: shmRingAttach
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Maps the ring a client created for its session.
+ * PARAMETERS:
+    *  ShmRing *ring : Ring to set up.
+    *  long pid : Client pid from its HELLO message.
+ * RETURNS : int - SUCCESS, or ERROR if the segment is missing or not a ring of this build.
+ */
+int shmRingAttach(ShmRing *ring, long pid) {
+    char        name[SHM_RING_MAX_NAME];
+    struct stat info;
+    memset(ring, 0, sizeof(*ring));
+    if (shmRingName(name, sizeof(name), pid) == ERROR) {
+        return ERROR;
+    }
+
+    int fd = shm_open(name, O_RDWR | O_CLOEXEC, 0);
+    if (fd == -1) {
+        return ERROR;
+    }
+    ShmRingShared *shared = MAP_FAILED;
+    if (fstat(fd, &info) == SUCCESS && (size_t)info.st_size == sizeof(ShmRingShared)) {
+        shared = mmap(NULL, sizeof(ShmRingShared), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (shared == MAP_FAILED) {
+        return ERROR;
+    }
+    if (shared->magic != SHM_RING_MAGIC || shared->slotCount != SHM_RING_SLOTS
+        || shared->slotSize != SHM_RING_SLOT_SIZE) {
+        munmap(shared, sizeof(ShmRingShared));
+        return ERROR;
+    }
+    ring->shared = shared;
+    ring->pid    = pid;
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: shmRingClose
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Unmaps the ring; the creating client also removes the segment. The
+    *  other side keeps its mapping until it closes too. Safe to call on a
+    *  ring that is not mapped.
+ * PARAMETERS:
+    *  ShmRing *ring : Ring to close.
+ * RETURNS : n/a
+ */
+void shmRingClose(ShmRing *ring) {
+    if (!ring->shared) {
+        return;
+    }
+    munmap(ring->shared, sizeof(ShmRingShared));
+    if (ring->owner) {
+        char name[SHM_RING_MAX_NAME];
+        if (shmRingName(name, sizeof(name), ring->pid) == SUCCESS) {
+            shm_unlink(name);
+        }
+    }
+    memset(ring, 0, sizeof(*ring));
+}
+
+/*
+ * FUNCTION: shmRingPush
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Copies a record into the next free slot and publishes it (client
+    *  only). If the ring is full the client polls it SHM_RING_SPINS times,
+    *  then sleeps on the tail futex until the server frees a slot.
+ * PARAMETERS:
+    *  ShmRing *ring : Ring created by shmRingCreate().
+    *  const void *record : Record to send.
+    *  size_t length : Record size, at most SHM_RING_SLOT_SIZE.
+    *  int timeoutMs : Longest wait for a free slot.
+ * RETURNS : ShmRingStatus - SHM_RING_WAKE if the server is asleep and has to be woken.
+ */
+ShmRingStatus shmRingPush(ShmRing *ring, const void *record, size_t length, int timeoutMs) {
+    ShmRingShared *shared = ring->shared;
+    unsigned       head   = atomic_load_explicit(&shared->head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&shared->tail, memory_order_acquire) >= SHM_RING_SLOTS
+        && !shmRingWaitForSlot(shared, head, timeoutMs)) {
+        return SHM_RING_FULL;
+    }
+
+    ShmRingSlot *slot = &shared->slots[head & (SHM_RING_SLOTS - 1)];
+    memcpy(slot->data, record, length);
+    slot->length = (uint32_t)length;
+    // Sequentially consistent so this store and the consumerSleeping load
+    // pair up with the server's store/load in shmRingSleep()
+    atomic_store(&shared->head, head + 1);
+
+    if (atomic_load(&shared->consumerSleeping) && atomic_exchange(&shared->consumerSleeping, 0)) {
+        return SHM_RING_WAKE;
+    }
+    return SHM_RING_PUSHED;
+}
+
+/*
+ * FUNCTION: shmRingPeek
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Returns the oldest unread record (server only). It stays valid and in
+    *  the ring until shmRingRelease().
+ * PARAMETERS:
+    *  ShmRing *ring : Ring mapped by shmRingAttach().
+    *  size_t *length : Set to the record size.
+ * RETURNS : const char * - the record, or NULL if the ring is empty.
+ */
+const char *shmRingPeek(ShmRing *ring, size_t *length) {
+    ShmRingShared *shared = ring->shared;
+    unsigned       tail   = atomic_load_explicit(&shared->tail, memory_order_relaxed);
+    if (atomic_load_explicit(&shared->head, memory_order_acquire) == tail) {
+        return NULL;
+    }
+
+    // The client writes the slot, so its length is not trusted
+    const ShmRingSlot *slot = &shared->slots[tail & (SHM_RING_SLOTS - 1)];
+    *length = slot->length < SHM_RING_SLOT_SIZE ? slot->length : SHM_RING_SLOT_SIZE;
+    return slot->data;
+}
+
+/*
+ * FUNCTION: shmRingRelease
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Frees the record returned by shmRingPeek(). A client waiting for room
+    *  is woken once half the ring is free, so it refills the ring in one go
+    *  instead of sleeping again after every slot.
+ * PARAMETERS:
+    *  ShmRing *ring : Ring mapped by shmRingAttach().
+ * RETURNS : n/a
+ */
+void shmRingRelease(ShmRing *ring) {
+    ShmRingShared *shared = ring->shared;
+    unsigned       tail   = atomic_fetch_add(&shared->tail, 1) + 1;
+    if (atomic_load(&shared->producerSleeping)
+        && atomic_load_explicit(&shared->head, memory_order_relaxed) - tail <= SHM_RING_SLOTS / 2) {
+        syscall(SYS_futex, (uint32_t *)&shared->tail, FUTEX_WAKE, 1, NULL, NULL, 0);
+    }
+}
+
+/*
+ * FUNCTION: shmRingSleep
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Asks the client to ring the doorbell for its next record (server
+    *  only). Fails if a record arrived meanwhile, which must be read first.
+ * PARAMETERS:
+    *  ShmRing *ring : Ring mapped by shmRingAttach().
+ * RETURNS : bool - true if the ring is empty and the server may wait for the doorbell.
+ */
+bool shmRingSleep(ShmRing *ring) {
+    ShmRingShared *shared = ring->shared;
+    atomic_store(&shared->consumerSleeping, 1);
+    if (atomic_load(&shared->head) != atomic_load_explicit(&shared->tail, memory_order_relaxed)) {
+        atomic_store(&shared->consumerSleeping, 0);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * FUNCTION: shmRingName
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Builds the shared memory object name of a client's ring.
+ * PARAMETERS:
+    *  char *out : Buffer for the name.
+    *  size_t outSize : Size of out.
+    *  long pid : Process id of the client.
+ * RETURNS : int - SUCCESS, or ERROR if the name did not fit.
+ */
+static int shmRingName(char *out, size_t outSize, long pid) {
+    int length = snprintf(out, outSize, SHM_RING_NAME_FORMAT, pid);
+    return (length < 0 || (size_t)length >= outSize) ? ERROR : SUCCESS;
+}
+
+/*
+ * FUNCTION: shmRingWaitForSlot
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Waits for the server to free a slot of a full ring: a short spin,
+    *  since the server is usually mid-drain, then futex sleeps on tail
+    *  until the server has emptied half the ring. A wait that times out
+    *  before then still succeeds if the server freed any slot.
+ * PARAMETERS:
+    *  ShmRingShared *shared : Mapped ring.
+    *  unsigned head : Slot the client wants to fill.
+    *  int timeoutMs : Longest wait.
+ * RETURNS : bool - true once a slot is free, false if none was freed before the timeout.
+ */
+static bool shmRingWaitForSlot(ShmRingShared *shared, unsigned head, int timeoutMs) {
+    for (int spin = 0; spin < SHM_RING_SPINS; spin++) {
+        if (head - atomic_load_explicit(&shared->tail, memory_order_acquire) < SHM_RING_SLOTS) {
+            return true;
+        }
+    }
+
+    struct timespec now, deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec  += timeoutMs / 1000;
+    deadline.tv_nsec += (long)(timeoutMs % 1000) * NANOS_PER_MS;
+    if (deadline.tv_nsec >= NANOS_PER_SECOND) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= NANOS_PER_SECOND;
+    }
+
+    bool hasRoom = false;
+    for (;;) {
+        atomic_store(&shared->producerSleeping, 1);
+        unsigned tail = atomic_load(&shared->tail);
+        if ((hasRoom = head - tail <= SHM_RING_SLOTS / 2)) {
+            break;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        struct timespec remaining = {
+            .tv_sec  = deadline.tv_sec - now.tv_sec,
+            .tv_nsec = deadline.tv_nsec - now.tv_nsec,
+        };
+        if (remaining.tv_nsec < 0) {
+            remaining.tv_sec--;
+            remaining.tv_nsec += NANOS_PER_SECOND;
+        }
+        if (remaining.tv_sec < 0) {
+            break;
+        }
+        // Returns at once if tail moved after the load above
+        if (syscall(SYS_futex, (uint32_t *)&shared->tail, FUTEX_WAIT, tail, &remaining, NULL, 0) == -1
+            && errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT) {
+            break;
+        }
+    }
+    atomic_store(&shared->producerSleeping, 0);
+    // Half the ring is only what wakes the client; any free slot is room
+    return hasRoom || head - atomic_load_explicit(&shared->tail, memory_order_acquire) < SHM_RING_SLOTS;
+}
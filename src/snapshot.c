@@ -0,0 +1,276 @@
+/*
+ * FILE: snapshot.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Writes and loads server state snapshots. A snapshot is written to a
+ * temporary file, synced and renamed over the previous one, so a crash
+ * leaves either the old or the new snapshot, never a partial one. Loading
+ * maps the file read-only and rebuilds the state straight from the map.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "journal.h"
+#include "protocol.h"
+#include "snapshot.h"
+
+#define SNAPSHOT_MAX_PATH 256
+
+// Output file with a running checksum and length of the body
+typedef struct SnapshotWriter {
+    FILE    *file;
+    uint32_t checksum;
+    uint64_t length;
+    bool     failed;
+} SnapshotWriter;
+
+static void snapshotPut(SnapshotWriter *writer, const void *data, size_t length);
+static bool snapshotGet(const char **cursor, const char *end, void *out, size_t length);
+static int  snapshotSyncDirectory(const char *path);
+
+/*
+ * FUNCTION: snapshotWrite
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Saves the destinations, their statistics and the open sessions as
+    *  the snapshot at path, replacing the previous snapshot atomically.
+ * PARAMETERS:
+    *  const char *path : Snapshot file.
+    *  uint64_t sequence : Last journal record reflected in the state.
+    *  const DestinationTable *destinations : Interned destinations.
+    *  const AggregateIndex *index : Statistics by destination id.
+    *  const SnapshotSession *sessions : Open sessions.
+    *  size_t sessionCount : Entries in sessions.
+ * RETURNS : int - SUCCESS, or ERROR if the snapshot could not be written (the old one is kept).
+ */
+int snapshotWrite(const char *path, uint64_t sequence, const DestinationTable *destinations,
+                  const AggregateIndex *index, const SnapshotSession *sessions, size_t sessionCount) {
+    char tempPath[SNAPSHOT_MAX_PATH];
+    if (snprintf(tempPath, sizeof(tempPath), "%s%s", path, SNAPSHOT_TEMP_SUFFIX) >= (int)sizeof(tempPath)) {
+        return ERROR;
+    }
+
+    SnapshotWriter writer = { .file = fopen(tempPath, "wb") };
+    if (!writer.file) {
+        return ERROR;
+    }
+
+    SnapshotHeader header = {
+        .version          = SNAPSHOT_VERSION,
+        .headerSize       = SNAPSHOT_HEADER_SIZE,
+        .sequence         = sequence,
+        .destinationCount = destinations->count,
+        .sessionCount     = (uint32_t)sessionCount,
+        .created          = (int64_t)time(NULL),
+    };
+    memcpy(header.magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN);
+    writer.failed = fwrite(&header, sizeof(header), 1, writer.file) != 1;   // Rewritten below
+
+    const DestinationStats none = {0};
+    for (uint32_t id = 0; id < destinations->count; id++) {
+        uint32_t length = destinations->names[id].length;
+        snapshotPut(&writer, &length, sizeof(length));
+        snapshotPut(&writer, destinationName(destinations, id), length);
+        snapshotPut(&writer, id < index->capacity ? &index->entries[id] : &none, sizeof(none));
+    }
+
+    for (size_t i = 0; i < sessionCount; i++) {
+        const PartyBatch     *batch  = sessions[i].batch;
+        SnapshotSessionRecord record = {
+            .pid           = (uint32_t)sessions[i].pid,
+            .inParty       = batch != NULL,
+            .records       = sessions[i].records,
+            .destinationId = batch ? batch->destinationId : PARTY_NO_DESTINATION,
+            .clientCount   = batch ? (uint32_t)batch->count : 0,
+        };
+        snapshotPut(&writer, &record, sizeof(record));
+        for (uint32_t row = 0; row < record.clientCount; row++) {
+            char   frame[WIRE_MAX_CLIENT_FRAME];
+            Client client;
+            partyBatchClient(batch, (int)row, &client);
+            snapshotPut(&writer, frame, wireEncodeClient(frame, sizeof(frame), &client));
+        }
+    }
+
+    header.length   = writer.length;
+    header.checksum = writer.checksum;
+    if (writer.failed || fseek(writer.file, 0, SEEK_SET) != SUCCESS
+        || fwrite(&header, sizeof(header), 1, writer.file) != 1 || fflush(writer.file) != SUCCESS
+        || fsync(fileno(writer.file)) == -1) {
+        fclose(writer.file);
+        unlink(tempPath);
+        return ERROR;
+    }
+    if (fclose(writer.file) != SUCCESS || rename(tempPath, path) == -1) {
+        unlink(tempPath);
+        return ERROR;
+    }
+    return snapshotSyncDirectory(path);
+}
+
+/*
+ * FUNCTION: snapshotLoad
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Maps the snapshot at path and rebuilds the state it holds into empty
+    *  destinations and index, and hands every saved session to claim,
+    *  filling the batch it returns with the session's party. Destinations
+    *  get the same ids they had when the snapshot was written.
+ * PARAMETERS:
+    *  const char *path : Snapshot file; a missing file loads nothing.
+    *  uint64_t *sequence : Receives the last journal record covered (0 if none).
+    *  DestinationTable *destinations : Empty table to fill.
+    *  AggregateIndex *index : Empty index to fill.
+    *  SnapshotClaim claim : Takes a session and returns the batch for its party.
+    *  void *context : Passed to claim.
+ * RETURNS : int - sessions restored, or ERROR if the snapshot is unreadable or corrupt.
+ */
+int snapshotLoad(const char *path, uint64_t *sequence, DestinationTable *destinations,
+                 AggregateIndex *index, SnapshotClaim claim, void *context) {
+    struct stat info;
+    *sequence = 0;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return errno == ENOENT ? 0 : ERROR;
+    }
+    if (fstat(fd, &info) == -1 || (size_t)info.st_size < sizeof(SnapshotHeader)) {
+        close(fd);
+        return ERROR;
+    }
+    size_t size = (size_t)info.st_size;
+    char  *map  = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return ERROR;
+    }
+
+    SnapshotHeader header;
+    memcpy(&header, map, sizeof(header));
+    const char *cursor = map + sizeof(header);
+    const char *end    = map + size;
+    bool        valid  = memcmp(header.magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN) == SUCCESS
+                         && header.version == SNAPSHOT_VERSION
+                         && header.headerSize == SNAPSHOT_HEADER_SIZE
+                         && header.length == size - sizeof(header)
+                         && journalChecksum(cursor, header.length, 0) == header.checksum;
+
+    for (uint32_t id = 0; valid && id < header.destinationCount; id++) {
+        uint32_t         length;
+        DestinationStats stats;
+        valid = snapshotGet(&cursor, end, &length, sizeof(length)) && length < MAX_DESTINATION_LEN
+                && (size_t)(end - cursor) >= length
+                && destinationIntern(destinations, cursor, length) == id;
+        cursor += valid ? length : 0;
+        valid = valid && snapshotGet(&cursor, end, &stats, sizeof(stats));
+
+        DestinationStats *entry = valid ? aggregateEntry(index, id) : NULL;
+        if ((valid = entry != NULL)) {
+            *entry = stats;
+        }
+    }
+
+    for (uint32_t i = 0; valid && i < header.sessionCount; i++) {
+        SnapshotSessionRecord record;
+        PartyBatch           *batch = NULL;
+        valid = snapshotGet(&cursor, end, &record, sizeof(record))
+                && (record.destinationId < header.destinationCount
+                    || record.destinationId == PARTY_NO_DESTINATION)
+                && (record.inParty || record.clientCount == 0)
+                && (batch = claim(context, (long)record.pid, record.records, record.inParty)) != NULL;
+        if (valid) {
+            batch->destinationId = record.destinationId;
+        }
+
+        for (uint32_t row = 0; valid && row < record.clientCount; row++) {
+            WireHeader  frame;
+            const char *payload;
+            Client      client;
+            valid = wireNextFrame(&cursor, end, &frame, &payload) && frame.type == WIRE_CLIENT
+                    && wireDecodeClient(payload, frame.length, &client)
+                    && partyBatchAdd(batch, &client) == SUCCESS;
+        }
+    }
+
+    munmap(map, size);
+    if (!valid || cursor != end) {
+        return ERROR;
+    }
+    *sequence = header.sequence;
+    return (int)header.sessionCount;
+}
+
+/*
+ * FUNCTION: snapshotPut
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Writes bytes to the snapshot body and adds them to its checksum and length.
+ * PARAMETERS:
+    *  SnapshotWriter *writer : Snapshot being written.
+    *  const void *data : Bytes to write.
+    *  size_t length : Number of bytes.
+ * RETURNS : n/a (writer->failed is set on error)
+ */
+static void snapshotPut(SnapshotWriter *writer, const void *data, size_t length) {
+    if (writer->failed || length == 0) {
+        return;
+    }
+    writer->failed   = fwrite(data, 1, length, writer->file) != length;
+    writer->checksum = journalChecksum(data, length, writer->checksum);
+    writer->length  += length;
+}
+
+/*
+ * FUNCTION: snapshotGet
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Copies a fixed-size field out of the mapped snapshot and advances the cursor.
+ * PARAMETERS:
+    *  const char **cursor : Read position.
+    *  const char *end : End of the snapshot.
+    *  void *out : Receives the field.
+    *  size_t length : Field size.
+ * RETURNS : bool - false if the snapshot ends before the field does.
+ */
+static bool snapshotGet(const char **cursor, const char *end, void *out, size_t length) {
+    if ((size_t)(end - *cursor) < length) {
+        return false;
+    }
+    memcpy(out, *cursor, length);
+    *cursor += length;
+    return true;
+}
+
+/*
+ * FUNCTION: snapshotSyncDirectory
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Syncs the directory holding path so a rename into it survives a crash.
+ * PARAMETERS:
+    *  const char *path : File whose directory to sync.
+ * RETURNS : int - SUCCESS, or ERROR if the directory could not be synced.
+ */
+static int snapshotSyncDirectory(const char *path) {
+    char directory[SNAPSHOT_MAX_PATH];
+    snprintf(directory, sizeof(directory), "%s", path);
+    char *slash = strrchr(directory, '/');
+    if (slash) {
+        *slash = '\0';
+    } else {
+        snprintf(directory, sizeof(directory), ".");
+    }
+
+    int fd = open(directory, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1) {
+        return ERROR;
+    }
+    int result = fsync(fd) == -1 ? ERROR : SUCCESS;
+    close(fd);
+    return result;
+}
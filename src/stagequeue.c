@@ -0,0 +1,255 @@
+/*
+ * FILE: stagequeue.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Single-producer, single-consumer queues between pipeline threads.
+ *
+ * head and tail count items since the queue was created; item n lives in
+ * slot n & (capacity - 1). Only the producer stores tail and only the
+ * consumer stores head. Both stores, and the loads a thread makes before
+ * going to sleep, are sequentially consistent, so a thread setting its
+ * sleeping flag either sees the other side's last item (or free slot) or
+ * is seen sleeping and woken.
+*/
+
+#include <stdlib.h>
+
+#include "stagequeue.h"
+
+static bool stageQueueHasRoom(void *queue);
+
+/*
+ * FUNCTION: stageSignalInit
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Prepares a signal for a thread to sleep on.
+ * PARAMETERS:
+    *  StageSignal *signal : Signal to initialise.
+ * RETURNS : int - SUCCESS, or ERROR if the lock or condition could not be created.
+ */
+int stageSignalInit(StageSignal *signal) {
+    atomic_init(&signal->sleeping, false);
+    if (pthread_mutex_init(&signal->lock, NULL) != SUCCESS) {
+        return ERROR;
+    }
+    if (pthread_cond_init(&signal->condition, NULL) != SUCCESS) {
+        pthread_mutex_destroy(&signal->lock);
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: stageSignalDestroy
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Releases a signal nobody sleeps on any more.
+ * PARAMETERS:
+    *  StageSignal *signal : Signal to destroy.
+ * RETURNS : n/a
+ */
+void stageSignalDestroy(StageSignal *signal) {
+    pthread_cond_destroy(&signal->condition);
+    pthread_mutex_destroy(&signal->lock);
+}
+
+/*
+ * FUNCTION: stageSignalWake
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Wakes the thread sleeping on a signal, if any. Costs one atomic load
+    *  while the thread is awake. Call after publishing what it waits for.
+ * PARAMETERS:
+    *  StageSignal *signal : Signal to wake.
+ * RETURNS : n/a
+ */
+void stageSignalWake(StageSignal *signal) {
+    if (atomic_load(&signal->sleeping)) {
+        pthread_mutex_lock(&signal->lock);
+        pthread_cond_signal(&signal->condition);
+        pthread_mutex_unlock(&signal->lock);
+    }
+}
+
+/*
+ * FUNCTION: stageSignalWait
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Sleeps on a signal until ready reports that the thread can go on.
+ * PARAMETERS:
+    *  StageSignal *signal : Signal owned by the calling thread.
+    *  StageReady ready : Checks the condition; must use sequentially consistent loads.
+    *  void *context : Passed to ready.
+ * RETURNS : n/a
+ */
+void stageSignalWait(StageSignal *signal, StageReady ready, void *context) {
+    pthread_mutex_lock(&signal->lock);
+    atomic_store(&signal->sleeping, true);
+    while (!ready(context)) {
+        pthread_cond_wait(&signal->condition, &signal->lock);
+    }
+    atomic_store(&signal->sleeping, false);
+    pthread_mutex_unlock(&signal->lock);
+}
+
+/*
+ * FUNCTION: stageQueueInit
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Allocates an empty queue.
+ * PARAMETERS:
+    *  StageQueue *queue : Queue to initialise.
+    *  size_t capacity : Items the queue holds, a power of two.
+    *  size_t itemSize : Size of one item in bytes.
+    *  StageSignal *consumer : Signal the consumer thread sleeps on, NULL if it polls the queue.
+ * RETURNS : int - SUCCESS, or ERROR if memory could not be allocated.
+ */
+int stageQueueInit(StageQueue *queue, size_t capacity, size_t itemSize, StageSignal *consumer) {
+    queue->itemSize = itemSize;
+    queue->capacity = capacity;
+    queue->consumer = consumer;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    if (!(queue->items = malloc(capacity * itemSize))) {
+        return ERROR;
+    }
+    if (stageSignalInit(&queue->producer) == ERROR) {
+        free(queue->items);
+        queue->items = NULL;
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: stageQueueFree
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Frees a queue both of whose threads are done with it.
+ * PARAMETERS:
+    *  StageQueue *queue : Queue to free; a queue that was never initialised is ignored.
+ * RETURNS : n/a
+ */
+void stageQueueFree(StageQueue *queue) {
+    if (queue->items) {
+        stageSignalDestroy(&queue->producer);
+        free(queue->items);
+        queue->items = NULL;
+    }
+}
+
+/*
+ * FUNCTION: stageQueueReserve
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Producer: returns the next free item to fill in place. Reserving
+    *  again without publishing returns the same item.
+ * PARAMETERS:
+    *  StageQueue *queue : Queue to fill.
+    *  bool wait : Sleep while the queue is full instead of returning NULL.
+ * RETURNS : void * - the item, or NULL if the queue is full and wait is false.
+ */
+void *stageQueueReserve(StageQueue *queue, bool wait) {
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    if (tail - atomic_load_explicit(&queue->head, memory_order_acquire) == queue->capacity) {
+        if (!wait) {
+            return NULL;
+        }
+        stageSignalWait(&queue->producer, stageQueueHasRoom, queue);
+    }
+    return queue->items + (tail & (queue->capacity - 1)) * queue->itemSize;
+}
+
+/*
+ * FUNCTION: stageQueuePublish
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Producer: hands the reserved item to the consumer and wakes it if it sleeps.
+ * PARAMETERS:
+    *  StageQueue *queue : Queue whose reserved item is filled.
+ * RETURNS : n/a
+ */
+void stageQueuePublish(StageQueue *queue) {
+    atomic_store(&queue->tail, atomic_load_explicit(&queue->tail, memory_order_relaxed) + 1);
+    if (queue->consumer) {
+        stageSignalWake(queue->consumer);
+    }
+}
+
+/*
+ * FUNCTION: stageQueuePeek
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Consumer: returns the oldest published item without removing it.
+ * PARAMETERS:
+    *  StageQueue *queue : Queue to read.
+ * RETURNS : void * - the item, or NULL if the queue is empty.
+ */
+void *stageQueuePeek(StageQueue *queue) {
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    if (head == atomic_load_explicit(&queue->tail, memory_order_acquire)) {
+        return NULL;
+    }
+    return queue->items + (head & (queue->capacity - 1)) * queue->itemSize;
+}
+
+/*
+ * FUNCTION: stageQueueRelease
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Consumer: frees the item returned by stageQueuePeek() and wakes a waiting producer.
+ * PARAMETERS:
+    *  StageQueue *queue : Queue read from.
+ * RETURNS : n/a
+ */
+void stageQueueRelease(StageQueue *queue) {
+    atomic_store(&queue->head, atomic_load_explicit(&queue->head, memory_order_relaxed) + 1);
+    stageSignalWake(&queue->producer);
+}
+
+/*
+ * FUNCTION: stageQueueReadable
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: StageReady for a consumer of a single queue: true once an item is published.
+ * PARAMETERS:
+    *  void *queue : StageQueue to check.
+ * RETURNS : bool - true if the queue is not empty.
+ */
+bool stageQueueReadable(void *queue) {
+    StageQueue *stage = queue;
+    return atomic_load(&stage->head) != atomic_load(&stage->tail);
+}
+
+/*
+ * FUNCTION: stageQueueMark
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Producer: counts the items published so far, for stageQueueConsumed().
+ * PARAMETERS:
+    *  StageQueue *queue : Queue filled by the calling thread.
+ * RETURNS : size_t - items published since the queue was created.
+ */
+size_t stageQueueMark(StageQueue *queue) {
+    return atomic_load_explicit(&queue->tail, memory_order_relaxed);
+}
+
+/*
+ * FUNCTION: stageQueueConsumed
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Any thread: tells whether the consumer is done with every item
+    *  published before a mark, so a thread taking over from the producer
+    *  can publish behind them elsewhere without overtaking them.
+ * PARAMETERS:
+    *  StageQueue *queue : Queue to check.
+    *  size_t mark : Result of stageQueueMark().
+ * RETURNS : bool - true once the first mark items were released.
+ */
+bool stageQueueConsumed(StageQueue *queue, size_t mark) {
+    return atomic_load_explicit(&queue->head, memory_order_acquire) >= mark;
+}
+
+/*
+ * FUNCTION: stageQueueHasRoom
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: StageReady for the producer: true once the consumer has freed an item.
+ * PARAMETERS:
+    *  void *queue : StageQueue to check.
+ * RETURNS : bool - true if the queue is not full.
+ */
+static bool stageQueueHasRoom(void *queue) {
+    StageQueue *stage = queue;
+    return atomic_load(&stage->tail) - atomic_load(&stage->head) < stage->capacity;
+}
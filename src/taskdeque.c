@@ -0,0 +1,106 @@
+/*
+ * FILE: taskdeque.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Work-stealing queues of session slots.
+ *
+ * top and bottom count tasks since the deque was created; task n lives in
+ * tasks[n & (capacity - 1)]. The owner never fills a slot more than
+ * capacity tasks ahead of top, so a thief that read a slot which was
+ * refilled since has seen top move and loses its compare-and-swap. The
+ * slots are atomics so that stale read is not a data race.
+*/
+
+#include <stdlib.h>
+
+#include "taskdeque.h"
+
+/*
+ * FUNCTION: taskDequeInit
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Allocates an empty deque.
+ * PARAMETERS:
+    *  TaskDeque *deque : Deque to initialise.
+    *  size_t capacity : Tasks the deque holds, a power of two.
+ * RETURNS : int - SUCCESS, or ERROR if memory could not be allocated.
+ */
+int taskDequeInit(TaskDeque *deque, size_t capacity) {
+    deque->capacity = capacity;
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    if (!(deque->tasks = malloc(capacity * sizeof(*deque->tasks)))) {
+        return ERROR;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&deque->tasks[i], 0);
+    }
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: taskDequeFree
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Frees a deque no thread uses any more.
+ * PARAMETERS:
+    *  TaskDeque *deque : Deque to free; a deque that was never initialised is ignored.
+ * RETURNS : n/a
+ */
+void taskDequeFree(TaskDeque *deque) {
+    free(deque->tasks);
+    deque->tasks = NULL;
+}
+
+/*
+ * FUNCTION: taskDequePush
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Owner: adds a task at the bottom.
+ * PARAMETERS:
+    *  TaskDeque *deque : Deque of the calling thread.
+    *  int task : Task to add.
+ * RETURNS : int - SUCCESS, or ERROR if the deque is full.
+ */
+int taskDequePush(TaskDeque *deque, int task) {
+    size_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    if (bottom - atomic_load(&deque->top) == deque->capacity) {
+        return ERROR;
+    }
+    atomic_store_explicit(&deque->tasks[bottom & (deque->capacity - 1)], task, memory_order_relaxed);
+    atomic_store(&deque->bottom, bottom + 1);
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: taskDequeTake
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Owner or thief: removes the task at the top, retrying while other threads take first.
+ * PARAMETERS:
+    *  TaskDeque *deque : Deque to take from.
+    *  int *task : Receives the task.
+ * RETURNS : bool - true if a task was taken, false if the deque was empty.
+ */
+bool taskDequeTake(TaskDeque *deque, int *task) {
+    size_t top = atomic_load(&deque->top);
+    while (top < atomic_load(&deque->bottom)) {
+        int candidate = atomic_load_explicit(&deque->tasks[top & (deque->capacity - 1)], memory_order_relaxed);
+        if (atomic_compare_exchange_weak(&deque->top, &top, top + 1)) {
+            *task = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * FUNCTION: taskDequeDepth
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Counts the tasks waiting; only a hint while other threads take from the deque.
+ * PARAMETERS:
+    *  TaskDeque *deque : Deque to measure.
+ * RETURNS : size_t - tasks between top and bottom.
+ */
+size_t taskDequeDepth(TaskDeque *deque) {
+    size_t top    = atomic_load(&deque->top);
+    size_t bottom = atomic_load(&deque->bottom);
+    return bottom > top ? bottom - top : 0;
+}
@@ -0,0 +1,289 @@
+/*
+ * FILE: transport.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Opens the stream sockets client sessions can use instead of session
+ * FIFOs: the server's listening sockets and accepted connections, and the
+ * client's connection. What travels over them is up to the caller.
+*/
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "shared.h"
+#include "transport.h"
+
+// Either kind of socket address
+typedef union TransportSockaddr {
+    struct sockaddr    any;
+    struct sockaddr_un local;
+    struct sockaddr_in inet;
+} TransportSockaddr;
+
+static int transportSockaddr(const TransportAddress *address, TransportSockaddr *out, socklen_t *length);
+static int transportClaimPath(const TransportSockaddr *sockaddr, socklen_t length);
+
+/*
+ * FUNCTION: transportIsSocket
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Tells whether sessions over address are socket connections rather than FIFOs.
+ * PARAMETERS:
+    *  const TransportAddress *address : Transport to check.
+ * RETURNS : bool - true for TRANSPORT_UNIX and TRANSPORT_TCP.
+ */
+bool transportIsSocket(const TransportAddress *address) {
+    return address->kind == TRANSPORT_UNIX || address->kind == TRANSPORT_TCP;
+}
+
+/*
+ * FUNCTION: transportParsePort
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Parses a TCP port given on the command line.
+ * PARAMETERS:
+    *  const char *text : Port number.
+    *  uint16_t *port : Receives the port.
+ * RETURNS : int - SUCCESS, or ERROR if text is not a port from 1 to 65535.
+ */
+int transportParsePort(const char *text, uint16_t *port) {
+    char *numEndPtr = NULL;
+    long  value     = strtol(text, &numEndPtr, 10);
+    if (numEndPtr == text || *numEndPtr != '\0' || value <= 0 || value > UINT16_MAX) {
+        return ERROR;
+    }
+    *port = (uint16_t)value;
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: transportListen
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Opens a non-blocking listening socket. A stale unix socket file left
+    *  by a server that did not stop cleanly is replaced, but a live one or
+    *  a path that is not a socket is not (see transportClaimPath()). TCP listens on
+    *  the loopback address only, with SO_REUSEPORT so other server
+    *  processes, each in a directory of its own, can bind the same port.
+ * PARAMETERS:
+    *  const TransportAddress *address : TRANSPORT_UNIX or TRANSPORT_TCP address.
+ * RETURNS : int - the listening socket, or ERROR with errno set.
+ */
+int transportListen(const TransportAddress *address) {
+    TransportSockaddr sockaddr;
+    socklen_t         length;
+    if (transportSockaddr(address, &sockaddr, &length) == ERROR) {
+        return ERROR;
+    }
+
+    int fd = socket(sockaddr.any.sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        return ERROR;
+    }
+    int enable = 1;
+    if (address->kind == TRANSPORT_UNIX) {
+        if (transportClaimPath(&sockaddr, length) == ERROR) {
+            int error = errno;
+            close(fd);
+            errno = error;
+            return ERROR;
+        }
+    } else if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) == -1
+               || setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) == -1) {
+        close(fd);
+        return ERROR;
+    }
+
+    if (bind(fd, &sockaddr.any, length) == -1 || listen(fd, TRANSPORT_LISTEN_BACKLOG) == -1) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return ERROR;
+    }
+    return fd;
+}
+
+/*
+ * FUNCTION: transportAccept
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Accepts one pending connection as a non-blocking socket. Nagle's
+    *  algorithm is turned off on TCP connections: acknowledgements are
+    *  small and the client may be waiting on them.
+ * PARAMETERS:
+    *  int listenFd : Socket from transportListen().
+ * RETURNS : int - the connection, or ERROR with errno set (EAGAIN once none are pending).
+ */
+int transportAccept(int listenFd) {
+    int fd;
+    do {
+        fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    } while (fd == -1 && errno == EINTR);
+    if (fd == -1) {
+        return ERROR;
+    }
+
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));   // Fails harmlessly on unix sockets
+    return fd;
+}
+
+/*
+ * FUNCTION: transportConnect
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Connects to a server socket. While nobody listens (the server is
+    *  starting or restarting) the connect is retried every
+    *  TRANSPORT_RETRY_MS, the way opening the shared FIFO waits for the
+    *  server. Nagle's algorithm is turned off on TCP connections.
+ * PARAMETERS:
+    *  const TransportAddress *address : TRANSPORT_UNIX or TRANSPORT_TCP address.
+    *  int timeoutMs : Longest time to keep retrying.
+ * RETURNS : int - the blocking connected socket, or ERROR with errno set.
+ */
+int transportConnect(const TransportAddress *address, int timeoutMs) {
+    TransportSockaddr sockaddr;
+    socklen_t         length;
+    if (transportSockaddr(address, &sockaddr, &length) == ERROR) {
+        return ERROR;
+    }
+
+    for (int waitedMs = 0;; waitedMs += TRANSPORT_RETRY_MS) {
+        int fd = socket(sockaddr.any.sa_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd == -1) {
+            return ERROR;
+        }
+        int result;
+        do {
+            result = connect(fd, &sockaddr.any, length);
+        } while (result == -1 && errno == EINTR);
+        if (result == SUCCESS) {
+            int enable = 1;
+            if (address->kind == TRANSPORT_TCP) {
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+            }
+            return fd;
+        }
+
+        int error = errno;
+        close(fd);
+        errno = error;
+        if ((error != ECONNREFUSED && error != ENOENT) || waitedMs >= timeoutMs) {
+            return ERROR;
+        }
+        struct timespec pause = { .tv_nsec = TRANSPORT_RETRY_MS * 1000000L };
+        nanosleep(&pause, NULL);
+    }
+}
+
+/*
+ * FUNCTION: transportDescribe
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Formats an address for messages, e.g. "unix socket ./x.sock" or "tcp 127.0.0.1:5000".
+ * PARAMETERS:
+    *  const TransportAddress *address : Address to describe.
+    *  char *out : Receives the description.
+    *  size_t size : Size of out.
+ * RETURNS : n/a
+ */
+void transportDescribe(const TransportAddress *address, char *out, size_t size) {
+    switch (address->kind) {
+        case TRANSPORT_UNIX:
+            snprintf(out, size, "unix socket %s", address->path);
+            break;
+        case TRANSPORT_TCP:
+            snprintf(out, size, "tcp %s:%u", TRANSPORT_LOOPBACK, address->port);
+            break;
+        case TRANSPORT_SHM:
+            snprintf(out, size, "shared memory");
+            break;
+        default:
+            snprintf(out, size, "%s", FIFO_PATH);
+            break;
+    }
+}
+
+/*
+ * FUNCTION: transportSockaddr
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Builds the socket address of a unix or loopback TCP transport.
+ * PARAMETERS:
+    *  const TransportAddress *address : Address to convert.
+    *  TransportSockaddr *out : Receives the socket address.
+    *  socklen_t *length : Receives its length.
+ * RETURNS : int - SUCCESS, or ERROR (EINVAL) for a FIFO transport or a path too long for sun_path.
+ */
+static int transportSockaddr(const TransportAddress *address, TransportSockaddr *out, socklen_t *length) {
+    memset(out, 0, sizeof(*out));
+    if (address->kind == TRANSPORT_UNIX && address->path
+        && strlen(address->path) < sizeof(out->local.sun_path)) {
+        out->local.sun_family = AF_UNIX;
+        strcpy(out->local.sun_path, address->path);
+        *length = sizeof(out->local);
+        return SUCCESS;
+    }
+    if (address->kind == TRANSPORT_TCP) {
+        out->inet.sin_family = AF_INET;
+        out->inet.sin_port   = htons(address->port);
+        inet_pton(AF_INET, TRANSPORT_LOOPBACK, &out->inet.sin_addr);
+        *length = sizeof(out->inet);
+        return SUCCESS;
+    }
+    errno = EINVAL;
+    return ERROR;
+}
+
+/*
+ * FUNCTION: transportClaimPath
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Frees the path of a unix socket address for bind(). Only a socket
+    *  file nobody listens on is removed: a probe connect() refused means
+    *  its server is gone. A path that is not a socket, or a socket that
+    *  accepts the probe (or cannot be probed), belongs to someone else.
+ * PARAMETERS:
+    *  const TransportSockaddr *sockaddr : AF_UNIX address to bind.
+    *  socklen_t length : Length of the address.
+ * RETURNS : int - SUCCESS if the path is free, ERROR with errno set (EADDRINUSE if it is taken).
+ */
+static int transportClaimPath(const TransportSockaddr *sockaddr, socklen_t length) {
+    struct stat info;
+    if (lstat(sockaddr->local.sun_path, &info) == -1) {
+        return errno == ENOENT ? SUCCESS : ERROR;
+    }
+    if (!S_ISSOCK(info.st_mode)) {
+        errno = EADDRINUSE;
+        return ERROR;
+    }
+
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (probe == -1) {
+        return ERROR;
+    }
+    int result;
+    do {
+        result = connect(probe, &sockaddr->any, length);
+    } while (result == -1 && errno == EINTR);
+    bool stale = result == -1 && errno == ECONNREFUSED;
+    close(probe);
+
+    if (!stale) {
+        errno = EADDRINUSE;   // A server is listening, or its backlog is full
+        return ERROR;
+    }
+    if (unlink(sockaddr->local.sun_path) == -1 && errno != ENOENT) {
+        return ERROR;
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,76 @@
+/*
+ * FILE: trip.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Growable client list of a Trip. The clients array lives in the party's
+ * arena and doubles when full, growing in place while it is the newest
+ * allocation. tripReset() empties the list in O(1), so the next party
+ * reuses the same memory without a memset or a free.
+*/
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "shared.h"
+
+/*
+ * FUNCTION: tripInit
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Empties a Trip and attaches the arena its clients are stored in.
+ * PARAMETERS:
+    *  Trip *trip : Trip to initialise.
+    *  Arena *arena : Arena owned by the caller, freed with arenaFree().
+ * RETURNS : n/a
+ */
+void tripInit(Trip *trip, Arena *arena) {
+    memset(trip, 0, sizeof(*trip));
+    trip->arena = arena;
+}
+
+/*
+ * FUNCTION: tripAddClient
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Appends a zeroed client to the party, growing the list when it is full.
+ * PARAMETERS:
+    *  Trip *trip : Trip to add to.
+ * RETURNS : Client * - the new client to fill in, or NULL if memory ran out.
+ */
+Client *tripAddClient(Trip *trip) {
+    if (trip->numberOfClients == trip->clientCapacity) {
+        if (trip->clientCapacity > INT_MAX / 2) {
+            return NULL;
+        }
+        int     capacity = trip->clientCapacity ? trip->clientCapacity * 2 : TRIP_INITIAL_CLIENTS;
+        Client *clients  = arenaGrow(trip->arena, trip->clients,
+                                     sizeof(Client) * (size_t)trip->clientCapacity,
+                                     sizeof(Client) * (size_t)capacity);
+        if (!clients) {
+            return NULL;
+        }
+        trip->clients        = clients;
+        trip->clientCapacity = capacity;
+    }
+
+    Client *client = &trip->clients[trip->numberOfClients++];
+    memset(client, 0, sizeof(*client));
+    return client;
+}
+
+/*
+ * FUNCTION: tripReset
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Forgets the destination and clients and rewinds the arena for the next party.
+ * PARAMETERS:
+    *  Trip *trip : Trip to reset.
+ * RETURNS : n/a
+ */
+void tripReset(Trip *trip) {
+    trip->destination[0]  = '\0';
+    trip->numberOfClients = 0;
+    trip->clientCapacity  = 0;
+    trip->clients         = NULL;
+    arenaReset(trip->arena);
+}
@@ -0,0 +1,134 @@
+/*
+ * FILE: validate.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * Hand-written scanners for client input. The name check is a small DFA
+ * driven by a byte class table, so each input byte costs two table loads
+ * and no data-dependent branches other than the early reject. The age
+ * check is a digit-only parse with an explicit overflow test.
+*/
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "shared.h"
+#include "validate.h"
+
+// Byte classes for the name DFA
+enum {
+    NAME_CLASS_OTHER,
+    NAME_CLASS_UPPER,   // A-Z
+    NAME_CLASS_LOWER,   // a-z
+    NAME_CLASS_SPACE,   // ' '
+    NAME_CLASS_COUNT
+};
+
+// DFA states for "^[A-Z][a-z]* [A-Z][a-z]*$"
+enum {
+    NAME_STATE_START,   // Expecting the first name's capital
+    NAME_STATE_FIRST,   // In the first name
+    NAME_STATE_GAP,     // After the space, expecting the last name's capital
+    NAME_STATE_LAST,    // In the last name (the only accepting state)
+    NAME_STATE_REJECT,
+    NAME_STATE_COUNT
+};
+
+static const uint8_t nameClass[UCHAR_MAX + 1] = {
+    [' '] = NAME_CLASS_SPACE,
+    ['A'] = NAME_CLASS_UPPER, ['B'] = NAME_CLASS_UPPER, ['C'] = NAME_CLASS_UPPER,
+    ['D'] = NAME_CLASS_UPPER, ['E'] = NAME_CLASS_UPPER, ['F'] = NAME_CLASS_UPPER,
+    ['G'] = NAME_CLASS_UPPER, ['H'] = NAME_CLASS_UPPER, ['I'] = NAME_CLASS_UPPER,
+    ['J'] = NAME_CLASS_UPPER, ['K'] = NAME_CLASS_UPPER, ['L'] = NAME_CLASS_UPPER,
+    ['M'] = NAME_CLASS_UPPER, ['N'] = NAME_CLASS_UPPER, ['O'] = NAME_CLASS_UPPER,
+    ['P'] = NAME_CLASS_UPPER, ['Q'] = NAME_CLASS_UPPER, ['R'] = NAME_CLASS_UPPER,
+    ['S'] = NAME_CLASS_UPPER, ['T'] = NAME_CLASS_UPPER, ['U'] = NAME_CLASS_UPPER,
+    ['V'] = NAME_CLASS_UPPER, ['W'] = NAME_CLASS_UPPER, ['X'] = NAME_CLASS_UPPER,
+    ['Y'] = NAME_CLASS_UPPER, ['Z'] = NAME_CLASS_UPPER,
+    ['a'] = NAME_CLASS_LOWER, ['b'] = NAME_CLASS_LOWER, ['c'] = NAME_CLASS_LOWER,
+    ['d'] = NAME_CLASS_LOWER, ['e'] = NAME_CLASS_LOWER, ['f'] = NAME_CLASS_LOWER,
+    ['g'] = NAME_CLASS_LOWER, ['h'] = NAME_CLASS_LOWER, ['i'] = NAME_CLASS_LOWER,
+    ['j'] = NAME_CLASS_LOWER, ['k'] = NAME_CLASS_LOWER, ['l'] = NAME_CLASS_LOWER,
+    ['m'] = NAME_CLASS_LOWER, ['n'] = NAME_CLASS_LOWER, ['o'] = NAME_CLASS_LOWER,
+    ['p'] = NAME_CLASS_LOWER, ['q'] = NAME_CLASS_LOWER, ['r'] = NAME_CLASS_LOWER,
+    ['s'] = NAME_CLASS_LOWER, ['t'] = NAME_CLASS_LOWER, ['u'] = NAME_CLASS_LOWER,
+    ['v'] = NAME_CLASS_LOWER, ['w'] = NAME_CLASS_LOWER, ['x'] = NAME_CLASS_LOWER,
+    ['y'] = NAME_CLASS_LOWER, ['z'] = NAME_CLASS_LOWER,
+};
+
+static const uint8_t nameTransition[NAME_STATE_COUNT][NAME_CLASS_COUNT] = {
+    //                    OTHER              UPPER              LOWER              SPACE
+    [NAME_STATE_START]  = {NAME_STATE_REJECT, NAME_STATE_FIRST,  NAME_STATE_REJECT, NAME_STATE_REJECT},
+    [NAME_STATE_FIRST]  = {NAME_STATE_REJECT, NAME_STATE_REJECT, NAME_STATE_FIRST,  NAME_STATE_GAP},
+    [NAME_STATE_GAP]    = {NAME_STATE_REJECT, NAME_STATE_LAST,   NAME_STATE_REJECT, NAME_STATE_REJECT},
+    [NAME_STATE_LAST]   = {NAME_STATE_REJECT, NAME_STATE_REJECT, NAME_STATE_LAST,   NAME_STATE_REJECT},
+    [NAME_STATE_REJECT] = {NAME_STATE_REJECT, NAME_STATE_REJECT, NAME_STATE_REJECT, NAME_STATE_REJECT},
+};
+
+/*
+ * FUNCTION: scanClientName
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Checks that buffer is "Firstname Lastname" (same language as
+    *  REGEX_NAME) in one pass and records where it splits.
+ * PARAMETERS:
+    *  const char *buffer : Input to check, need not be null-terminated.
+    *  size_t length : Bytes in buffer.
+    *  NameSplit *split : Receives the split offsets when the name is valid.
+ * RETURNS : bool - true if the name is valid.
+ */
+bool scanClientName(const char *buffer, size_t length, NameSplit *split) {
+    const unsigned char *bytes      = (const unsigned char *)buffer;
+    uint8_t              state      = NAME_STATE_START;
+    size_t               spaceIndex = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        uint8_t byteClass = nameClass[bytes[i]];
+        state             = nameTransition[state][byteClass];
+        spaceIndex        = byteClass == NAME_CLASS_SPACE ? i : spaceIndex;
+        if (state == NAME_STATE_REJECT) {
+            return false;
+        }
+    }
+    if (state != NAME_STATE_LAST) {
+        return false;
+    }
+
+    // The DFA admits exactly one space, so spaceIndex is the split point
+    split->firstLength = spaceIndex;
+    split->lastOffset  = spaceIndex + 1;
+    split->lastLength  = length - spaceIndex - 1;
+    return true;
+}
+
+/*
+ * FUNCTION: scanDigits
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Parses a null-terminated string of one or more decimal digits (the
+    *  language of REGEX_NUMBER) into an int, rejecting signs, spaces and
+    *  values that do not fit in an int.
+ * PARAMETERS:
+    *  const char *buffer : Digits to parse.
+    *  int *result : Receives the value.
+ * RETURNS : bool - true if buffer was all digits and fit in an int.
+ */
+bool scanDigits(const char *buffer, int *result) {
+    if (!buffer || !result || *buffer == '\0') {
+        return false;
+    }
+
+    int value = 0;
+    for (const char *cursor = buffer; *cursor != '\0'; cursor++) {
+        unsigned digit = (unsigned)(unsigned char)*cursor - '0';
+        if (digit > 9 || value > (INT_MAX - (int)digit) / 10) {
+            return false;   // Not a digit, or the next step would overflow
+        }
+        value = value * 10 + (int)digit;
+    }
+
+    *result = value;
+    return true;
+}
@@ -0,0 +1,74 @@
+#!/bin/sh
+#
+# FILE: crash_resume.sh
+# PROGRAMMER: Cy Iver Torrefranca
+# PROJECT: SENG2031 - Assignment 1
+# DESCRIPTION:
+# Kills the server with SIGKILL several times while clients import parties,
+# restarting it straight away each time, and checks that once every import
+# has resumed and finished the statistics hold each party exactly once.
+#
+# USAGE: test/crash_resume.sh [importers] [crashes]   (run from the repository root)
+
+IMPORTERS=${1:-4}
+CRASHES=${2:-3}
+ROWS=100000         # Per importer
+PARTY_SIZE=5        # Clients per party
+DESTINATIONS=5      # Parties cycle through Dest0..Dest4
+
+ROOT=$(pwd)
+SERVER="$ROOT/bin/server"
+CLIENT="$ROOT/bin/client"
+WORK=$(mktemp -d /tmp/crash_resume_XXXXXX) || exit 1
+cd "$WORK" || exit 1
+
+fail() {
+    echo "FAIL: $*"
+    kill -9 "$SERVER_PID" 2>/dev/null
+    exit 1
+}
+
+# Every manifest row is valid; consecutive rows of a destination make one party
+awk -v rows=$ROWS -v size=$PARTY_SIZE -v dests=$DESTINATIONS 'BEGIN {
+    print "destination,name,age,address"
+    for (row = 0; row < rows; row++) {
+        printf "Dest%d,Name Last,%d,%d Main St\n", int(row / size) % dests, 20 + row % 50, row
+    }
+}' > manifest.csv
+
+"$SERVER" > server0.out 2>&1 &
+SERVER_PID=$!
+sleep 0.5
+
+IMPORT_PIDS=""
+for i in $(seq 1 "$IMPORTERS"); do
+    "$CLIENT" --import manifest.csv > import$i.out 2>&1 &
+    IMPORT_PIDS="$IMPORT_PIDS $!"
+done
+
+# Crash mid-import and restart at once, so the clients resume their sessions
+for crash in $(seq 1 "$CRASHES"); do
+    sleep 0.$((3 + crash % 4))
+    kill -9 "$SERVER_PID"
+    wait "$SERVER_PID" 2>/dev/null
+    "$SERVER" > server$crash.out 2>&1 &
+    SERVER_PID=$!
+done
+
+for pid in $IMPORT_PIDS; do
+    wait "$pid" || fail "an import did not finish (see $WORK/import*.out)"
+done
+
+PARTIES=$((IMPORTERS * ROWS / PARTY_SIZE / DESTINATIONS))
+CLIENTS=$((PARTIES * PARTY_SIZE))
+"$CLIENT" --query > query.out || fail "query failed"
+for dest in $(seq 0 $((DESTINATIONS - 1))); do
+    line=$(awk -v name="Dest$dest" '$1 == name { print $2, $3 }' query.out)
+    [ "$line" = "$PARTIES $CLIENTS" ] \
+        || fail "Dest$dest has '$line' parties and clients, expected '$PARTIES $CLIENTS'"
+done
+
+kill -INT "$SERVER_PID"
+wait "$SERVER_PID"
+cd "$ROOT" && rm -rf "$WORK"
+echo "PASS: $CRASHES crashes, every destination has $PARTIES parties and $CLIENTS clients"
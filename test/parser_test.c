@@ -0,0 +1,136 @@
+/*
+ * FILE: parser_test.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * parser_test runs the server's record parser on several threads at once,
+ * the way the parser threads share it, and checks that every text client
+ * record decodes to exactly the fields it was built from. Each thread uses
+ * field lengths of its own, so any decoding state shared between threads
+ * shows up as a misparsed record.
+ *
+ * USAGE: parser_test [records per thread]
+*/
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "framer.h"
+#include "parser.h"
+#include "shared.h"
+
+#define TEST_THREADS        4
+#define TEST_DEFAULT_COUNT  500000
+
+typedef struct ParserThread {
+    pthread_t thread;
+    int       index;
+    long      count;
+    long      failures;
+} ParserThread;
+
+bool  buildClient(int thread, long number, Client *client);
+void *runParserThread(void *context);
+
+int main(int argc, char *argv[]) {
+    long count = TEST_DEFAULT_COUNT;
+    if (argc > 1 && (count = strtol(argv[1], NULL, 10)) <= 0) {
+        fprintf(stderr, "Usage: %s [records per thread]\n", argv[0]);
+        return ERROR;
+    }
+
+    ParserThread threads[TEST_THREADS];
+    for (int i = 0; i < TEST_THREADS; i++) {
+        threads[i] = (ParserThread){ .index = i, .count = count };
+        if (pthread_create(&threads[i].thread, NULL, runParserThread, &threads[i]) != SUCCESS) {
+            fprintf(stderr, "Error starting parser thread %d\n", i);
+            return ERROR;
+        }
+    }
+
+    long failures = 0;
+    for (int i = 0; i < TEST_THREADS; i++) {
+        pthread_join(threads[i].thread, NULL);
+        failures += threads[i].failures;
+    }
+    if (failures > 0) {
+        printf("FAIL: %ld of %ld client records misparsed across %d parser threads\n", failures,
+               count * TEST_THREADS, TEST_THREADS);
+        return ERROR;
+    }
+    printf("PASS: %ld client records parsed on %d threads at once\n", count * TEST_THREADS,
+           TEST_THREADS);
+    return SUCCESS;
+}
+
+/*
+ * FUNCTION: buildClient
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Builds the expected client of one record. The names are as long as
+    *  the thread number makes them and the address carries commas of its
+    *  own, so two threads never split a record the same way.
+ * PARAMETERS:
+    *  int thread : Index of the parsing thread.
+    *  long number : Record number within the thread.
+    *  Client *client : Receives the client.
+ * RETURNS : bool - true if the client fits a text record.
+ */
+bool buildClient(int thread, long number, Client *client) {
+    memset(client, 0, sizeof(*client));
+    memset(client->firstName, 'a' + thread, (size_t)(2 + thread * 5));
+    memset(client->lastName, 'A' + thread, (size_t)(3 + thread * 7));
+    client->age = MIN_CLIENT_AGE + (int)(number % (MAX_CLIENT_AGE - MIN_CLIENT_AGE));
+    int length = snprintf(client->address, sizeof(client->address), "%ld Street %d, Unit %d, Town",
+                          number, thread, thread * 3);
+    return length > 0 && (size_t)length < sizeof(client->address);
+}
+
+/*
+ * FUNCTION: runParserThread
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Feeds one thread's text client records through a parser of its own and counts misparsed ones.
+ * PARAMETERS:
+    *  void *context : The thread's ParserThread.
+ * RETURNS : void * - NULL.
+ */
+void *runParserThread(void *context) {
+    ParserThread *self = context;
+    Parser        parser;
+    ParsedRecord *out = malloc(sizeof(*out));
+    if (!out) {
+        self->failures = self->count;
+        return NULL;
+    }
+    parserInit(&parser);
+
+    for (long number = 0; number < self->count; number++) {
+        Client expected;
+        char   line[MAX_BUFFER_SIZE];
+        if (!buildClient(self->index, number, &expected)) {
+            self->failures++;
+            continue;
+        }
+        int length = snprintf(line, sizeof(line), "%s,%s,%d,%s", expected.firstName,
+                              expected.lastName, expected.age, expected.address);
+        RecordView record = { .data = line, .length = (size_t)length, .type = WIRE_TEXT };
+
+        parserFeed(&parser, &record);
+        bool parsed = false;
+        while (parserNext(&parser, out)) {
+            parsed = out->kind == PARSED_TEXT && out->text == PARSED_TEXT_CLIENT
+                     && strcmp(out->client.firstName, expected.firstName) == SUCCESS
+                     && strcmp(out->client.lastName, expected.lastName) == SUCCESS
+                     && out->client.age == expected.age
+                     && strcmp(out->client.address, expected.address) == SUCCESS;
+        }
+        self->failures += parsed ? 0 : 1;
+    }
+
+    parserFree(&parser);
+    free(out);
+    return NULL;
+}
@@ -0,0 +1,261 @@
+/*
+ * FILE: send_alloc_test.c
+ * PROGRAMMER: Cy Iver Torrefranca
+ * PROJECT: SENG2031 - Assignment 1
+ * DESCRIPTION:
+ * send_alloc_test checks that the client's send path does not allocate.
+ * It opens a real FIFO session (clientsession.c) against a minimal server
+ * thread that frames the session with the server's LineFramer and
+ * acknowledges every record, then sends whole parties with sendMessage()
+ * (through writeTextRecord() or writeFrameToFIFOSession() and
+ * writeSessionRecord()) in text and in binary, counting allocations
+ * (bench/countalloc.c) around the sends. The run happens in a scratch
+ * directory, so no real server's FIFO is touched.
+ *
+ * USAGE: send_alloc_test [parties per protocol]
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ackwindow.h"
+#include "clientsession.h"
+#include "countalloc.h"
+#include "framer.h"
+#include "protocol.h"
+#include "shared.h"
+
+#define TEST_DEFAULT_PARTIES 2000
+#define TEST_PARTY_CLIENTS   8
+#define TEST_WARMUP_PARTIES  4   // Sent before counting, so stdio has its buffers
+#define TEST_DIR_TEMPLATE    "/tmp/send_alloc_test_XXXXXX"
+
+// The server end of one session
+typedef struct TestServer {
+    pthread_t thread;
+    uint64_t  records;   // Records acknowledged
+    bool      failed;
+} TestServer;
+
+bool  sendParty(int fd, const Trip *trip);
+long  countSendAllocations(bool textProtocol, long parties, const Trip *trip);
+void *runTestServer(void *context);
+int   acknowledgeSession(TestServer *server, int sessionFd, int replyFd);
+
+int main(int argc, char *argv[]) {
+    long parties = TEST_DEFAULT_PARTIES;
+    if (argc > 1 && (parties = strtol(argv[1], NULL, 10)) <= 0) {
+        fprintf(stderr, "Usage: %s [parties per protocol]\n", argv[0]);
+        return ERROR;
+    }
+
+    char directory[] = TEST_DIR_TEMPLATE;
+    if (!mkdtemp(directory) || chdir(directory) == ERROR || mkfifo(FIFO_PATH, PERM_OWNER_RW) == ERROR) {
+        perror("Error preparing the scratch directory");
+        return ERROR;
+    }
+
+    Client clients[TEST_PARTY_CLIENTS];
+    Trip   trip = { .destination = "Toronto", .clients = clients, .numberOfClients = TEST_PARTY_CLIENTS };
+    for (int i = 0; i < TEST_PARTY_CLIENTS; i++) {
+        clients[i] = (Client){ .age = MIN_CLIENT_AGE + i };
+        snprintf(clients[i].firstName, sizeof(clients[i].firstName), "Client%d", i);
+        snprintf(clients[i].lastName, sizeof(clients[i].lastName), "Smith");
+        snprintf(clients[i].address, sizeof(clients[i].address), "%d King Street West, Apt %d", i + 1, i);
+    }
+
+    int status = SUCCESS;
+    for (int text = 0; text <= 1; text++) {
+        const char *protocol    = text ? "text" : "binary";
+        long        allocations = countSendAllocations(text, parties, &trip);
+        if (allocations != 0) {
+            printf("FAIL: %s send path made %ld allocations for %ld parties\n", protocol, allocations,
+                   parties);
+            status = ERROR;
+        } else {
+            printf("PASS: %s send path sent %ld parties without allocating\n", protocol, parties);
+        }
+    }
+
+    unlink(FIFO_PATH);
+    if (chdir("/") == SUCCESS) {
+        rmdir(directory);
+    }
+    return status;
+}
+
+/*
+ * FUNCTION: sendParty
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Sends one party the way the interactive client does, one message at a time.
+ * PARAMETERS:
+    *  int fd : Session descriptor.
+    *  const Trip *trip : Party to send.
+ * RETURNS : bool - true if every message was sent.
+ */
+bool sendParty(int fd, const Trip *trip) {
+    bool sent = sendMessage(fd, WIRE_PARTY, NULL, NULL) == SUCCESS
+             && sendMessage(fd, WIRE_DEST, trip, NULL) == SUCCESS;
+    for (int i = 0; i < trip->numberOfClients && sent; i++) {
+        sent = sendMessage(fd, WIRE_CLIENT, NULL, &trip->clients[i]) == SUCCESS;
+    }
+    return sent && sendMessage(fd, WIRE_END, NULL, NULL) == SUCCESS;
+}
+
+/*
+ * FUNCTION: countSendAllocations
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Opens a session against a test server, warms it up and counts the
+    *  allocations made while sending the parties. The client's "Sent to
+    *  server" lines go to /dev/null while counting.
+ * PARAMETERS:
+    *  bool textProtocol : Send text lines instead of binary frames.
+    *  long parties : Parties to send while counting.
+    *  const Trip *trip : Party to send.
+ * RETURNS : long - allocations made, or -1 if the session failed.
+ */
+long countSendAllocations(bool textProtocol, long parties, const Trip *trip) {
+    const TransportAddress address = { .kind = TRANSPORT_FIFO };
+    TestServer             server  = {0};
+    if (pthread_create(&server.thread, NULL, runTestServer, &server) != SUCCESS) {
+        return -1;
+    }
+    clientSessionConfigure(textProtocol, &address);
+
+    int  stdoutFd = dup(STDOUT_FILENO);
+    int  nullFd   = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    int  fd       = openFIFOSession(FIFO_PATH, false);
+    bool sent     = fd != ERROR && stdoutFd != -1 && nullFd != -1;
+
+    fflush(stdout);
+    sent = sent && dup2(nullFd, STDOUT_FILENO) != -1;
+    for (long i = 0; i < TEST_WARMUP_PARTIES && sent; i++) {
+        sent = sendParty(fd, trip);
+    }
+    unsigned long before = allocationCount();
+    for (long i = 0; i < parties && sent; i++) {
+        sent = sendParty(fd, trip);
+    }
+    unsigned long allocations = allocationCount() - before;
+    fflush(stdout);
+    if (stdoutFd != -1) {
+        dup2(stdoutFd, STDOUT_FILENO);
+        close(stdoutFd);
+    }
+    if (nullFd != -1) {
+        close(nullFd);
+    }
+
+    closeFIFOSession(&fd);   // Waits for every acknowledgement; the server then sees EOF
+    pthread_join(server.thread, NULL);
+    if (!sent || server.failed) {
+        printf("Error: The %s session failed\n", textProtocol ? "text" : "binary");
+        return -1;
+    }
+    return (long)allocations;
+}
+
+/*
+ * FUNCTION: runTestServer
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION:
+    *  Serves one session as the server does: takes the HELLO from the
+    *  shared FIFO, opens the client's session and reply FIFOs and
+    *  acknowledges records until the client closes the session.
+ * PARAMETERS:
+    *  void *context : The TestServer.
+ * RETURNS : void * - NULL.
+ */
+void *runTestServer(void *context) {
+    TestServer *server = context;
+    char        hello[MAX_BUFFER_SIZE];
+    char        path[MAX_FIFO_PATH_LEN];
+    long        pid = (long)getpid();
+
+    int sharedFd = open(FIFO_PATH, O_RDONLY);
+    if (sharedFd == -1 || read(sharedFd, hello, sizeof(hello)) <= 0) {
+        server->failed = true;
+        if (sharedFd != -1) {
+            close(sharedFd);
+        }
+        return NULL;
+    }
+    close(sharedFd);
+
+    int sessionFd = -1;
+    int replyFd   = -1;
+    if (sessionFifoPath(path, sizeof(path), pid) == ERROR
+        || (sessionFd = open(path, O_RDONLY | O_NONBLOCK)) == -1
+        || replyFifoPath(path, sizeof(path), pid) == ERROR
+        || (replyFd = open(path, O_WRONLY)) == -1
+        || acknowledgeSession(server, sessionFd, replyFd) == ERROR) {
+        server->failed = true;
+    }
+    if (sessionFd != -1) {
+        close(sessionFd);
+    }
+    if (replyFd != -1) {
+        close(replyFd);
+    }
+    return NULL;
+}
+
+/*
+ * FUNCTION: acknowledgeSession
+ * PROGRAMMER: Cy Iver Torrefranca
+ * DESCRIPTION: Frames the session's records and acknowledges them after every read, until EOF.
+ * PARAMETERS:
+    *  TestServer *server : Counts the records.
+    *  int sessionFd : Non-blocking read end of the session FIFO.
+    *  int replyFd : Write end of the reply FIFO.
+ * RETURNS : int - SUCCESS at EOF, ERROR if the session could not be read or acknowledged.
+ */
+int acknowledgeSession(TestServer *server, int sessionFd, int replyFd) {
+    LineFramer framer;
+    if (framerInit(&framer, FRAMER_DEFAULT_CAPACITY) == ERROR) {
+        return ERROR;
+    }
+
+    int status = SUCCESS;
+    for (;;) {
+        struct pollfd input = { .fd = sessionFd, .events = POLLIN };
+        if (poll(&input, 1, ACK_TIMEOUT_MS) <= 0) {
+            status = ERROR;
+            break;
+        }
+        ssize_t bytesRead = framerFill(&framer, sessionFd);
+        if (bytesRead == 0) {
+            break;   // The client closed the session
+        }
+        if (bytesRead < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                continue;
+            }
+            status = ERROR;
+            break;
+        }
+
+        RecordView record;
+        while (framerNext(&framer, &record)) {
+            server->records++;
+        }
+        char    ack[ACK_FRAME_SIZE];
+        WireAck acked  = { .records = server->records };
+        size_t  length = wireEncodeAck(ack, sizeof(ack), &acked);
+        if (write(replyFd, ack, length) != (ssize_t)length) {
+            status = ERROR;
+            break;
+        }
+    }
+    framerFree(&framer);
+    return status;
+}
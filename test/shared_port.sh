@@ -0,0 +1,99 @@
+#!/bin/sh
+#
+# FILE: shared_port.sh
+# PROGRAMMER: Cy Iver Torrefranca
+# PROJECT: SENG2031 - Assignment 1
+# DESCRIPTION:
+# Runs two servers on one --tcp port (SO_REUSEPORT). A second server started
+# in a directory that already has one must refuse to start and leave the
+# first running; servers in directories of their own share the port, and
+# once clients have imported parties through it the two sets of statistics
+# add up to every party exactly once, before and after a restart.
+#
+# USAGE: test/shared_port.sh [importers]   (run from the repository root)
+
+IMPORTERS=${1:-8}
+ROWS=2000           # Per importer
+PARTY_SIZE=5        # Clients per party
+DESTINATIONS=5      # Parties cycle through Dest0..Dest4
+PORT=$((20000 + $$ % 20000))
+
+ROOT=$(pwd)
+SERVER="$ROOT/bin/server"
+CLIENT="$ROOT/bin/client"
+WORK=$(mktemp -d /tmp/shared_port_XXXXXX) || exit 1
+mkdir "$WORK/a" "$WORK/b" || exit 1
+cd "$WORK" || exit 1
+
+fail() {
+    echo "FAIL: $*"
+    kill -9 "$PID_A" "$PID_B" 2>/dev/null
+    exit 1
+}
+
+# Starts a server in directory $1 on the shared port; its pid goes in SERVER_PID
+start_server() {
+    (cd "$1" && exec "$SERVER" --tcp "$PORT" --output quiet > "server$2.out" 2>&1) &
+    SERVER_PID=$!
+    sleep 0.5
+}
+
+# Adds up the parties and clients of one destination over both servers
+check_totals() {
+    for dir in a b; do
+        (cd "$dir" && "$CLIENT" --query > query.out) || fail "query to server $dir failed"
+    done
+    for dest in $(seq 0 $((DESTINATIONS - 1))); do
+        line=$(awk -v name="Dest$dest" '$1 == name { parties += $2; clients += $3 }
+                                        END { print parties + 0, clients + 0 }' a/query.out b/query.out)
+        [ "$line" = "$PARTIES $CLIENTS" ] \
+            || fail "Dest$dest has '$line' parties and clients $1, expected '$PARTIES $CLIENTS'"
+    done
+}
+
+awk -v rows=$ROWS -v size=$PARTY_SIZE -v dests=$DESTINATIONS 'BEGIN {
+    print "destination,name,age,address"
+    for (row = 0; row < rows; row++) {
+        printf "Dest%d,Name Last,%d,%d Main St\n", int(row / size) % dests, 20 + row % 50, row
+    }
+}' > manifest.csv
+
+start_server a 1
+PID_A=$SERVER_PID
+
+# Same directory: must refuse to start, and must not disturb the first server
+start_server a 2
+kill -0 "$SERVER_PID" 2>/dev/null && fail "a second server started in the same directory"
+grep -q "Another server is already running" a/server2.out || fail "the second server did not say why it stopped"
+kill -0 "$PID_A" 2>/dev/null || fail "the first server stopped"
+
+start_server b 1
+PID_B=$SERVER_PID
+kill -0 "$PID_B" 2>/dev/null || fail "a server in its own directory did not start (see $WORK/b/server1.out)"
+
+IMPORT_PIDS=""
+for i in $(seq 1 "$IMPORTERS"); do
+    "$CLIENT" --tcp "$PORT" --import manifest.csv > import$i.out 2>&1 &
+    IMPORT_PIDS="$IMPORT_PIDS $!"
+done
+for pid in $IMPORT_PIDS; do
+    wait "$pid" || fail "an import did not finish (see $WORK/import*.out)"
+done
+
+PARTIES=$((IMPORTERS * ROWS / PARTY_SIZE / DESTINATIONS))
+CLIENTS=$((PARTIES * PARTY_SIZE))
+check_totals "across both servers"
+
+# Each server recovers only its own journal and snapshot
+kill -INT "$PID_A" "$PID_B"
+wait "$PID_A" "$PID_B"
+start_server a 3
+PID_A=$SERVER_PID
+start_server b 3
+PID_B=$SERVER_PID
+check_totals "after a restart"
+
+kill -INT "$PID_A" "$PID_B"
+wait "$PID_A" "$PID_B"
+cd "$ROOT" && rm -rf "$WORK"
+echo "PASS: two servers shared port $PORT, every destination has $PARTIES parties and $CLIENTS clients"